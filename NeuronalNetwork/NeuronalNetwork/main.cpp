@@ -7,11 +7,33 @@
 
 #include <iostream>
 #include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
 #include <vector>
 
+#include <unistd.h>
+
+#include <../libengine/FastMath.hpp>
 #include <../libengine/PythonWrapper.h>
+#include <../libengine/StaticNetwork.hpp>
 
 void pythonExecFunc();
+void fastMathFunc();
+void staticNetworkFunc();
+void multiRateFunc();
+const bool reorderFunc();
+void profileFunc();
+const bool writerFunc();
+void couplingFunc();
+void cableFunc();
+const bool settingsFunc();
+const bool partitionFunc();
+void adaptiveFunc();
+void statisticsFunc();
+void telemetryFunc();
+const bool staticLoadFunc();
+const bool forkFunc();
 
 int main(int argc, const char * argv[]) {
 	
@@ -19,8 +41,30 @@ int main(int argc, const char * argv[]) {
 	std::cout << sizeof(NeuronalNetwork) << "\n";
 	
 //	pythonExecFunc();
+	// the equivalence checks count their failures, a failing check gives a non-zero exit status
+	int failures = 0;
+	
+	fastMathFunc();
+	staticNetworkFunc();
+	multiRateFunc();
+	failures += !reorderFunc();
+	profileFunc();
+	failures += !writerFunc();
+	couplingFunc();
+	cableFunc();
+	failures += !settingsFunc();
+	failures += !partitionFunc();
+	adaptiveFunc();
+	statisticsFunc();
+	telemetryFunc();
+	failures += !staticLoadFunc();
+	failures += !forkFunc();
+	
+	if (failures) {
+		std::cout << failures << " equivalence checks failed\n";
+	}
 
-	return 0;
+	return failures ? 1 : 0;
 }
 
 void pythonExecFunc()
@@ -35,6 +79,798 @@ void pythonExecFunc()
 	std::system("python3 /Users/fricker/Documents/GitHub/NeuronalNetworkModel/NeuronalNetwork/NeuronalNetwork/test.py");
 }
 
+void fastMathFunc()
+{
+	/*
+		compares FastMath::Exp against libm over the arguments of the
+		Hodgkin-Huxley rate functions in the physiological Vm range [-100, 60] mV
+	*/
+	const int n = 1 << 20;
+	std::vector<double> x(n), fast(n), libm(n);
+	
+	for (int i = 0; i < n; i++) {
+		const double Vm = -100.0 + 160.0 * i / (n - 1);
+		// arguments of αm, βm, αh, βh, αn, βn and neighbor current, cycled
+		const double args[] = {-(Vm + 40.0) / 10.0, -(Vm + 64.0) / 18.0, -(Vm + 65.0) / 20.0, -(Vm + 35.0) / 10.0, -(Vm + 55.0) / 10.0, -(Vm + 65.0) / 80.0, -Vm / -64.9964};
+		x[i] = args[i % 7];
+	}
+	
+	// best of several passes, a single pass over 8 MB arrays is dominated by noise
+	std::chrono::duration<double> fast_seconds = std::chrono::duration<double>::max();
+	std::chrono::duration<double> libm_seconds = std::chrono::duration<double>::max();
+	for (int pass = 0; pass < 5; pass++) {
+		std::chrono::time_point<std::chrono::system_clock> start = std::chrono::system_clock::now();
+		FastMath::Exp(x.data(), fast.data(), n);
+		fast_seconds = std::min(fast_seconds, std::chrono::duration<double>(std::chrono::system_clock::now() - start));
+		
+		start = std::chrono::system_clock::now();
+		for (int i = 0; i < n; i++) {
+			libm[i] = exp(x[i]);
+		}
+		libm_seconds = std::min(libm_seconds, std::chrono::duration<double>(std::chrono::system_clock::now() - start));
+	}
+	
+	double max_error = 0;
+	for (int i = 0; i < n; i++) {
+		max_error = std::max(max_error, std::fabs(fast[i] - libm[i]) / libm[i]);
+	}
+	
+	std::cout << "FastMath::Exp max relative error: " << max_error << ", " << fast_seconds.count() << "s vs libm " << libm_seconds.count() << "s\n";
+}
+
+void staticNetworkFunc()
+{
+	/*
+		times the compile-time specialized default topology of MyNN per bin
+	*/
+	const int bins = 10000;
+	StaticNetwork<16, 4, 1> network;
+	
+	std::chrono::time_point<std::chrono::system_clock> start = std::chrono::system_clock::now();
+	network.Step(bins);
+	std::chrono::duration<double> seconds = std::chrono::system_clock::now() - start;
+	
+	size_t spikes = 0;
+	for (int i = 0; i < StaticNetwork<16, 4, 1>::s_neurons_; i++) {
+		spikes += network.GetSpikes(i);
+	}
+	
+	std::cout << "StaticNetwork<16, 4, 1>: " << seconds.count() / bins * 1e6 << "us per bin, " << spikes << " spikes\n";
+}
+
+void multiRateFunc()
+{
+	/*
+		compares the multi-rate integration, slow gates every k bins, against the single rate path
+		on the default topology: rms and largest membrane potential error, spikes and run time
+		the largest error is set by spikes shifted by a bin, the rms error by the drift in between
+		then the same for the batched kernels of a larger StaticNetwork
+	*/
+	const int bins = 10000;
+	int layers[] = {16, 4, 1};
+	const int neurons = 21;
+	std::vector<double> reference;
+	
+	for (int k : {1, 2, 4, 8}) {
+		set_multirate(k);
+		
+		// same random currents for every k
+		srand(1);
+		void* network = create(0.451, 0.01, bins, layers, 3);
+		
+		std::chrono::time_point<std::chrono::system_clock> start = std::chrono::system_clock::now();
+		step(network, bins);
+		std::chrono::duration<double> seconds = std::chrono::system_clock::now() - start;
+		
+		const double* trace = history(network);
+		
+		if (k == 1) {
+			reference.assign(trace, trace + (size_t)neurons * bins);
+		}
+		
+		double max_error = 0;
+		double squares = 0;
+		int spikes = 0;
+		for (int i = 0; i < neurons * bins; i++) {
+			max_error = std::max(max_error, std::fabs(trace[i] - reference[i]));
+			squares += (trace[i] - reference[i]) * (trace[i] - reference[i]);
+			// upstrokes through the threshold
+			spikes += (i % bins > 0 && trace[i - 1] < -55.0 && trace[i] >= -55.0);
+		}
+		
+		std::cout << "multi-rate k = " << k << ": rms error " << sqrt(squares / (neurons * bins)) << "mV, max error " << max_error << "mV, " << spikes << " spikes, " << seconds.count() << "s\n";
+		
+		destroy(network);
+	}
+	
+	// adaptive sub-steps update every gate together, either order is rejected
+	const bool adaptive = set_tolerance(0.01) == 0;
+	set_multirate(1);
+	set_tolerance(0.01);
+	const bool multirate = set_multirate(2) == 0;
+	set_tolerance(0);
+	
+	std::cout << "multi-rate rejected with adaptive integration: " << adaptive << " " << multirate << "\n";
+	
+	// the batched kernels are not hidden behind the thread synchronization of every bin
+	typedef StaticNetwork<256, 64, 16> Batched;
+	std::vector<double> trace((size_t)bins * Batched::s_neurons_);
+	
+	for (int k : {1, 2, 4, 8}) {
+		Batched batched(0.451, 0.01, k);
+		
+		// same random currents for every k
+		srand(1);
+		for (int i = 0; i < Batched::s_neurons_; i++) {
+			batched.SetOutputCurrent(i, 0.02 + 0.02 * rand() / RAND_MAX);
+			batched.SetNeighboringInfluence(i, 0.002 + 0.002 * rand() / RAND_MAX);
+			batched.InjectCurrent(i, 2.0 * rand() / RAND_MAX);
+		}
+		
+		std::chrono::time_point<std::chrono::system_clock> start = std::chrono::system_clock::now();
+		batched.Step(bins, trace.data());
+		std::chrono::duration<double> seconds = std::chrono::system_clock::now() - start;
+		
+		if (k == 1) {
+			reference = trace;
+		}
+		
+		double squares = 0;
+		for (size_t i = 0; i < trace.size(); i++) {
+			squares += (trace[i] - reference[i]) * (trace[i] - reference[i]);
+		}
+		
+		std::cout << "batched multi-rate k = " << k << ": rms error " << sqrt(squares / trace.size()) << "mV, " << seconds.count() << "s\n";
+	}
+}
+
+const bool reorderFunc()
+{
+	/*
+		runs the default topology with and without renumbering the neurons along their edges
+		the histories are returned in id order, spikes are delivered in id order whatever the positions,
+		the membrane potentials have to be identical, returns false otherwise
+	*/
+	const int bins = 10000;
+	int layers[] = {16, 4, 1};
+	const int neurons = 21;
+	std::vector<double> reference;
+	bool identical = true;
+	
+	for (int reordering : {0, 1}) {
+		set_reordering(reordering);
+		
+		// same random currents for both orders
+		srand(1);
+		void* network = create(0.451, 0.01, bins, layers, 3);
+		
+		std::chrono::time_point<std::chrono::system_clock> start = std::chrono::system_clock::now();
+		step(network, bins);
+		std::chrono::duration<double> seconds = std::chrono::system_clock::now() - start;
+		
+		const double* trace = history(network);
+		
+		if (reordering == 0) {
+			reference.assign(trace, trace + (size_t)neurons * bins);
+		}
+		
+		double max_error = 0;
+		for (int i = 0; i < neurons * bins; i++) {
+			max_error = std::max(max_error, std::fabs(trace[i] - reference[i]));
+		}
+		
+		std::cout << "reordering " << reordering << ": max difference " << max_error << "mV, " << seconds.count() << "s\n";
+		identical = identical && max_error == 0;
+		
+		destroy(network);
+	}
+	
+	set_reordering(0);
+	
+	if (!identical) {
+		std::cout << "reordering: check failed\n";
+	}
+	return identical;
+}
+
+void profileFunc()
+{
+	/*
+		profiles the default topology per phase, the run summary is printed by the network
+		then reads the counts back through the C API
+	*/
+	const int bins = 10000;
+	int layers[] = {16, 4, 1};
+	const char* names[] = {"drive", "integrate", "exchange", "learn", "publish", "reduce", "archive"};
+	
+	set_profiling(1);
+	
+	void* network = create(0.451, 0.01, bins, layers, 3);
+	step(network, bins);
+	
+	const double* counts = profile(network);
+	
+	for (int i = 0; i < 7; i++) {
+		if (counts[5 * i + 0] > 0) {
+			std::cout << "profile " << names[i] << ": " << counts[5 * i + 0] << "s, IPC " << ((counts[5 * i + 1] > 0) ? counts[5 * i + 2] / counts[5 * i + 1] : 0) << "\n";
+		}
+	}
+	
+	destroy(network);
+	
+	set_profiling(0);
+}
+
+const bool writerFunc()
+{
+	/*
+		streams the recorded membrane potentials of the default topology to a temporary file while stepping
+		compares the stepping time and the file against a run kept in memory, the file is removed
+		returns false if the file misses bins or differs from the run kept in memory
+	*/
+	const int bins = 10000;
+	const int size = 21;
+	int layers[] = {16, 4, 1};
+	
+	char path[] = "/tmp/tracesXXXXXX";
+	const int fd = mkstemp(path);
+	if (fd < 0) {
+		std::cout << "streaming: temporary file creation error\n";
+		return false;
+	}
+	close(fd);
+	
+	std::vector<double> memory;
+	
+	for (int streamed = 0; streamed < 2; streamed++) {
+		// same random currents in both runs
+		srand(1);
+		void* network = create(0.451, 0.01, bins, layers, 3);
+		void* writer = streamed ? writer_create(path) : nullptr;
+		stream(network, writer);
+		
+		std::chrono::time_point<std::chrono::system_clock> start = std::chrono::system_clock::now();
+		for (int i = 0; i < bins; i += 100) {
+			step(network, 100);
+		}
+		stream_flush(network);
+		std::chrono::duration<double> seconds = std::chrono::system_clock::now() - start;
+		
+		std::cout << "streaming " << streamed << ": " << seconds.count() << "s, " << (writer ? writer_bytes(writer) : 0) << " bytes, " << (writer ? writer_stalls(writer) : 0) << " stalls\n";
+		
+		if (!streamed) {
+			const double* trace = history(network);
+			memory.assign(trace, trace + (size_t)size * bins);
+		}
+		
+		destroy(network);
+		if (writer) {
+			writer_destroy(writer);
+		}
+	}
+	
+	// records of (neuron, first bin, count) followed by count samples
+	std::vector<double> file((size_t)size * bins, NAN);
+	FILE* input = fopen(path, "rb");
+	int32_t record[3];
+	
+	while (input && fread(record, sizeof(record), 1, input) == 1) {
+		std::vector<double> samples(record[2]);
+		if (fread(samples.data(), sizeof(double), record[2], input) != record[2]) {
+			break;
+		}
+		for (int k = 0; k < record[2] && record[1] + k < bins; k++) {
+			file[(size_t)record[0] * bins + record[1] + k] = samples[k];
+		}
+	}
+	
+	if (input) {
+		fclose(input);
+	}
+	std::remove(path);
+	
+	double difference = 0;
+	int missing = 0;
+	for (size_t i = 0; i < file.size(); i++) {
+		if (std::isnan(file[i])) {
+			missing++;
+		} else {
+			difference = std::max(difference, std::fabs(file[i] - memory[i]));
+		}
+	}
+	
+	std::cout << "streamed file: max difference " << difference << "mV, " << missing << " bins missing\n";
+	
+	if (difference != 0 || missing) {
+		std::cout << "streamed file: check failed\n";
+		return false;
+	}
+	return true;
+}
+
+void couplingFunc()
+{
+	/*
+		strongly coupled layer of 32 neurons over 50 ms, explicit and implicit neighbor currents at 1x, 5x and 10x
+		the default time step against the explicit update at 0.0005 ms, as a StaticNetwork coupled all-to-all
+		and as a network coupled forward as MyNN wires its layers
+		the time step alone costs the error of the uncoupled layer, the implicit update has to stay within 0.5 mV of it
+		implicit coupling is rejected together with multi-rate and adaptive integration
+	*/
+	const int size = 32;
+	const double duration = 50.0;
+	const double tolerance = 0.5;
+	
+	// membrane potentials every 0.1 ms
+	auto sample = [&](const double* history, const int bins, const size_t neuron_stride, const size_t bin_stride, const double dt) {
+		const int every = (int)std::lround(0.1 / dt);
+		std::vector<double> samples;
+		
+		for (int b = every - 1; b < bins; b += every) {
+			for (int i = 0; i < size; i++) {
+				samples.push_back(history[i * neuron_stride + b * bin_stride]);
+			}
+		}
+		
+		return samples;
+	};
+	
+	auto run_static = [&](const double dt, const bool implicit, const double nc) {
+		StaticNetwork<size> network(0.451, dt);
+		network.SetImplicitCoupling(implicit);
+		
+		for (int i = 0; i < size; i++) {
+			network.SetNeighboringInfluence(i, nc);
+			// spread the neurons apart before the first bin
+			network.InjectCurrent(i, -0.5 * (i % 4));
+		}
+		
+		const int bins = (int)std::lround(duration / dt);
+		std::vector<double> history((size_t)bins * size);
+		network.Step(bins, history.data());
+		
+		return sample(history.data(), bins, 1, size, dt);
+	};
+	
+	auto run_network = [&](const double dt, const bool implicit, const double nc) {
+		int layers[] = {size};
+		const int bins = (int)std::lround(duration / dt);
+		
+		set_implicit_coupling(implicit);
+		srand(1);
+		void* network = create(0.451, dt, bins, layers, 1);
+		set_implicit_coupling(0);
+		
+		neurons_t& neurons = reinterpret_cast<NeuronalNetwork*>(network)->GetNeurons();
+		for (int i = 0; i < size; i++) {
+			neurons[i].SetNeighboringInfluence(nc);
+			// spread the neurons apart before the first bin
+			inject(network, i, -0.5 * (i % 4));
+		}
+		
+		step(network, bins);
+		std::vector<double> samples = sample(history(network), bins, bins, 1, dt);
+		destroy(network);
+		
+		return samples;
+	};
+	
+	auto error = [](const std::vector<double>& samples, const std::vector<double>& reference) {
+		double sum = 0;
+		for (size_t i = 0; i < samples.size(); i++) {
+			sum += (samples[i] - reference[i]) * (samples[i] - reference[i]);
+		}
+		return sqrt(sum / samples.size());
+	};
+	
+	auto compare = [&](const char* name, auto run) {
+		const std::vector<double> reference = run(0.0005, false, 0.1);
+		const std::vector<double> uncoupled_reference = run(0.0005, false, 0.0);
+		
+		for (const double dt : {0.01, 0.05, 0.1}) {
+			const double uncoupled = error(run(dt, false, 0.0), uncoupled_reference);
+			const double explicit_error = error(run(dt, false, 0.1), reference);
+			const double implicit_error = error(run(dt, true, 0.1), reference);
+			
+			std::cout << "coupling " << name << " dt = " << dt << "ms: rms error uncoupled " << uncoupled << "mV, explicit " << explicit_error << "mV, implicit " << implicit_error << "mV, implicit within " << tolerance << "mV of uncoupled: " << (implicit_error <= uncoupled + tolerance ? "yes" : "no") << "\n";
+		}
+	};
+	
+	compare("StaticNetwork all-to-all", run_static);
+	compare("network forward", run_network);
+	
+	// both orders of the settings are rejected
+	set_implicit_coupling(1);
+	const bool rejected = !set_multirate(2) && !set_tolerance(0.01);
+	set_implicit_coupling(0);
+	set_multirate(2);
+	const bool rejected_multirate = !set_implicit_coupling(1);
+	set_multirate(1);
+	
+	std::cout << "implicit coupling with multi-rate or adaptive integration rejected: " << (rejected && rejected_multirate ? "yes" : "no") << "\n";
+}
+
+void cableFunc()
+{
+	/*
+		1024 ball and stick cells of 61 compartments over 100 ms with a constant current into the soma
+	*/
+	const int cells = 1024;
+	const int bins = 10000;
+	// soma, 4 dendrites of 10 segments and 20 axon compartments
+	const int compartments = 1 + 4 * 10 + 20;
+	
+	void* cable = cable_create(cells);
+	
+	for (int c = 0; c < cells; c++) {
+		cable_current(cable, c, 0, 1.0);
+	}
+	
+	auto start = std::chrono::high_resolution_clock::now();
+	cable_step(cable, bins);
+	auto stop = std::chrono::high_resolution_clock::now();
+	
+	const double seconds = std::chrono::duration<double>(stop - start).count();
+	const double updates = (double)cells * compartments * bins;
+	
+	std::cout << "cable " << updates / seconds * 1e-6 << "M compartment updates/s, " << cable_spikes(cable, 0) << " spikes at the axon end\n";
+	
+	cable_destroy(cable);
+}
+
+const bool settingsFunc()
+{
+	/*
+		two persistent networks with their own current clamp, time step and number of bins, stepped alternately
+		each has to reproduce the same network run alone, returns false otherwise
+	*/
+	const int bins = 2000;
+	int layers[] = {16, 4, 1};
+	const int neurons = 21;
+	
+	auto alone = [&](const double x, const double dt, const unsigned int seed) {
+		srand(seed);
+		void* network = create(x, dt, bins, layers, 3);
+		step(network, bins);
+		const double* trace = history(network);
+		std::vector<double> samples(trace, trace + (size_t)neurons * bins);
+		destroy(network);
+		return samples;
+	};
+	
+	const std::vector<double> references[] = {alone(0.451, 0.01, 1), alone(0.3, 0.05, 2)};
+	
+	srand(1);
+	void* first = create(0.451, 0.01, bins, layers, 3);
+	srand(2);
+	void* second = create(0.3, 0.05, bins, layers, 3);
+	
+	for (int i = 0; i < bins; i += 100) {
+		step(first, 100);
+		step(second, 100);
+	}
+	
+	void* networks[] = {first, second};
+	double differences[] = {0, 0};
+	
+	for (int k = 0; k < 2; k++) {
+		const double* trace = history(networks[k]);
+		for (int i = 0; i < neurons * bins; i++) {
+			differences[k] = std::max(differences[k], std::fabs(trace[i] - references[k][i]));
+		}
+		destroy(networks[k]);
+	}
+	
+	std::cout << "per network settings: max difference " << differences[0] << "mV at dt = 0.01ms, " << differences[1] << "mV at dt = 0.05ms\n";
+	
+	if (differences[0] != 0 || differences[1] != 0) {
+		std::cout << "per network settings: check failed\n";
+		return false;
+	}
+	return true;
+}
+
+const bool partitionFunc()
+{
+	/*
+		runs the same network in one process and partitioned over 2 and 4 processes
+		the membrane potentials have to be identical, every process stores fewer neurons than the network
+		returns false otherwise
+	*/
+	const int bins = 2000;
+	int layers[] = {8, 48, 16, 1};
+	const int neurons = 73;
+	
+	srand(1);
+	void* network = create(0.451, 0.01, bins, layers, 4);
+	step(network, bins);
+	const double* trace = history(network);
+	const std::vector<double> reference(trace, trace + (size_t)neurons * bins);
+	destroy(network);
+	
+	bool identical = true;
+	
+	for (int processes : {2, 4}) {
+		std::vector<int> stored(processes, 0);
+		
+		srand(1);
+		const double* voltages = run_partitioned(0.451, 0.01, bins, layers, 4, processes, stored.data());
+		
+		double max_error = 0;
+		for (int i = 0; i < neurons * bins; i++) {
+			max_error = std::max(max_error, std::fabs(voltages[i] - reference[i]));
+		}
+		
+		std::cout << "partitioned over " << processes << " processes: max difference " << max_error << "mV, neurons stored";
+		for (int r = 0; r < processes; r++) {
+			std::cout << " " << stored[r];
+			identical = identical && stored[r] < neurons;
+		}
+		std::cout << " of " << neurons << "\n";
+		identical = identical && max_error == 0;
+	}
+	
+	if (!identical) {
+		std::cout << "partitioning: check failed\n";
+	}
+	return identical;
+}
+
+void adaptiveFunc()
+{
+	/*
+		default topology over 100 ms driven by 1 ms pulses every 25 ms with transmission delays of 1 ms
+		integrated with one fixed step per bin and with adaptive sub-steps spanning the quiescent bins
+		errors against an adaptive run at 1e-6 mV, the cost in Hodgkin-Huxley updates at bins of 0.01 and 0.05 ms
+	*/
+	int layers[] = {16, 4, 1};
+	const int neurons = 21;
+	
+	for (const double dt : {0.01, 0.05}) {
+		const int bins = (int)lround(100 / dt);
+		const int delay = (int)lround(1 / dt);
+		set_delays(delay, delay);
+		
+		auto run = [&](const double tolerance, long long& count) {
+			set_tolerance(tolerance);
+			srand(1);
+			void* network = create(0.451, dt, bins, layers, 3);
+			stimulate_pulses(network, 0, 16, 1.0, 0, (int)lround(25 / dt), delay);
+			step(network, bins);
+			const double* trace = history(network);
+			std::vector<double> samples(trace, trace + (size_t)neurons * bins);
+			count = updates(network);
+			destroy(network);
+			return samples;
+		};
+		
+		long long count = 0;
+		const std::vector<double> reference = run(1e-6, count);
+		
+		for (const double tolerance : {0.0, 1e-4, 1e-3, 1e-2, 1e-1}) {
+			const std::vector<double> samples = run(tolerance, count);
+			
+			double squares = 0;
+			for (size_t i = 0; i < samples.size(); i++) {
+				squares += (samples[i] - reference[i]) * (samples[i] - reference[i]);
+			}
+			
+			std::cout << "bins of " << dt << "ms, adaptive tolerance " << tolerance << "mV: rms error " << sqrt(squares / samples.size()) << "mV, " << count << " updates\n";
+		}
+	}
+	
+	set_tolerance(0);
+	set_delays(0, 0);
+}
+
+void statisticsFunc()
+{
+	/*
+		population rates of 100 bin intervals with synchronization windows of 30 bins, stepped at once
+		and in chunks of 37 bins with the layer statistics read in between
+		both have to close the same complete intervals with the same rates
+		then a run without recording
+	*/
+	const int bins = 2000;
+	int layers[] = {16, 4, 1};
+	
+	set_statistics(100);
+	set_delays(30, 30);
+	
+	auto rates = [&](const int chunk) {
+		srand(1);
+		void* network = create(0.451, 0.01, bins, layers, 3);
+		for (int i = 0; i < bins; i += chunk) {
+			step(network, std::min(chunk, bins - i));
+			layer_statistics(network);
+		}
+		int length = 0;
+		const double* rate = population_rate(network, 0, &length);
+		std::vector<double> series(rate, rate + length);
+		destroy(network);
+		return series;
+	};
+	
+	const std::vector<double> whole = rates(bins);
+	const std::vector<double> chunked = rates(37);
+	
+	double difference = (whole.size() == chunked.size()) ? 0 : INFINITY;
+	for (size_t i = 0; i < std::min(whole.size(), chunked.size()); i++) {
+		difference = std::max(difference, std::fabs(whole[i] - chunked[i]));
+	}
+	
+	std::cout << "population rate: " << whole.size() << " and " << chunked.size() << " intervals of 100 bins, max difference " << difference << "Hz\n";
+	
+	// without recording only the statistics are kept, run returns no membrane potentials
+	set_recording(0);
+	const bool empty = run(0.451, 0.01, 100, layers, 3) == nullptr;
+	set_recording(1);
+	
+	std::cout << "run without recording returns no membrane potentials: " << (empty ? "yes" : "no") << "\n";
+	
+	set_statistics(100);
+	set_delays(0, 0);
+}
+
+void telemetryFunc()
+{
+	/*
+		publishes two neurons of the first layer with synchronization windows of 30 ms, several spikes per window
+		every upward threshold crossing of the recorded traces has to be published once with its bin
+	*/
+	const int bins = 2000;
+	const double dt = 0.1;
+	int layers[] = {7, 5, 3, 1};
+	int monitored[] = {0, 6};
+	
+	set_delays(300, 300);
+	
+	void* telemetry = telemetry_create("/NeuronalNetwork.telemetryFunc", 1 << 12);
+	void* reader = telemetry_open("/NeuronalNetwork.telemetryFunc");
+	
+	srand(1);
+	void* network = create(0.3, dt, bins, layers, 4);
+	monitor(network, telemetry, monitored, 2, bins);
+	step(network, bins);
+	
+	std::vector<double> records(4 << 12);
+	const int count = telemetry_poll(reader, records.data(), 1 << 12);
+	
+	const double* trace = history(network);
+	int crossings = 0, published = 0, matched = 0;
+	
+	for (int k = 0; k < 2; k++) {
+		const double* Vm = trace + (size_t)monitored[k] * bins;
+		for (int i = 1; i < bins; i++) {
+			crossings += Vm[i - 1] < -55.0 && Vm[i] >= -55.0;
+		}
+	}
+	
+	for (int i = 0; i < count; i++) {
+		if (records[4 * i] != 1) {
+			continue;
+		}
+		published++;
+		const double* Vm = trace + (size_t)records[4 * i + 1] * bins;
+		const int bin = (int)records[4 * i + 2];
+		// crossing between the end of the previous bin and the end of its own, at the published time
+		matched += bin > 0 && Vm[bin - 1] < -55.0 && Vm[bin] >= -55.0 && records[4 * i + 3] >= bin * dt && records[4 * i + 3] <= (bin + 1) * dt;
+	}
+	
+	std::cout << "telemetry: " << crossings << " threshold crossings, " << published << " spikes published, " << matched << " at their bin\n";
+	
+	destroy(network);
+	telemetry_close(reader);
+	telemetry_destroy(telemetry);
+	set_delays(0, 0);
+}
+
+const bool staticLoadFunc()
+{
+	/*
+		copies a chain of three neurons into a StaticNetwork in the middle of a run, with a current pending for the next bin
+		and a clamp and time step other than the StaticNetwork defaults, then steps both
+		the copy has to reproduce the membrane potentials of the network, returns false otherwise
+		(a chain, MyNN wires the neighbors of a layer differently from the StaticNetwork model)
+	*/
+	const int before = 1234;
+	const int bins = 5000;
+	int layers[] = {1, 1, 1};
+	
+	srand(1);
+	void* network = create(0.6, 0.02, before + bins, layers, 3);
+	step(network, before);
+	inject(network, 1, 0.2);
+	
+	StaticNetwork<1, 1, 1> copy;
+	copy.Load(*reinterpret_cast<NeuronalNetwork*>(network));
+	
+	std::vector<double> trace((size_t)bins * 3);
+	copy.Step(bins, trace.data());
+	step(network, bins);
+	
+	const double* Vm = history(network);
+	double difference = 0;
+	for (int b = 0; b < bins; b++) {
+		for (int i = 0; i < 3; i++) {
+			difference = std::max(difference, std::fabs(trace[(size_t)b * 3 + i] - Vm[(size_t)i * (before + bins) + before + b]));
+		}
+	}
+	
+	std::cout << "StaticNetwork loaded at bin " << before << ": max difference " << difference << "mV over " << bins << " bins, " << copy.GetSpikes(0) + copy.GetSpikes(1) + copy.GetSpikes(2) << " spikes\n";
+	
+	destroy(network);
+	
+	if (difference != 0) {
+		std::cout << "StaticNetwork load: check failed\n";
+		return false;
+	}
+	return true;
+}
+
+const bool forkFunc()
+{
+	/*
+		forks three branches of the default topology with different stimuli to the second layer
+		compares every branch against a sequential run of the same stimulus, then forks without recording
+		returns false if a branch differs or the fork without recording is not rejected
+	*/
+	const int before = 2000;
+	const int after = 1000;
+	const int size = 21;
+	const double amplitudes[] = {0.0, 0.05, 0.2};
+	int layers[] = {16, 4, 1};
+	
+	srand(1);
+	void* network = create(0.451, 0.01, before + after, layers, 3);
+	step(network, before);
+	
+	const int branch = fork_branches(network, 3, after);
+	
+	if (branch >= 0) {
+		stimulate_step(network, 16, 20, amplitudes[branch], before, before + after);
+		step(network, after);
+		// ends the branch process
+		branch_join(network);
+	}
+	
+	const double* results = branch_wait(network);
+	std::vector<double> branches(results, results + 3 * size * after);
+	destroy(network);
+	
+	double difference = 0;
+	
+	for (int b = 0; b < 3; b++) {
+		srand(1);
+		void* sequential = create(0.451, 0.01, before + after, layers, 3);
+		step(sequential, before);
+		stimulate_step(sequential, 16, 20, amplitudes[b], before, before + after);
+		step(sequential, after);
+		
+		const double* trace = history(sequential);
+		for (int i = 0; i < size; i++) {
+			for (int t = 0; t < after; t++) {
+				difference = std::max(difference, std::fabs(branches[((size_t)b * size + i) * after + t] - trace[(size_t)i * (before + after) + before + t]));
+			}
+		}
+		destroy(sequential);
+	}
+	
+	set_recording(0);
+	void* unrecorded = create(0.451, 0.01, before, layers, 3);
+	step(unrecorded, 100);
+	const int rejected = fork_branches(unrecorded, 2, 100);
+	destroy(unrecorded);
+	set_recording(1);
+	
+	std::cout << "3 branches against sequential runs: max difference " << difference << "mV, fork without recording returns " << rejected << "\n";
+	
+	if (difference != 0 || rejected != -1) {
+		std::cout << "forking: check failed\n";
+		return false;
+	}
+	return true;
+}
 
 /*
 	Things to think about further implementation
@@ -77,6 +77,53 @@ def animate(frame, Vs, t, lines):
 		lines[i].set_data(t[:frame], tmp[:frame])
 	return lines
 
+def tail(name = "/NeuronalNetwork.telemetry", dt = 0.1, max_records = 4096):
+	# attaches to the telemetry ring buffer of a running simulation and plots it live
+	lib = ctypes.CDLL("libengine.so")
+	lib.telemetry_open.argtypes = [ctypes.c_char_p]
+	lib.telemetry_open.restype = ctypes.c_void_p
+	lib.telemetry_poll.argtypes = [ctypes.c_void_p, ndpointer(dtype = ctypes.c_double), ctypes.c_int]
+	lib.telemetry_poll.restype = ctypes.c_int
+	lib.telemetry_close.argtypes = [ctypes.c_void_p]
+
+	reader = lib.telemetry_open(name.encode())
+	if not reader:
+		print("no telemetry at %s" % name)
+		return
+
+	records = np.zeros(4 * max_records)
+	traces = {}
+	lines = {}
+
+	plt.ion()
+	fig, ax = plt.subplots()
+	ax.set_xlabel('time in msec')
+	ax.set_ylabel('Voltage in mV')
+	ax.set_ylim(-90, 90)
+	ax.grid(True)
+
+	try:
+		while plt.fignum_exists(fig.number):
+			count = lib.telemetry_poll(reader, records, max_records)
+			for i in range(count):
+				kind, neuron, b, value = records[4 * i: 4 * i + 4]
+				if kind == 0:
+					traces.setdefault(int(neuron), ([], []))
+					traces[int(neuron)][0].append(b * dt)
+					traces[int(neuron)][1].append(value)
+				else:
+					ax.axvline(value, color = "gray", linewidth = 0.5)
+			for neuron, (t, v) in traces.items():
+				if neuron not in lines:
+					lines[neuron], = ax.plot([], [], label = f"N{neuron}")
+					ax.legend(loc = 'upper right')
+				lines[neuron].set_data(t, v)
+			ax.relim()
+			ax.autoscale_view(scaley = False)
+			plt.pause(0.05)
+	finally:
+		lib.telemetry_close(reader)
+
 def main():
 	# input current
 	# iInput = np.random.uniform(0.01,0.2)
@@ -108,4 +155,7 @@ def main():
 	
 
 if __name__ == '__main__':
-	main()
+	if len(sys.argv) > 1 and sys.argv[1] == "tail":
+		tail(*sys.argv[2:3])
+	else:
+		main()
@@ -0,0 +1,134 @@
+//
+//  Arena.cpp
+//  NeuronalNetwork
+//
+//  Created by Nicolas Fricker on 04/10/20.
+//  Copyright © 2020 Nicolas Fricker. All rights reserved.
+//
+
+#include "Arena.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include <sys/mman.h>
+
+Arena::Arena() {}
+
+Arena::~Arena()
+{
+	/*
+		Deconstructor
+	*/
+	Release();
+	pthread_mutex_destroy(&mutex_);
+}
+
+const void Arena::Reserve(const size_t bytes, const bool huge_pages) noexcept
+{
+	/*
+		bytes = expected size of all blocks
+		huge_pages = back the reservation with huge pages
+		maps the reservation up front, pages are only committed when touched
+	*/
+	huge_pages_ = huge_pages;
+	Map(bytes);
+}
+
+void* Arena::Allocate(const size_t bytes, const size_t alignment) noexcept
+{
+	/*
+		bytes = block size
+		alignment = block alignment
+		returns a block carved from the last chunk, maps a new chunk if it is full, nullptr if that fails
+	*/
+	pthread_mutex_lock(&mutex_);
+
+	if (chunks_.empty() || ((chunks_.back().used_ + alignment - 1) & ~(alignment - 1)) + bytes > chunks_.back().size_) {
+		if (!Map(std::max(bytes + alignment, s_chunk_size_))) {
+			pthread_mutex_unlock(&mutex_);
+			return nullptr;
+		}
+	}
+
+	Chunk& chunk = chunks_.back();
+	// align offset
+	const size_t offset = (chunk.used_ + alignment - 1) & ~(alignment - 1);
+	chunk.used_ = offset + bytes;
+
+	pthread_mutex_unlock(&mutex_);
+
+	return chunk.base_ + offset;
+}
+
+const void Arena::Release() noexcept
+{
+	/*
+		unmaps all chunks at once
+	*/
+	for (int i = 0; i < chunks_.size(); i++) {
+		munmap(chunks_[i].base_, chunks_[i].size_);
+	}
+	chunks_.clear();
+}
+
+const size_t Arena::Reserved() const noexcept
+{
+	/*
+		returns mapped size [bytes]
+	*/
+	size_t total = 0;
+	for (int i = 0; i < chunks_.size(); i++) {
+		total += chunks_[i].size_;
+	}
+	return total;
+}
+
+const size_t Arena::Used() const noexcept
+{
+	/*
+		returns size of blocks handed out [bytes]
+	*/
+	size_t total = 0;
+	for (int i = 0; i < chunks_.size(); i++) {
+		total += chunks_[i].used_;
+	}
+	return total;
+}
+
+const bool Arena::Map(const size_t bytes) noexcept
+{
+	/*
+		bytes = chunk size
+		maps a new chunk, rounded to the huge page size
+	*/
+	const size_t size = (bytes + s_huge_page_size_ - 1) & ~(s_huge_page_size_ - 1);
+	void* base = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+	if (huge_pages_) {
+		// explicit huge pages, requires a configured huge page pool
+		base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_HUGETLB, -1, 0);
+	}
+#endif
+
+	if (base == MAP_FAILED) {
+		base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+		if (base == MAP_FAILED) {
+			printf("arena: mapping error of %zu bytes\n", size);
+			return false;
+		}
+
+#ifdef MADV_HUGEPAGE
+		if (huge_pages_) {
+			// transparent huge pages
+			madvise(base, size, MADV_HUGEPAGE);
+		}
+#endif
+	}
+
+	chunks_.push_back({reinterpret_cast<char*>(base), size, 0});
+
+	return true;
+}
@@ -0,0 +1,137 @@
+//
+//  Arena.h
+//  NeuronalNetwork
+//
+//  Created by Nicolas Fricker on 04/10/20.
+//  Copyright © 2020 Nicolas Fricker. All rights reserved.
+//
+
+#ifndef Arena_
+#define Arena_
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#include <pthread.h>
+
+#pragma GCC visibility push(hidden)
+
+class Arena
+{
+	/*
+		Network scoped bump allocator
+		reserves one large mapping, optionally backed by huge pages, and carves out
+		neurons, connectivity and recording buffers from it
+		individual blocks are never freed, the whole arena is unmapped at once
+	*/
+	struct Chunk
+	{
+		// mapped memory
+		char* base_ = nullptr;
+		// mapped size [bytes]
+		size_t size_ = 0;
+		// bytes handed out
+		size_t used_ = 0;
+	};
+
+	// mapped chunks, the last one is carved from
+	std::vector<Chunk> chunks_;
+
+	// back chunks with huge pages
+	bool huge_pages_ = false;
+
+	// guards growth of vectors from worker threads
+	pthread_mutex_t mutex_ = PTHREAD_MUTEX_INITIALIZER;
+
+	// default chunk size [bytes]
+	inline constexpr static const size_t s_chunk_size_ = 1 << 26;
+	// huge page size [bytes]
+	inline constexpr static const size_t s_huge_page_size_ = 1 << 21;
+
+public:
+	Arena();
+	~Arena();
+
+	Arena(const Arena& other) = delete;
+	Arena& operator=(const Arena& other) = delete;
+
+	const void Reserve(const size_t bytes, const bool huge_pages = false) noexcept;
+	void* Allocate(const size_t bytes, const size_t alignment) noexcept;
+	const void Release() noexcept;
+
+	const size_t Reserved() const noexcept;
+	const size_t Used() const noexcept;
+
+private:
+	const bool Map(const size_t bytes) noexcept;
+};
+
+template <class T>
+class ArenaAllocator
+{
+	/*
+		Standard allocator drawing from an Arena
+		falls back to the global heap without an arena
+		the arena keeps a deallocated block until it is released, a vector growing past its reservation
+		leaves every outgrown block behind, the history logs therefore move to the heap once they outgrow theirs
+	*/
+	template <class U>
+	friend class ArenaAllocator;
+
+	Arena* arena_ = nullptr;
+
+public:
+	typedef T value_type;
+	typedef std::true_type propagate_on_container_move_assignment;
+	typedef std::true_type propagate_on_container_copy_assignment;
+	typedef std::true_type propagate_on_container_swap;
+
+	ArenaAllocator() noexcept {}
+	ArenaAllocator(Arena* arena) noexcept: arena_(arena) {}
+	template <class U>
+	ArenaAllocator(const ArenaAllocator<U>& other) noexcept: arena_(other.arena_) {}
+
+	T* allocate(const size_t n)
+	{
+		/*
+			n = number of elements
+		*/
+		if (arena_) {
+			void* block = arena_->Allocate(n * sizeof(T), alignof(T));
+			// no chunk could be mapped
+			if (!block) {
+				throw std::bad_alloc();
+			}
+			return reinterpret_cast<T*>(block);
+		}
+		return reinterpret_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+	}
+
+	void deallocate(T* p, const size_t) noexcept
+	{
+		/*
+			arena blocks are released with the arena
+		*/
+		if (!arena_) {
+			::operator delete(p, std::align_val_t(alignof(T)));
+		}
+	}
+
+	Arena* arena() const noexcept
+	{
+		/*
+			returns arena pointer
+		*/
+		return arena_;
+	}
+
+	template <class U>
+	const bool operator==(const ArenaAllocator<U>& other) const noexcept { return arena_ == other.arena_; }
+	template <class U>
+	const bool operator!=(const ArenaAllocator<U>& other) const noexcept { return arena_ != other.arena_; }
+};
+
+#pragma GCC visibility pop
+#endif /* Arena_ */
@@ -0,0 +1,151 @@
+//
+//  AsyncRun.cpp
+//  NeuronalNetwork
+//
+//  Created by Nicolas Fricker on 04/10/20.
+//  Copyright © 2020 Nicolas Fricker. All rights reserved.
+//
+
+#include "AsyncRun.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+__attribute__((visibility("default"))) AsyncRun::AsyncRun(NeuronalNetwork* network, const int bins, const int chunk)
+{
+	/*
+		network = network to run, deleted with the run
+		bins = number of bins to integrate
+		chunk = bins between progress updates
+	*/
+	network_ = network;
+	bins_ = bins;
+	chunk_ = std::max(chunk, 1);
+}
+
+__attribute__((visibility("default"))) AsyncRun::~AsyncRun()
+{
+	/*
+		Deconstructor
+		cancels a run still in progress and waits for it before the network is deleted
+	*/
+	Cancel();
+	Wait();
+
+	if (network_) {
+		delete network_;
+	}
+}
+
+__attribute__((visibility("default"))) const bool AsyncRun::Start() noexcept
+{
+	/*
+		launches the background thread, returns false if it could not be created
+	*/
+	if (started_) {
+		return true;
+	}
+
+	if (pthread_create(&thread_, NULL, &AsyncRun::Launch, this) != 0) {
+		printf("async run: thread creation error\n");
+		a_done_.store(true, std::memory_order_release);
+		return false;
+	}
+
+	started_ = true;
+	return true;
+}
+
+__attribute__((visibility("default"))) const int AsyncRun::Poll() const noexcept
+{
+	/*
+		returns the number of bins integrated so far, never blocks
+	*/
+	return a_progress_.load(std::memory_order_acquire);
+}
+
+__attribute__((visibility("default"))) const bool AsyncRun::Done() const noexcept
+{
+	/*
+		returns true once the run has finished or returned after a cancellation
+	*/
+	return a_done_.load(std::memory_order_acquire);
+}
+
+__attribute__((visibility("default"))) const void AsyncRun::Wait() noexcept
+{
+	/*
+		blocks until the background thread has returned, the network can then be read
+	*/
+	pthread_mutex_lock(&join_m_);
+
+	if (started_ && !joined_) {
+		pthread_join(thread_, NULL);
+		joined_ = true;
+	}
+
+	pthread_mutex_unlock(&join_m_);
+}
+
+__attribute__((visibility("default"))) const void AsyncRun::Cancel() noexcept
+{
+	/*
+		asks the run to return at the next bin boundary, returns without waiting
+	*/
+	if (network_) {
+		network_->Cancel();
+	}
+}
+
+__attribute__((visibility("default"))) NeuronalNetwork* AsyncRun::GetNetwork() noexcept
+{
+	/*
+		returns the network, only read it once Done or after Wait
+	*/
+	return network_;
+}
+
+__attribute__((visibility("default"))) const double* AsyncRun::GetHistory() noexcept
+{
+	/*
+		waits for the run and returns the membrane potentials of the bins integrated
+		neuron i occupies [i * bins, (i + 1) * bins), bins = Poll()
+		the buffer belongs to this run and is freed with it
+	*/
+	Wait();
+
+	neurons_t& neurons = network_->GetNeurons();
+	const size_t bins = network_->GetBin();
+
+	history_.assign(neurons.size() * bins, 0);
+
+	for (int i = 0; i < neurons.size(); i++) {
+		// neuron of id i
+		Neuron& neuron = neurons[network_->GetPosition(i)];
+		memcpy(&history_[i * bins], neuron.GetHistory().data(), std::min(bins, neuron.GetHistorySize()) * sizeof(double));
+	}
+
+	return history_.data();
+}
+
+void* AsyncRun::Launch(void* run) noexcept
+{
+	/*
+		background thread, integrates chunk by chunk and publishes the progress in between
+	*/
+	AsyncRun* self = reinterpret_cast<AsyncRun*>(run);
+	NeuronalNetwork* network = self->network_;
+
+	while (network->GetBin() < self->bins_ && !network->Cancelled()) {
+		const int bin = network->Step(std::min(self->chunk_, self->bins_ - network->GetBin()));
+		self->a_progress_.store(bin, std::memory_order_release);
+	}
+
+	// last archive blocks
+	network->Archive();
+
+	self->a_done_.store(true, std::memory_order_release);
+
+	return NULL;
+}
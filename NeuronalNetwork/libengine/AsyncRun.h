@@ -0,0 +1,71 @@
+//
+//  AsyncRun.h
+//  NeuronalNetwork
+//
+//  Created by Nicolas Fricker on 04/10/20.
+//  Copyright © 2020 Nicolas Fricker. All rights reserved.
+//
+
+#ifndef AsyncRun_
+#define AsyncRun_
+
+#include "NeuronalNetwork.h"
+
+#include <pthread.h>
+
+#include <atomic>
+#include <vector>
+
+#pragma GCC visibility push(hidden)
+
+class AsyncRun
+{
+	/*
+		Runs a network in a background thread, the caller polls, waits or cancels
+		cancellation is cooperative, the network returns at the next bin boundary
+		and keeps the bins integrated so far
+	*/
+	// network being run, owned
+	NeuronalNetwork* network_ = nullptr;
+	// number of bins to integrate
+	int bins_ = 0;
+	// bins between progress updates
+	int chunk_ = 100;
+
+	// background thread
+	pthread_t thread_;
+	// guards the join of the background thread
+	pthread_mutex_t join_m_ = PTHREAD_MUTEX_INITIALIZER;
+	bool started_ = false;
+	bool joined_ = false;
+
+	// bins integrated, written by the background thread
+	std::atomic<int> a_progress_{0};
+	// background thread has returned
+	std::atomic<bool> a_done_{false};
+
+	// membrane potentials of the bins integrated, in id order, filled by GetHistory
+	std::vector<double> history_;
+
+public:
+	AsyncRun(NeuronalNetwork* network, const int bins, const int chunk = 100);
+	~AsyncRun();
+
+	AsyncRun(const AsyncRun& other) = delete;
+	AsyncRun& operator=(const AsyncRun& other) = delete;
+
+	const bool Start() noexcept;
+	const int Poll() const noexcept;
+	const bool Done() const noexcept;
+	const void Wait() noexcept;
+	const void Cancel() noexcept;
+
+	NeuronalNetwork* GetNetwork() noexcept;
+	const double* GetHistory() noexcept;
+
+private:
+	static void* Launch(void* run) noexcept;
+};
+
+#pragma GCC visibility pop
+#endif /* AsyncRun_ */
@@ -0,0 +1,293 @@
+//
+//  Cable.cpp
+//  NeuronalNetwork
+//
+//  Created by Nicolas Fricker on 04/10/20.
+//  Copyright © 2020 Nicolas Fricker. All rights reserved.
+//
+
+#include "Cable.h"
+#include "FastMath.hpp"
+#include "Neuron.h"
+
+#include <algorithm>
+#include <cmath>
+
+__attribute__((visibility("default"))) Cable::Cable(const std::vector<int>& parents, const std::vector<double>& lengths, const std::vector<double>& diameters, const int cells, const double Ra, const double dt)
+{
+	/*
+		parents = parent of every compartment, preceding it, -1 for a root, later parents are treated as roots
+		lengths, diameters = cylinder of every compartment [µm]
+		cells = number of cells of this morphology
+		Ra = axial resistivity [Ω cm]
+		dt = time step [ms]
+		cells start at rest without injected current, spikes are detected in compartment 0
+	*/
+	cells_ = std::max(cells, 0);
+	compartments_ = (int)std::min({parents.size(), lengths.size(), diameters.size()});
+	dt_ = dt;
+
+	parents_.assign(compartments_, -1);
+	g_child_.assign(compartments_, 0);
+	g_parent_.assign(compartments_, 0);
+	g_axial_.assign(compartments_, 0);
+
+	// half-cylinder resistance [Ω] and membrane area [cm^2] of a compartment
+	auto resistance = [&](const int k) {
+		const double radius = diameters[k] * 0.5e-4;
+		return Ra * lengths[k] * 0.5e-4 / (M_PI * radius * radius);
+	};
+	auto area = [&](const int k) {
+		return M_PI * diameters[k] * lengths[k] * 1e-8;
+	};
+
+	for (int k = 0; k < compartments_; k++) {
+		if (parents[k] < 0 || parents[k] >= k) {
+			continue;
+		}
+
+		const int p = parents[k];
+		parents_[k] = p;
+
+		// axial conductance between the centers [S]
+		const double g = 1.0 / (resistance(k) + resistance(p));
+
+		// per membrane area [S/cm^2], 1000 mS/cm^2 each, in the units of Neuron
+		g_child_[k] = g / area(k) * 1e3 * 1e-2;
+		g_parent_[k] = g / area(p) * 1e3 * 1e-2;
+
+		g_axial_[k] += g_child_[k];
+		g_axial_[p] += g_parent_[k];
+	}
+
+	const size_t size = (size_t)compartments_ * cells_;
+
+	Vm_.assign(size, -64.9964);
+	m_.assign(size, 0.0530);
+	h_.assign(size, 0.5960);
+	n_.assign(size, 0.3177);
+	current_.assign(size, 0);
+	diagonal_.assign(size, 0);
+	rhs_.assign(size, 0);
+
+	spikes_.assign(cells_, 0);
+	above_.assign(cells_, 0);
+}
+
+__attribute__((visibility("default"))) Cable Cable::BallAndStick(const int cells, const int dendrites, const int segments, const int axon, const double dt)
+{
+	/*
+		cells = number of cells
+		dendrites = unbranched dendrites of the soma, segments compartments of 50 x 2 µm each
+		axon = compartments of 20 x 1 µm of the axon
+		soma of 20 x 20 µm is compartment 0, spikes are detected at the end of the axon, or in the soma without axon
+	*/
+	std::vector<int> parents = {-1};
+	std::vector<double> lengths = {20.0};
+	std::vector<double> diameters = {20.0};
+
+	for (int d = 0; d < dendrites; d++) {
+		for (int s = 0; s < segments; s++) {
+			// first segment on the soma, the others on the previous segment
+			parents.push_back((s == 0) ? 0 : (int)parents.size() - 1);
+			lengths.push_back(50.0);
+			diameters.push_back(2.0);
+		}
+	}
+
+	for (int a = 0; a < axon; a++) {
+		parents.push_back((a == 0) ? 0 : (int)parents.size() - 1);
+		lengths.push_back(20.0);
+		diameters.push_back(1.0);
+	}
+
+	Cable cable(parents, lengths, diameters, cells, 100.0, dt);
+	cable.SetSpikeCompartment((axon > 0) ? (int)parents.size() - 1 : 0);
+
+	return cable;
+}
+
+__attribute__((visibility("default"))) const int Cable::Step(const int bins, double* history) noexcept
+{
+	/*
+		bins = number of bins to integrate
+		history = nullptr or bins x cells membrane potentials [mV] of the spike compartment, bin major
+		backward Euler update of the membrane potentials with the channels of the start of the bin,
+		then exponential Euler update of the channel activations
+		returns the next bin to integrate
+	*/
+	const size_t size = (size_t)compartments_ * cells_;
+	double* __restrict spiking = Vm_.data() + (size_t)spike_compartment_ * cells_;
+
+	for (int b = 0; b < bins; b++) {
+		Assemble();
+		Solve();
+
+		Neuron::IntegrateGates(Vm_.data(), m_.data(), h_.data(), n_.data(), size, dt_);
+
+		for (int c = 0; c < cells_; c++) {
+			// threshold crossing on an upstroke
+			const bool above = spiking[c] >= Neuron::s_Vthreashold_;
+			spikes_[c] += above && !above_[c];
+			above_[c] = above;
+		}
+
+		if (history) {
+			std::copy(spiking, spiking + cells_, history + (size_t)b * cells_);
+		}
+
+		bin_++;
+	}
+
+	return bin_;
+}
+
+__attribute__((visibility("default"))) const void Cable::SetCurrent(const int cell, const int compartment, const double current) noexcept
+{
+	/*
+		sets the constant current [µA] injected into the compartment of the cell
+	*/
+	current_[(size_t)compartment * cells_ + cell] = current;
+}
+
+__attribute__((visibility("default"))) const void Cable::SetSpikeCompartment(const int compartment) noexcept
+{
+	/*
+		sets the compartment whose threshold crossings are counted as spikes
+	*/
+	spike_compartment_ = std::clamp(compartment, 0, std::max(compartments_ - 1, 0));
+	above_.assign(cells_, 0);
+}
+
+__attribute__((visibility("default"))) const double Cable::GetMembranePotential(const int cell, const int compartment) const noexcept
+{
+	/*
+		returns the membrane potential [mV] of the compartment of the cell after the last integrated bin
+	*/
+	return Vm_[(size_t)compartment * cells_ + cell];
+}
+
+__attribute__((visibility("default"))) const size_t Cable::GetSpikes(const int cell) const noexcept
+{
+	/*
+		returns the number of threshold crossings of the spike compartment of the cell
+	*/
+	return spikes_[cell];
+}
+
+__attribute__((visibility("default"))) const int Cable::GetCells() const noexcept
+{
+	/*
+		returns number of cells
+	*/
+	return cells_;
+}
+
+__attribute__((visibility("default"))) const int Cable::GetCompartments() const noexcept
+{
+	/*
+		returns number of compartments per cell
+	*/
+	return compartments_;
+}
+
+__attribute__((visibility("default"))) const int Cable::GetParent(const int compartment) const noexcept
+{
+	/*
+		returns parent of the compartment, -1 for a root
+	*/
+	return parents_[compartment];
+}
+
+__attribute__((visibility("default"))) const int Cable::GetBin() const noexcept
+{
+	/*
+		returns the next bin to integrate
+	*/
+	return bin_;
+}
+
+const void Cable::Assemble() noexcept
+{
+	/*
+		diagonal and right-hand side of every compartment:
+		(Cm / dt + g + g_axial) * V' - axial terms = Cm / dt * V + g * E + I
+		with the channel conductance g and reversal potential E of the start of the bin
+	*/
+	const double capacitance = Cm_ / dt_;
+
+	for (int k = 0; k < compartments_; k++) {
+		const size_t offset = (size_t)k * cells_;
+		Linearize(&Vm_[offset], &m_[offset], &h_[offset], &n_[offset], &current_[offset], &diagonal_[offset], &rhs_[offset], cells_, capacitance, capacitance + g_axial_[k]);
+	}
+}
+
+const void Cable::Linearize(const double* __restrict Vm, const double* __restrict m, const double* __restrict h, const double* __restrict n, const double* __restrict current, double* __restrict diagonal, double* __restrict rhs, const int count, const double capacitance, const double axial) noexcept
+{
+	/*
+		diagonal and right-hand side of one compartment of count cells, the loop vectorizes over the cells
+		capacitance = Cm / dt
+		axial = Cm / dt plus the axial conductances of the compartment
+	*/
+	for (int c = 0; c < count; c++) {
+		// Currents: Na, K, leak
+		const double iNa = Neuron::s_GNa_ * FastMath::Pow3(m[c]) * h[c];
+		const double iK = Neuron::s_GK_ * FastMath::Pow4(n[c]);
+		const double iL = Neuron::s_GL_;
+
+		diagonal[c] = axial + iNa + iK + iL;
+		rhs[c] = capacitance * Vm[c] + (Neuron::s_ENa_ * iNa + Neuron::s_EK_ * iK + Neuron::s_EL_ * iL) + current[c];
+	}
+}
+
+const void Cable::Solve() noexcept
+{
+	/*
+		Hines elimination of the tree system in O(compartments), for all cells at once
+		leaves to root: every compartment is eliminated from the row of its parent,
+		root to leaves: every compartment follows from its parent
+	*/
+	for (int k = compartments_ - 1; k > 0; k--) {
+		const int p = parents_[k];
+
+		if (p < 0) {
+			continue;
+		}
+
+		const double* __restrict diagonal = diagonal_.data() + (size_t)k * cells_;
+		const double* __restrict rhs = rhs_.data() + (size_t)k * cells_;
+		double* __restrict parent_diagonal = diagonal_.data() + (size_t)p * cells_;
+		double* __restrict parent_rhs = rhs_.data() + (size_t)p * cells_;
+
+		const double g_child = g_child_[k];
+		const double g_parent = g_parent_[k];
+
+		for (int c = 0; c < cells_; c++) {
+			const double factor = g_parent / diagonal[c];
+			parent_diagonal[c] -= factor * g_child;
+			parent_rhs[c] += factor * rhs[c];
+		}
+	}
+
+	for (int k = 0; k < compartments_; k++) {
+		const int p = parents_[k];
+
+		const double* __restrict diagonal = diagonal_.data() + (size_t)k * cells_;
+		const double* __restrict rhs = rhs_.data() + (size_t)k * cells_;
+		double* __restrict Vm = Vm_.data() + (size_t)k * cells_;
+
+		if (p < 0) {
+			for (int c = 0; c < cells_; c++) {
+				Vm[c] = rhs[c] / diagonal[c];
+			}
+			continue;
+		}
+
+		const double* __restrict parent_Vm = Vm_.data() + (size_t)p * cells_;
+		const double g_child = g_child_[k];
+
+		for (int c = 0; c < cells_; c++) {
+			Vm[c] = (rhs[c] + g_child * parent_Vm[c]) / diagonal[c];
+		}
+	}
+}
@@ -0,0 +1,90 @@
+//
+//  Cable.h
+//  NeuronalNetwork
+//
+//  Created by Nicolas Fricker on 04/10/20.
+//  Copyright © 2020 Nicolas Fricker. All rights reserved.
+//
+
+#ifndef Cable_
+#define Cable_
+
+#include <cstddef>
+#include <vector>
+
+#pragma GCC visibility push(hidden)
+
+class Cable
+{
+	/*
+		Group of multi-compartment cells sharing one morphology, e.g. a soma with dendrite and axon trees
+		every compartment carries the Hodgkin-Huxley channels of Neuron, neighboring compartments are
+		coupled by their axial conductance
+		compartments are numbered so that every parent precedes its children (Hines order), the implicit
+		membrane update of a tree is then one elimination from the leaves and one substitution from the root
+		the state is compartment major, compartment k of cell c at k * cells + c, every step of the
+		elimination is a contiguous loop over the cells
+		conductances, currents and capacitance are in the units of Neuron, 1/100 of their values per cm^2
+	*/
+	// number of cells and compartments per cell
+	int cells_ = 0;
+	int compartments_ = 0;
+
+	// parent of every compartment, -1 for a root
+	std::vector<int> parents_;
+	// axial conductance to the parent per membrane area of the compartment and of the parent
+	std::vector<double> g_child_;
+	std::vector<double> g_parent_;
+	// sum of the axial conductances of every compartment
+	std::vector<double> g_axial_;
+
+	// membrane potential [mV]
+	std::vector<double> Vm_;
+	// sodium activation, sodium inactivation and potassium activation
+	std::vector<double> m_;
+	std::vector<double> h_;
+	std::vector<double> n_;
+	// constant injected current [µA]
+	std::vector<double> current_;
+	// diagonal and right-hand side of the tree system, eliminated in place
+	std::vector<double> diagonal_;
+	std::vector<double> rhs_;
+
+	// compartment the spikes are detected in and threshold crossings of every cell
+	int spike_compartment_ = 0;
+	std::vector<size_t> spikes_;
+	// spike compartment of every cell above threshold after the last bin
+	std::vector<char> above_;
+
+	// [uF/cm^2] membrane capacitance density
+	double Cm_ = 0.01;
+	// time step [ms]
+	double dt_ = 0.01;
+	// next bin to integrate
+	int bin_ = 0;
+
+public:
+	Cable(const std::vector<int>& parents, const std::vector<double>& lengths, const std::vector<double>& diameters, const int cells, const double Ra = 100.0, const double dt = 0.01);
+
+	static Cable BallAndStick(const int cells, const int dendrites = 4, const int segments = 10, const int axon = 20, const double dt = 0.01);
+
+	const int Step(const int bins = 1, double* history = nullptr) noexcept;
+
+	const void SetCurrent(const int cell, const int compartment, const double current) noexcept;
+	const void SetSpikeCompartment(const int compartment) noexcept;
+
+	const double GetMembranePotential(const int cell, const int compartment) const noexcept;
+	const size_t GetSpikes(const int cell) const noexcept;
+	const int GetCells() const noexcept;
+	const int GetCompartments() const noexcept;
+	const int GetParent(const int compartment) const noexcept;
+	const int GetBin() const noexcept;
+
+private:
+	const void Assemble() noexcept;
+	static const void Linearize(const double* __restrict Vm, const double* __restrict m, const double* __restrict h, const double* __restrict n, const double* __restrict current, double* __restrict diagonal, double* __restrict rhs, const int count, const double capacitance, const double axial) noexcept;
+	const void Solve() noexcept;
+};
+
+#pragma GCC visibility pop
+#endif /* Cable_ */
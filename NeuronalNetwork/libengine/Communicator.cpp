@@ -0,0 +1,221 @@
+//
+//  Communicator.cpp
+//  NeuronalNetwork
+//
+//  Created by Nicolas Fricker on 04/10/20.
+//  Copyright © 2020 Nicolas Fricker. All rights reserved.
+//
+
+#include "Communicator.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+Communicator::~Communicator() {}
+
+SharedMemoryCommunicator::SharedMemoryCommunicator(const std::string name, const int rank, const int size, const size_t capacity)
+{
+	/*
+		name = POSIX shared memory segment name
+		rank = index of this process
+		size = number of processes
+		capacity = mailbox size of every rank [bytes]
+		rank 0 creates the segment, other ranks attach to it once it is initialized
+	*/
+	name_ = name;
+	rank_ = rank;
+	size_ = size;
+	bytes_ = sizeof(Header) + size * sizeof(size_t) + size * capacity;
+
+	int fd = -1;
+
+	if (rank_ == 0) {
+		fd = shm_open(name_.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0600);
+		if (fd < 0 || ftruncate(fd, bytes_) != 0) {
+			printf("%s: shared memory creation error\n", name_.c_str());
+			return;
+		}
+	} else {
+		struct stat st;
+		// waits for rank 0 to create and size the segment
+		while ((fd = shm_open(name_.c_str(), O_RDWR, 0600)) < 0 || (fstat(fd, &st) == 0 && (size_t)st.st_size < bytes_)) {
+			if (fd >= 0) {
+				close(fd);
+			}
+			sched_yield();
+		}
+	}
+
+	void* segment = mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (segment == MAP_FAILED) {
+		printf("%s: shared memory mapping error\n", name_.c_str());
+		return;
+	}
+
+	segment_ = reinterpret_cast<char*>(segment);
+
+	if (rank_ == 0) {
+		// segment is zero filled by ftruncate
+		GetHeader()->capacity_ = capacity;
+		GetHeader()->a_ready_.store(1);
+	} else {
+		while (GetHeader()->a_ready_.load() == 0) {
+			sched_yield();
+		}
+	}
+}
+
+SharedMemoryCommunicator::~SharedMemoryCommunicator()
+{
+	/*
+		Deconstructor
+	*/
+	if (segment_) {
+		munmap(segment_, bytes_);
+	}
+	if (rank_ == 0 && !name_.empty()) {
+		shm_unlink(name_.c_str());
+	}
+}
+
+SharedMemoryCommunicator* SharedMemoryCommunicator::Spawn(const int processes, const size_t capacity)
+{
+	/*
+		processes = number of local processes in the group
+		forks processes - 1 children sharing the segment
+		returns the communicator of the calling process, children must exit once done
+	*/
+	static int count = 0;
+	const std::string name = "/NeuronalNetwork." + std::to_string(getpid()) + "." + std::to_string(count++);
+
+	SharedMemoryCommunicator* comm = new SharedMemoryCommunicator(name, 0, processes, capacity);
+
+	for (int i = 1; i < processes; i++) {
+		if (fork() == 0) {
+			// child inherits the mapping
+			comm->rank_ = i;
+			comm->name_.clear();
+			return comm;
+		}
+	}
+
+	// every rank holds the mapping, the name is not needed anymore
+	shm_unlink(name.c_str());
+	comm->name_.clear();
+
+	return comm;
+}
+
+const int SharedMemoryCommunicator::Rank() const noexcept
+{
+	/*
+		returns rank of this process
+	*/
+	return rank_;
+}
+
+const int SharedMemoryCommunicator::Size() const noexcept
+{
+	/*
+		returns number of processes
+	*/
+	return size_;
+}
+
+const void SharedMemoryCommunicator::Barrier() noexcept
+{
+	/*
+		sense reversing barrier over the shared segment
+	*/
+	Header* header = GetHeader();
+	const int generation = header->a_generation_.load();
+
+	if (header->a_waiting_.fetch_add(1) == size_ - 1) {
+		// last rank to arrive releases the others
+		header->a_waiting_.store(0);
+		header->a_generation_.fetch_add(1);
+	} else {
+		while (header->a_generation_.load() == generation) {
+			sched_yield();
+		}
+	}
+}
+
+const void SharedMemoryCommunicator::Allgather(const void* send, const size_t bytes, std::vector<char>& recv, std::vector<size_t>& counts) noexcept
+{
+	/*
+		send = message of this rank
+		bytes = message size
+		recv = concatenated messages of all ranks in rank order
+		counts = message size of every rank
+	*/
+	const size_t capacity = GetHeader()->capacity_;
+
+	// publish message sizes
+	*Counts(rank_) = bytes;
+	Barrier();
+
+	counts.resize(size_);
+	std::vector<size_t> displacements(size_);
+	size_t total = 0;
+	size_t longest = 0;
+
+	for (int i = 0; i < size_; i++) {
+		counts[i] = *Counts(i);
+		displacements[i] = total;
+		total += counts[i];
+		longest = std::max(longest, counts[i]);
+	}
+
+	recv.resize(total);
+	// sizes are read before the next exchange overwrites them
+	Barrier();
+
+	// exchange messages in rounds of the mailbox capacity
+	for (size_t offset = 0; offset < longest; offset += capacity) {
+		if (offset < bytes) {
+			memcpy(Mailbox(rank_), reinterpret_cast<const char*>(send) + offset, std::min(capacity, bytes - offset));
+		}
+		Barrier();
+
+		for (int i = 0; i < size_; i++) {
+			if (offset < counts[i]) {
+				memcpy(&recv[displacements[i] + offset], Mailbox(i), std::min(capacity, counts[i] - offset));
+			}
+		}
+		Barrier();
+	}
+}
+
+SharedMemoryCommunicator::Header* SharedMemoryCommunicator::GetHeader() const noexcept
+{
+	/*
+		returns segment header
+	*/
+	return reinterpret_cast<Header*>(segment_);
+}
+
+size_t* SharedMemoryCommunicator::Counts(const int rank) const noexcept
+{
+	/*
+		returns message size slot of rank
+	*/
+	return reinterpret_cast<size_t*>(segment_ + sizeof(Header)) + rank;
+}
+
+char* SharedMemoryCommunicator::Mailbox(const int rank) const noexcept
+{
+	/*
+		returns mailbox of rank
+	*/
+	return segment_ + sizeof(Header) + size_ * sizeof(size_t) + rank * GetHeader()->capacity_;
+}
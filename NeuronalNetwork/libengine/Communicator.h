@@ -0,0 +1,83 @@
+//
+//  Communicator.h
+//  NeuronalNetwork
+//
+//  Created by Nicolas Fricker on 04/10/20.
+//  Copyright © 2020 Nicolas Fricker. All rights reserved.
+//
+
+#ifndef Communicator_
+#define Communicator_
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#pragma GCC visibility push(hidden)
+
+class Communicator
+{
+	/*
+		Abstract process group used to exchange spikes between partitions of a network
+		Mirrors MPI_Comm_rank, MPI_Comm_size, MPI_Barrier and MPI_Allgatherv
+		so a message passing backend can replace the shared memory transport
+	*/
+public:
+	virtual ~Communicator();
+
+	virtual const int Rank() const noexcept = 0;
+	virtual const int Size() const noexcept = 0;
+
+	virtual const void Barrier() noexcept = 0;
+	virtual const void Allgather(const void* send, const size_t bytes, std::vector<char>& recv, std::vector<size_t>& counts) noexcept = 0;
+};
+
+class SharedMemoryCommunicator: public Communicator
+{
+	/*
+		Communicator between local processes over a POSIX shared memory segment
+		every rank owns a fixed size mailbox, larger messages are exchanged in rounds
+	*/
+	struct Header
+	{
+		// set by rank 0 once the segment is initialized
+		std::atomic<int> a_ready_;
+		// number of ranks waiting at the barrier
+		std::atomic<int> a_waiting_;
+		// barrier generation, flips when all ranks arrived
+		std::atomic<int> a_generation_;
+		// mailbox capacity [bytes]
+		size_t capacity_;
+	};
+
+	// segment name
+	std::string name_;
+	// mapped segment
+	char* segment_ = nullptr;
+	// mapped segment size [bytes]
+	size_t bytes_ = 0;
+
+	int rank_ = 0;
+	int size_ = 1;
+
+public:
+	SharedMemoryCommunicator(const std::string name, const int rank, const int size, const size_t capacity = 1 << 20);
+	~SharedMemoryCommunicator();
+
+	static SharedMemoryCommunicator* Spawn(const int processes, const size_t capacity = 1 << 20);
+
+	const int Rank() const noexcept;
+	const int Size() const noexcept;
+
+	const void Barrier() noexcept;
+	const void Allgather(const void* send, const size_t bytes, std::vector<char>& recv, std::vector<size_t>& counts) noexcept;
+
+private:
+	Header* GetHeader() const noexcept;
+	size_t* Counts(const int rank) const noexcept;
+	char* Mailbox(const int rank) const noexcept;
+};
+
+#pragma GCC visibility pop
+#endif /* Communicator_ */
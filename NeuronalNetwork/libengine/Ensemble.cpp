@@ -0,0 +1,189 @@
+//
+//  Ensemble.cpp
+//  NeuronalNetwork
+//
+//  Created by Nicolas Fricker on 04/10/20.
+//  Copyright © 2020 Nicolas Fricker. All rights reserved.
+//
+
+#include "Ensemble.h"
+
+#include <algorithm>
+
+__attribute__((visibility("default"))) Ensemble::Ensemble(std::vector<int> layers, const int replicas, const uint64_t seed, const int threads)
+{
+	/*
+		layers = size of layers of every replica
+		replicas = number of replicas
+		seed = base seed of the replica streams
+		threads = number of worker threads, 0 uses all cores
+	*/
+	layers_sizes_ = std::move(layers);
+	replicas_ = std::max(replicas, 0);
+	seed_ = seed;
+
+	// initialize threadpool
+	threadpool_ = new ThreadPool<ReplicaThread, ReplicaArg, void*>(replicas_, threads);
+}
+
+__attribute__((visibility("default"))) Ensemble::~Ensemble()
+{
+	/*
+		Deconstructor
+	*/
+	if (threadpool_) {
+		delete threadpool_;
+	}
+}
+
+__attribute__((visibility("default"))) const void Ensemble::Run(const int bins) noexcept
+{
+	/*
+		bins = number of bins every replica integrates
+		runs all replicas and replaces the results of a previous run
+	*/
+	layers_.assign(layers_sizes_.size(), Statistics());
+	rates_.assign((size_t)replicas_ * layers_sizes_.size(), 0);
+
+	for (int r = 0; r < replicas_; r++) {
+		// add tasks to threadpool
+		threadpool_->set_task<Ensemble*, int, int>(this, r, bins);
+	}
+	// start thread pool
+	threadpool_->start();
+	// wait until threads have joined
+	threadpool_->join();
+}
+
+const void Ensemble::Simulate(const int replica, const int bins) noexcept
+{
+	/*
+		replica = replica index
+		bins = number of bins to integrate
+		builds the replica in the worker thread, integrates it serially and merges its accumulators
+	*/
+	NeuronalNetwork network(layers_sizes_);
+	network.SetSerial(true);
+
+	neurons_t& neurons = network.GetNeurons();
+
+	for (int i = 0; i < neurons.size(); i++) {
+		// independent stream of every neuron of every replica
+		neurons[i].Randomize((seed_ + replica) * 0x9e3779b97f4a7c15ULL + i);
+		// replicas are only summarized
+		neurons[i].Record(false);
+	}
+
+	network.Step(bins);
+
+	std::vector<Statistics> layers(layers_sizes_.size());
+
+	for (int l = 0; l < layers_sizes_.size(); l++) {
+		layers[l] = network.GetLayerStatistics(l);
+	}
+
+	// lock result mutex
+	pthread_mutex_lock(&s_result_m_);
+
+	for (int l = 0; l < layers_sizes_.size(); l++) {
+		layers_[l].Merge(layers[l]);
+		// spikes per neuron per second
+		rates_[(size_t)replica * layers_sizes_.size() + l] = (layers_sizes_[l] > 0 && bins > 0) ? 1000.0 * layers[l].GetSpikes() / (layers_sizes_[l] * bins * network.GetTimeStep()) : 0;
+	}
+
+	// unlock result mutex
+	pthread_mutex_unlock(&s_result_m_);
+}
+
+__attribute__((visibility("default"))) const int Ensemble::GetReplicas() const noexcept
+{
+	/*
+		Getter replicas_
+	*/
+	return replicas_;
+}
+
+__attribute__((visibility("default"))) const Statistics& Ensemble::GetLayerStatistics(const int layer) const noexcept
+{
+	/*
+		layer = layer index
+		returns the accumulators of the layer merged over all replicas
+	*/
+	return layers_[layer];
+}
+
+__attribute__((visibility("default"))) const double Ensemble::GetRate(const int replica, const int layer) const noexcept
+{
+	/*
+		returns the firing rate [Hz] of a layer of a replica
+	*/
+	return rates_[(size_t)replica * layers_sizes_.size() + layer];
+}
+
+__attribute__((visibility("default"))) const std::vector<double>& Ensemble::GetRates() const noexcept
+{
+	/*
+		returns the firing rates [Hz] of every layer of every replica, replica major
+	*/
+	return rates_;
+}
+
+Ensemble::ReplicaArg::ReplicaArg() {}
+
+Ensemble::ReplicaArg::ReplicaArg(Ensemble* ensemble, const int replica, const int bins)
+{
+	ensemble_ = ensemble;
+	replica_ = replica;
+	bins_ = bins;
+}
+
+// move constructor
+Ensemble::ReplicaArg::ReplicaArg(ReplicaArg&& other): ensemble_(std::move(other.ensemble_)), replica_(std::move(other.replica_)), bins_(std::move(other.bins_)) {}
+
+Ensemble::ReplicaArg::~ReplicaArg() {}
+
+Ensemble::ReplicaThread::ReplicaThread(std::vector<ReplicaArg>* queue, void* results, std::atomic<int>* count)
+{
+	queue_ = queue;
+	results_ = results;
+	a_count_ = count;
+}
+
+// move construtor
+Ensemble::ReplicaThread::ReplicaThread(ReplicaThread&& other): queue_(std::move(other.queue_)), results_(std::move(other.results_)), a_count_(std::move(other.a_count_)) {}
+
+Ensemble::ReplicaThread::~ReplicaThread() {}
+
+void* Ensemble::ReplicaThread::run() noexcept
+{
+	/*
+		overwritten virtual run function
+		pulls whole replicas from the queue until it is empty
+	*/
+	ReplicaArg arg;
+
+	while (true) {
+		// lock queue mutex
+		pthread_mutex_lock(&s_queue_m_);
+		// breaks while loop if queue is empty or stopped flag is triggered
+		if (queue_->empty() || stopped()) {
+			// unlock queue mutex
+			pthread_mutex_unlock(&s_queue_m_);
+			break;
+		}
+		// moves replica argument from back of queue to local variable
+		arg = std::move(queue_->back());
+		// pop last element in the queue
+		queue_->pop_back();
+		// unlock queue mutex
+		pthread_mutex_unlock(&s_queue_m_);
+
+		if (arg.ensemble_) {
+			arg.ensemble_->Simulate(arg.replica_, arg.bins_);
+		}
+		// increments count
+		(*a_count_)++;
+	}
+
+	return NULL;
+}
@@ -0,0 +1,109 @@
+//
+//  Ensemble.h
+//  NeuronalNetwork
+//
+//  Created by Nicolas Fricker on 04/10/20.
+//  Copyright © 2020 Nicolas Fricker. All rights reserved.
+//
+
+#ifndef Ensemble_
+#define Ensemble_
+
+#include "NeuronalNetwork.h"
+#include "Statistics.h"
+#include "ThreadPool.hpp"
+
+#include <pthread.h>
+
+#include <cstdint>
+#include <vector>
+
+#pragma GCC visibility push(hidden)
+
+class Ensemble
+{
+	/*
+		Monte Carlo runner of independent replicas of a small network
+		every worker thread builds, integrates and aggregates whole replicas serially,
+		no thread handoff happens within a bin, throughput scales with the number of cores
+		replica r draws the currents of its neurons from its own stream seed_ + r
+	*/
+	// forward declaration of argument class
+	class ReplicaArg;
+	// forward declaration of thread class
+	class ReplicaThread;
+
+	// size of layers of every replica
+	std::vector<int> layers_sizes_;
+	// number of replicas
+	int replicas_ = 0;
+	// base seed of the replica streams
+	uint64_t seed_ = 0;
+
+	// accumulators of every layer merged over all replicas
+	std::vector<Statistics> layers_;
+	// firing rate [Hz] of every layer of every replica, replica major
+	std::vector<double> rates_;
+
+	// threadpool pointer, one replica per task
+	ThreadPool<ReplicaThread, ReplicaArg, void*>* threadpool_ = nullptr;
+
+	// static mutexes
+	inline static pthread_mutex_t s_queue_m_ = PTHREAD_MUTEX_INITIALIZER;
+	inline static pthread_mutex_t s_result_m_ = PTHREAD_MUTEX_INITIALIZER;
+
+public:
+	Ensemble(std::vector<int> layers, const int replicas, const uint64_t seed = 0, const int threads = 0);
+	~Ensemble();
+
+	Ensemble(const Ensemble& other) = delete;
+	Ensemble& operator=(const Ensemble& other) = delete;
+
+	const void Run(const int bins) noexcept;
+
+	const int GetReplicas() const noexcept;
+	const Statistics& GetLayerStatistics(const int layer) const noexcept;
+	const double GetRate(const int replica, const int layer) const noexcept;
+	const std::vector<double>& GetRates() const noexcept;
+
+private:
+	const void Simulate(const int replica, const int bins) noexcept;
+
+	struct ReplicaArg
+	{
+	public:
+		// ensemble the replica belongs to
+		Ensemble* ensemble_ = nullptr;
+		// replica index
+		int replica_ = 0;
+		// number of bins to integrate
+		int bins_ = 0;
+
+		ReplicaArg();
+		ReplicaArg(Ensemble* ensemble, const int replica, const int bins);
+		ReplicaArg(ReplicaArg&& other);
+		~ReplicaArg();
+
+		ReplicaArg& operator=(const ReplicaArg& other) = default;
+	};
+
+	class ReplicaThread: public ThreadPool<ReplicaThread, ReplicaArg, void*>::Thread_
+	{
+		// queue pointer of arguments
+		std::vector<ReplicaArg>* queue_ = nullptr;
+		// result pointer (unused in this case)
+		void* results_ = nullptr;
+		// atomic count pointer
+		std::atomic<int>* a_count_ = nullptr;
+
+	public:
+		explicit ReplicaThread(std::vector<ReplicaArg>* queue, void* results, std::atomic<int>* count);
+		ReplicaThread(ReplicaThread&& other);
+		~ReplicaThread();
+
+		void* run() noexcept;
+	};
+};
+
+#pragma GCC visibility pop
+#endif /* Ensemble_ */
@@ -0,0 +1,135 @@
+//
+//  FastMath.hpp
+//  NeuronalNetwork
+//
+//  Created by Nicolas Fricker on 04/10/20.
+//  Copyright © 2020 Nicolas Fricker. All rights reserved.
+//
+
+#ifndef FastMath_
+#define FastMath_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#pragma GCC visibility push(hidden)
+
+class FastMath
+{
+	/*
+		Branch free exponential used by the Hodgkin-Huxley kernels
+		inlined in the integration loops instead of calling libm, vectorizable over arrays
+		(the range clamps only if-convert without trapping math, see the Makefile flags)
+		relative error below 1e-15 over [-708, 709]
+	*/
+
+	// log2(e)
+	inline constexpr static const double s_log2e_ = 1.4426950408889634;
+	// ln(2) split in a high part exact in double and a low correction
+	inline constexpr static const double s_ln2_hi_ = 6.93147180369123816490e-01;
+	inline constexpr static const double s_ln2_lo_ = 1.90821492927058770002e-10;
+	// 1.5 * 2^52, adding it rounds to the nearest integer in the low mantissa bits
+	inline constexpr static const double s_shift_ = 6755399441055744.0;
+	// argument range of finite normal results
+	inline constexpr static const double s_min_ = -708.0;
+	inline constexpr static const double s_max_ = 709.0;
+
+public:
+	static inline double Exp(double x) noexcept;
+	static inline void Exp(const double* x, double* y, const size_t n) noexcept;
+
+	static inline double Pow3(const double x) noexcept;
+	static inline double Pow4(const double x) noexcept;
+
+private:
+	static inline int64_t Bits(const double x) noexcept;
+	static inline double Double(const int64_t x) noexcept;
+};
+
+#pragma GCC visibility pop
+
+inline double FastMath::Exp(double x) noexcept
+{
+	/*
+		exp(x) = 2^k * exp(r), x = k * ln(2) + r, |r| <= ln(2) / 2
+	*/
+	x = (x < s_min_) ? s_min_ : x;
+	x = (x > s_max_) ? s_max_ : x;
+
+	// k rounded to nearest, its integer value sits in the low bits of t
+	const double t = x * s_log2e_ + s_shift_;
+	const double k = t - s_shift_;
+
+	// reduced argument
+	const double r = (x - k * s_ln2_hi_) - k * s_ln2_lo_;
+
+	// minimax polynomial of degree 10 on |r| <= ln(2) / 2, relative error 2.1e-16, Horner scheme
+	double p = 2.748842976426718e-07;
+	p = p * r + 2.763978468182758e-06;
+	p = p * r + 2.4801917819867798e-05;
+	p = p * r + 0.00019841171345023935;
+	p = p * r + 0.001388888849890477;
+	p = p * r + 0.008333333384696422;
+	p = p * r + 0.04166666666842742;
+	p = p * r + 0.16666666666557656;
+	p = p * r + 0.49999999999997286;
+	p = p * r + 1.0000000000000064;
+	p = p * r + 1.0;
+
+	// 2^k assembled in the exponent bits
+	const double scale = Double((Bits(t) - Bits(s_shift_) + 1023) << 52);
+
+	return p * scale;
+}
+
+inline void FastMath::Exp(const double* x, double* y, const size_t n) noexcept
+{
+	/*
+		x = array of arguments
+		y = array of results
+		n = array size
+	*/
+	for (size_t i = 0; i < n; i++) {
+		y[i] = Exp(x[i]);
+	}
+}
+
+inline double FastMath::Pow3(const double x) noexcept
+{
+	/*
+		x^3 expanded to multiplications
+	*/
+	return x * x * x;
+}
+
+inline double FastMath::Pow4(const double x) noexcept
+{
+	/*
+		x^4 expanded to multiplications
+	*/
+	const double x2 = x * x;
+	return x2 * x2;
+}
+
+inline int64_t FastMath::Bits(const double x) noexcept
+{
+	/*
+		bit pattern of a double
+	*/
+	int64_t i;
+	memcpy(&i, &x, sizeof(i));
+	return i;
+}
+
+inline double FastMath::Double(const int64_t x) noexcept
+{
+	/*
+		double of a bit pattern
+	*/
+	double d;
+	memcpy(&d, &x, sizeof(d));
+	return d;
+}
+
+#endif /* FastMath_ */
@@ -7,12 +7,15 @@
 //
 
 #include "Neuron.h"
+#include "FastMath.hpp"
 
+#include <algorithm>
 #include <cstdlib>
 #include <cmath>
+#include <cstring>
 
 
-Neuron::Neuron(neuron_t neuron_id, const int num_bins, const int max_neighbors)
+Neuron::Neuron(neuron_t neuron_id, const int num_bins, const int max_neighbors, Arena* arena): neighbors_(ArenaAllocator<Neuron*>(arena)), weights_(ArenaAllocator<double>(arena)), history_(ArenaAllocator<double>(arena)), a_delayed_(ArenaAllocator<std::atomic<double>>(arena))
 {
 	id_ = neuron_id;
 	neighbors_.reserve(max_neighbors);
@@ -21,7 +24,7 @@ Neuron::Neuron(neuron_t neuron_id, const int num_bins, const int max_neighbors)
 	nc_ = Rand(0.001, 0.005);
 }
 
-Neuron::Neuron(neuron_t neuron_id, const double oc, const double nc, const int num_bins, const int max_neighbors)
+Neuron::Neuron(neuron_t neuron_id, const double oc, const double nc, const int num_bins, const int max_neighbors, Arena* arena): neighbors_(ArenaAllocator<Neuron*>(arena)), weights_(ArenaAllocator<double>(arena)), history_(ArenaAllocator<double>(arena)), a_delayed_(ArenaAllocator<std::atomic<double>>(arena))
 {
 	id_ = neuron_id;
 	neighbors_.reserve(max_neighbors);
@@ -30,7 +33,7 @@ Neuron::Neuron(neuron_t neuron_id, const double oc, const double nc, const int n
 	nc_ = nc;
 }
 
-Neuron::Neuron(neuron_t neuron_id, const double Vm, const double Cm, const double n, const double m, const double h, const int num_bins, const int max_neighbors)
+Neuron::Neuron(neuron_t neuron_id, const double Vm, const double Cm, const double n, const double m, const double h, const int num_bins, const int max_neighbors, Arena* arena): neighbors_(ArenaAllocator<Neuron*>(arena)), weights_(ArenaAllocator<double>(arena)), history_(ArenaAllocator<double>(arena)), a_delayed_(ArenaAllocator<std::atomic<double>>(arena))
 {
 	id_ = neuron_id;
 	neighbors_.reserve(max_neighbors);
@@ -50,21 +53,56 @@ Neuron::Neuron(Neuron&& other)
 		move constructor
 	*/
 	a_Isum_ = other.a_Isum_.load();
+	a_delayed_ = std::move(other.a_delayed_);
 	
 	postsynaptic_ = std::move(other.postsynaptic_);
 	neighbors_ = std::move(other.neighbors_);
+	range_ = other.range_;
+	range_count_ = other.range_count_;
+	weights_ = std::move(other.weights_);
+	events_ = std::move(other.events_);
 	history_ = std::move(other.history_);
+	spikes_ = std::move(other.spikes_);
+	stats_ = std::move(other.stats_);
 	
-	n_ = std::move(other.n_);
-	m_ = std::move(other.m_);
-	h_ = std::move(other.h_);
+	Vm_ = other.Vm_;
+	Cm_ = other.Cm_;
+	n_ = other.n_;
+	m_ = other.m_;
+	h_ = other.h_;
+	dh_ = other.dh_;
+	dn_ = other.dn_;
 	
-	oc_ = std::move(other.oc_);
-	nc_ = std::move(other.nc_);
+	substep_ = other.substep_;
+	std::copy(other.past_time_, other.past_time_ + 2, past_time_);
+	std::copy(other.past_Vm_, other.past_Vm_ + 2, past_Vm_);
+	past_input_ = other.past_input_;
+	past_count_ = other.past_count_;
+	time_ = other.time_;
+	spike_time_ = other.spike_time_;
 	
-	id_ = std::move(other.id_);
+	oc_ = other.oc_;
+	nc_ = other.nc_;
 	
-	spiked_ = std::move(other.spiked_);
+	gain_ = other.gain_;
+	trace_plus_ = other.trace_plus_;
+	trace_minus_ = other.trace_minus_;
+	trace_time_ = other.trace_time_;
+	
+	updates_ = other.updates_;
+	idle_bins_ = other.idle_bins_;
+	bin_ = other.bin_;
+	
+	post_delay_ = other.post_delay_;
+	neighbor_delay_ = other.neighbor_delay_;
+	
+	id_ = other.id_;
+	
+	spiked_ = other.spiked_;
+	quiescent_ = other.quiescent_;
+	recording_ = other.recording_;
+	plastic_ = other.plastic_;
+	monitored_ = other.monitored_;
 }
 
 Neuron::~Neuron() {}
@@ -73,46 +111,386 @@ Neuron& Neuron::operator=(const Neuron& other)
 {
 	/*
 		equal operator copy assignment
+		copies the complete state, the containers keep their own allocator
 	*/
 	if (this != &other) {
 		a_Isum_ = other.a_Isum_.load();
 		
-		postsynaptic_ = other.postsynaptic_;
-		
-		neighbors_.clear();
-		for (int i = 0; i < other.neighbors_.size(); i++) {
-			neighbors_.emplace_back(other.neighbors_[i]);
+		a_delayed_ = decltype(a_delayed_)(other.a_delayed_.size(), a_delayed_.get_allocator());
+		for (int i = 0; i < other.a_delayed_.size(); i++) {
+			a_delayed_[i] = other.a_delayed_[i].load();
 		}
 		
-		history_.clear();
+		postsynaptic_ = other.postsynaptic_;
 		
-		for (int i = 0; i < other.history_.size(); i++) {
-			history_.emplace_back(other.history_[i]);
-		}
+		neighbors_.assign(other.neighbors_.begin(), other.neighbors_.end());
+		range_ = other.range_;
+		range_count_ = other.range_count_;
+		weights_.assign(other.weights_.begin(), other.weights_.end());
+		events_ = other.events_;
+		history_.assign(other.history_.begin(), other.history_.end());
+		spikes_ = other.spikes_;
+		stats_ = other.stats_;
 		
+		Vm_ = other.Vm_;
+		Cm_ = other.Cm_;
 		n_ = other.n_;
 		m_ = other.m_;
 		h_ = other.h_;
+		dh_ = other.dh_;
+		dn_ = other.dn_;
+		
+		substep_ = other.substep_;
+		std::copy(other.past_time_, other.past_time_ + 2, past_time_);
+		std::copy(other.past_Vm_, other.past_Vm_ + 2, past_Vm_);
+		past_input_ = other.past_input_;
+		past_count_ = other.past_count_;
+		time_ = other.time_;
+		spike_time_ = other.spike_time_;
 		
 		oc_ = other.oc_;
 		nc_ = other.nc_;
 		
+		gain_ = other.gain_;
+		trace_plus_ = other.trace_plus_;
+		trace_minus_ = other.trace_minus_;
+		trace_time_ = other.trace_time_;
+		
+		updates_ = other.updates_;
+		idle_bins_ = other.idle_bins_;
+		bin_ = other.bin_;
+		
+		post_delay_ = other.post_delay_;
+		neighbor_delay_ = other.neighbor_delay_;
+		
+		id_ = other.id_;
+		
 		spiked_ = other.spiked_;
+		quiescent_ = other.quiescent_;
+		recording_ = other.recording_;
+		plastic_ = other.plastic_;
+		monitored_ = other.monitored_;
 	}
 	
 	return *this;
 }
 
-const double Neuron::Process(const double dt) noexcept
+__attribute__((visibility("default"))) const void Neuron::Swap(Neuron& other) noexcept
+{
+	/*
+		exchanges the complete state of two neurons, used to renumber neurons in place
+		edges still point to the previous positions until Relink
+	*/
+	if (this == &other) {
+		return;
+	}
+	
+	std::swap(neighbors_, other.neighbors_);
+	std::swap(range_, other.range_);
+	std::swap(range_count_, other.range_count_);
+	std::swap(weights_, other.weights_);
+	std::swap(events_, other.events_);
+	std::swap(history_, other.history_);
+	std::swap(stats_, other.stats_);
+	std::swap(spikes_, other.spikes_);
+	std::swap(postsynaptic_, other.postsynaptic_);
+	
+	a_Isum_ = other.a_Isum_.exchange(a_Isum_.load());
+	std::swap(a_delayed_, other.a_delayed_);
+	
+	std::swap(Vm_, other.Vm_);
+	std::swap(Cm_, other.Cm_);
+	std::swap(n_, other.n_);
+	std::swap(m_, other.m_);
+	std::swap(h_, other.h_);
+	std::swap(dh_, other.dh_);
+	std::swap(dn_, other.dn_);
+	
+	std::swap(substep_, other.substep_);
+	std::swap(past_time_, other.past_time_);
+	std::swap(past_Vm_, other.past_Vm_);
+	std::swap(past_input_, other.past_input_);
+	std::swap(past_count_, other.past_count_);
+	std::swap(time_, other.time_);
+	std::swap(spike_time_, other.spike_time_);
+	
+	std::swap(oc_, other.oc_);
+	std::swap(nc_, other.nc_);
+	
+	std::swap(gain_, other.gain_);
+	std::swap(trace_plus_, other.trace_plus_);
+	std::swap(trace_minus_, other.trace_minus_);
+	std::swap(trace_time_, other.trace_time_);
+	
+	std::swap(updates_, other.updates_);
+	std::swap(idle_bins_, other.idle_bins_);
+	std::swap(bin_, other.bin_);
+	
+	std::swap(post_delay_, other.post_delay_);
+	std::swap(neighbor_delay_, other.neighbor_delay_);
+	
+	std::swap(id_, other.id_);
+	
+	std::swap(spiked_, other.spiked_);
+	std::swap(quiescent_, other.quiescent_);
+	std::swap(recording_, other.recording_);
+	std::swap(plastic_, other.plastic_);
+	std::swap(monitored_, other.monitored_);
+}
+
+__attribute__((visibility("default"))) const void Neuron::Relink(Neuron* first, const int* position, const size_t count) noexcept
+{
+	/*
+		first = first neuron of the renumbered array
+		position = new position of the neuron at every previous position
+		count = number of neurons in the array
+		points the neighbor and postsynaptic edges to the new positions of their neurons
+		a neighbor range is stored as edges first, the renumbered neighbors are no longer contiguous
+	*/
+	auto relink = [&](Neuron* neuron) {
+		const ptrdiff_t previous = neuron - first;
+		return (previous >= 0 && previous < count) ? first + position[previous] : neuron;
+	};
+	
+	for (size_t r = 0; r < range_count_; r++) {
+		neighbors_.emplace_back(range_ + r);
+	}
+	range_ = nullptr;
+	range_count_ = 0;
+	
+	for (int i = 0; i < neighbors_.size(); i++) {
+		neighbors_[i] = relink(neighbors_[i]);
+	}
+	
+	if (postsynaptic_) {
+		postsynaptic_ = relink(postsynaptic_);
+	}
+}
+
+const double Neuron::Process(const double dt, const int slow_interval) noexcept
 {
 	/*
 		dt = delta time
+		slow_interval = bins between updates of the slow gates h and n, 1 updates every gate every bin
 		sum of current retrived atomically
 		return HodgkinHuxley Model updated membrane potential
 	*/
-	const double Ic = a_Isum_.load();
-	a_Isum_ = 0;
-	return HodgkinHuxley(dt, Ic);
+	const double Ic = Input();
+	
+	if (!Wake(dt, Ic)) {
+		return Vm_;
+	}
+	
+	return HodgkinHuxley(dt, Ic, slow_interval);
+}
+
+const void Neuron::ProcessAdaptive(const double dt, const double tolerance, const int bins, const double* drive) noexcept
+{
+	/*
+		dt = delta time between spike exchanges
+		tolerance = accepted membrane potential error per sub-step [mV]
+		bins = number of consecutive bins to process, their input is known in advance
+		drive = stimulus current of every bin, nullptr without stimulus
+		integrates the bins with adaptive sub-steps of the exponential Euler update, their error estimated from the sub-steps before,
+		a sub-step grows across the bins of a run with the same input current, up to the next input change,
+		and ends on the bin boundary after a threshold crossing, spike times are interpolated at the crossing
+		bins ending above threshold spike, whether they end a sub-step or are crossed by one
+	*/
+	for (int i = 0; i < bins;) {
+		if (drive && drive[i] != 0) {
+			// stimulate neuron
+			InjectCurrent(drive[i]);
+		}
+		// skip neuron resting at a fixed point without input
+		if (Dormant()) {
+			Idle(dt);
+			i++;
+			continue;
+		}
+		
+		const double Ic = Input();
+		
+		if (!Wake(dt, Ic)) {
+			i++;
+			continue;
+		}
+		
+		// following bins with the same input current, delayed currents of the window are already delivered
+		int span = 1;
+		
+		while (i + span < bins) {
+			const double current = (drive ? drive[i + span] : 0) + (a_delayed_.empty() ? 0 : a_delayed_[(bin_ + span) % a_delayed_.size()].load());
+			if (current != Ic) {
+				break;
+			}
+			if (!a_delayed_.empty()) {
+				a_delayed_[(bin_ + span) % a_delayed_.size()].store(0);
+			}
+			span++;
+		}
+		
+		Span(dt, tolerance, span, Ic);
+		i += span;
+	}
+}
+
+const void Neuron::Span(const double dt, const double tolerance, const int bins, const double Ic) noexcept
+{
+	/*
+		dt = delta time between spike exchanges
+		tolerance = accepted membrane potential error per sub-step [mV]
+		bins = number of bins with the constant input current Ic
+		the membrane potential is updated with the gates of the middle of the sub-step, the gates with the rates of its end,
+		second order as the fixed step update whatever the sub-step lengths, a sub-step costs one update of the rates
+		and its rejection a membrane update only
+		sub-steps only cross a bin boundary if they do not cross the threshold, the membrane potential of the crossed bins is interpolated
+	*/
+	// state and time at the start of the run
+	const double V0 = Vm_, m0 = m_, h0 = h_, n0 = n_;
+	const double start = time_;
+	
+	// elapsed time inside the run, its length and the number of bins closed
+	double t = 0;
+	const double end = bins * dt;
+	int closed = 0;
+	// planned sub-step, carried over from the previous run
+	double step = (substep_ > 0) ? substep_ : dt;
+	// sub-step ends on the next bin boundary
+	bool bounded = false;
+	// threshold crossing inside the current bin
+	bool crossed = false;
+	
+	if (Ic != past_input_) {
+		// the error estimate restarts with the input current
+		past_input_ = Ic;
+		past_count_ = 0;
+	}
+	// time the gates lead the membrane potential, half of the first sub-step of a run
+	double lead = 0.5 * std::min(step, dt);
+	
+	while (closed < bins) {
+		// next bin boundary
+		const double boundary = (closed + 1) * dt;
+		// attempted sub-step, clipped to the end of the run or to the boundary,
+		// at most one bin until the error can be estimated, as the fixed step update
+		const double limit = bounded ? boundary : end;
+		const double planned = (past_count_ < 2) ? std::min(step, dt) : step;
+		const bool clipped = planned >= limit - t;
+		const double h = clipped ? limit - t : planned;
+		const double t1 = clipped ? limit : t + h;
+		
+		if (lead != 0.5 * h) {
+			// gates moved to the middle of a sub-step other than the planned one
+			Gates(Vm_, m_, h_, n_, 0.5 * h - lead);
+			lead = 0.5 * h;
+			updates_++;
+		}
+		
+		// membrane potential of the step with the gates of its middle
+		const double V1 = Membrane(Vm_, m_, h_, n_, Cm_, h, Ic);
+		
+		updates_++;
+		
+		// local error estimate, the quadratic through the two accepted sub-steps before and the start of the step
+		// extrapolated to its end differs from the step by O(step^3) as the local error
+		double error = 0;
+		
+		if (past_count_ == 2) {
+			const double a = past_time_[0] - (start + t);
+			const double b = past_time_[1] - (start + t);
+			const double predicted = past_Vm_[0] * (h - b) * h / ((a - b) * a) + past_Vm_[1] * (h - a) * h / ((b - a) * b) + Vm_ * (h - a) * (h - b) / (a * b);
+			error = std::fabs(V1 - predicted);
+		}
+		
+		if (error > tolerance && h > s_min_substep_) {
+			// reject and shrink step
+			step = std::max(s_min_substep_, h * std::max(0.25, 0.9 * std::cbrt(tolerance / error)));
+			bounded = false;
+			continue;
+		}
+		
+		if ((Vm_ >= s_Vthreashold_) != (V1 >= s_Vthreashold_) && t1 > boundary) {
+			// a bin with a threshold crossing is closed on its boundary, retry up to it
+			bounded = true;
+			continue;
+		}
+		
+		bounded = false;
+		
+		// interpolate threshold crossing time on an upstroke
+		if (Vm_ < s_Vthreashold_ && V1 >= s_Vthreashold_) {
+			spike_time_ = start + t + h * (s_Vthreashold_ - Vm_) / (V1 - Vm_);
+			stats_.Spike(spike_time_);
+			if (plastic_ || monitored_) {
+				events_.push_back(spike_time_);
+			}
+			crossed = true;
+		}
+		
+		// bins crossed by the step, their membrane potential is the quadratic through the ends of the step
+		// and the sub-step before, or lies between the ends of the step at the start of the run
+		for (double b = (closed + 1) * dt; closed < bins - 1 && b < t1; b = (closed + 1) * dt) {
+			const double x = b - t;
+			const double a = past_time_[1] - (start + t);
+			const double curvature = (past_count_ > 0) ? ((past_Vm_[1] - Vm_) / a - (V1 - Vm_) / h) / (a - h) : 0;
+			Close(dt, Vm_ + (V1 - Vm_) * x / h + curvature * x * (x - h), crossed);
+			closed++;
+			crossed = false;
+		}
+		
+		past_time_[0] = past_time_[1];
+		past_Vm_[0] = past_Vm_[1];
+		past_time_[1] = start + t;
+		past_Vm_[1] = Vm_;
+		past_count_ = std::min(past_count_ + 1, 2);
+		
+		t = t1;
+		// grow step, the local error is O(step^3), at most by s_max_growth_ as the estimate extrapolates over the step,
+		// a clipped step keeps the planned length
+		const double grown = h * std::min(s_max_growth_, 0.9 * std::cbrt(tolerance / std::max(error, 1e-12)));
+		step = (past_count_ < 2) ? step : clipped ? std::max(step, grown) : grown;
+		
+		// the gates advance to the middle of the next sub-step, one bin at most at the end of the run
+		const double next = (t1 == end) ? std::min(step, dt) : std::min(step, end - t1);
+		Vm_ = V1;
+		Gates(Vm_, m_, h_, n_, lead + 0.5 * next);
+		lead = 0.5 * next;
+		
+		if (t1 == (closed + 1) * dt || t1 == end) {
+			// a spike is kept even if the membrane repolarized within the bin
+			Close(dt, Vm_, crossed);
+			closed++;
+			crossed = false;
+		}
+	}
+	
+	substep_ = step;
+	
+	Settle(end, Ic, V0, m0, h0, n0);
+}
+
+const void Neuron::Close(const double dt, const double Vm, const bool crossed) noexcept
+{
+	/*
+		dt = delta time
+		Vm = membrane potential at the end of the bin
+		crossed = threshold crossing inside the bin
+		stores the membrane potential of an adaptively integrated bin and logs its spike
+	*/
+	if (recording_) {
+		Store(Vm);
+	}
+	stats_.Add(Vm);
+	
+	spiked_ = (Vm >= s_Vthreashold_) || crossed;
+	
+	if (spiked_) {
+		// delivered by the network once the layer or window is integrated
+		spikes_.emplace_back(bin_, Vm);
+	}
+	
+	time_ += dt;
+	bin_++;
 }
 
 const void Neuron::InjectCurrent(const double input) noexcept
@@ -121,7 +499,129 @@ const void Neuron::InjectCurrent(const double input) noexcept
 		input = input current in µA
 		sums up currents atomically
 	*/
-	a_Isum_.store(a_Isum_.load() + input);
+	Accumulate(a_Isum_, input);
+}
+
+const void Neuron::InjectCurrent(const double input, const size_t bin) noexcept
+{
+	/*
+		input = input current in µA
+		bin = bin in which the current is received
+		sums up delayed currents atomically in the ring buffer
+	*/
+	Accumulate(a_delayed_[bin % a_delayed_.size()], input);
+}
+
+__attribute__((visibility("default"))) const void Neuron::Record(const bool record) noexcept
+{
+	/*
+		record = false keeps only the streaming accumulators, the history log stays empty
+	*/
+	recording_ = record;
+}
+
+__attribute__((visibility("default"))) const void Neuron::Trace(char* samples) noexcept
+{
+	/*
+		samples = record opened by TraceWriter::Reserve the following bins are stored to, nullptr returns to the history log
+		the skipped bins so far are written out first, to the log or record they belong to
+	*/
+	if (idle_bins_ > 0) {
+		Flush();
+	}
+	trace_ = samples;
+}
+
+__attribute__((visibility("default"))) const void Neuron::Monitor(const bool monitor) noexcept
+{
+	/*
+		monitor = true logs the time of every spike until the network publishes it
+	*/
+	monitored_ = monitor;
+	
+	if (!monitor && !plastic_) {
+		events_.clear();
+	}
+}
+
+__attribute__((visibility("default"))) std::vector<std::pair<size_t, double>>& Neuron::GetSpikes() noexcept
+{
+	/*
+		returns log of spikes (bin, Vm) not yet delivered
+	*/
+	return spikes_;
+}
+
+const void Neuron::Transmit(const size_t bin, const double Vm, const bool neighbors) noexcept
+{
+	/*
+		bin = bin in which the spike occured
+		Vm = membrane potential of the spike
+		neighbors = false once the neighbors received the current within the bin of the spike
+		propagates output current to postsynaptic Neuron and neighboring current to neighboring Neurons
+		for processing in the next bin of the target, or in bin + delay through the delayed input ring buffers
+		the network transmits the spikes of a layer or window in (bin, id) order once they are integrated,
+		so the input of every neuron is summed in the same order whatever thread or process integrated its sources
+	*/
+	if (postsynaptic_) {
+		// increment postsynaptic neuron's current by transmitted output current
+		if (post_delay_ > 0) {
+			postsynaptic_->InjectCurrent(oc_ * gain_, bin + post_delay_);
+		} else {
+			postsynaptic_->InjectCurrent(oc_ * gain_);
+		}
+	}
+	
+	if (!neighbors || !HasNeighbors()) {
+		return;
+	}
+	
+	// same current for all neighbors, scaled by the plastic gains
+	const double current = NeighborCurrent(Vm);
+	
+	auto transmit = [&](Neuron* neighbor, const double gain) {
+		// increment neighboring neurons' current exponentially
+		if (neighbor_delay_ > 0) {
+			neighbor->InjectCurrent(current * gain, bin + neighbor_delay_);
+		} else {
+			neighbor->InjectCurrent(current * gain);
+		}
+	};
+
+	for (int i = 0; i < neighbors_.size(); i++) {
+		if (neighbors_[i]) {
+			transmit(neighbors_[i], plastic_ ? weights_[i] : 1.0);
+		}
+	}
+	
+	// the gains of the range follow those of the stored edges
+	const size_t stored = neighbors_.size();
+	for (size_t r = 0; r < range_count_; r++) {
+		transmit(range_ + r, plastic_ ? weights_[stored + r] : 1.0);
+	}
+}
+
+const bool Neuron::Dormant() noexcept
+{
+	/*
+		returns true if the cell rests at a fixed point without pending input current
+	*/
+	return quiescent_ && a_Isum_.load() == 0 && (a_delayed_.empty() || a_delayed_[bin_ % a_delayed_.size()].load() == 0);
+}
+
+const void Neuron::Idle(const double dt) noexcept
+{
+	/*
+		dt = delta time
+		skips integration of a dormant cell, the bin is recorded lazily
+	*/
+	idle_bins_++;
+	time_ += dt;
+	// the adaptive error estimate restarts after the skipped bins, the slow gates are held until their next update
+	past_count_ = 0;
+	dh_ = dn_ = 0;
+	spiked_ = false;
+	bin_++;
 }
 
 __attribute__((visibility("default"))) const void Neuron::AddPostsynapticNeuron(Neuron* postsynaptic) noexcept
@@ -132,91 +632,399 @@ __attribute__((visibility("default"))) const void Neuron::AddPostsynapticNeuron(
 	postsynaptic_ = postsynaptic;
 }
 
-__attribute__((visibility("default"))) const void Neuron::AddNeighbor(Neuron* neighbor) noexcept
+__attribute__((visibility("default"))) const void Neuron::AddNeighbor(Neuron* neighbor) noexcept
+{
+	/*
+		stores neighboring Neuron pointer
+	*/
+	neighbors_.emplace_back(neighbor);
+}
+
+__attribute__((visibility("default"))) const void Neuron::AddNeighbors(Neuron* first, const size_t count) noexcept
+{
+	/*
+		first = first neighboring Neuron of a contiguous array, the neuron itself is not among them
+		count = number of neighbors
+		keeps the range instead of one pointer per edge, a second range is stored as edges
+	*/
+	if (range_count_ > 0) {
+		for (size_t r = 0; r < count; r++) {
+			neighbors_.emplace_back(first + r);
+		}
+		return;
+	}
+	
+	range_ = first;
+	range_count_ = count;
+}
+
+__attribute__((visibility("default"))) const void Neuron::SetPostsynapticDelay(const int delay) noexcept
+{
+	/*
+		delay = transmission delay to the postsynaptic neuron (bins)
+	*/
+	post_delay_ = delay;
+}
+
+__attribute__((visibility("default"))) const void Neuron::SetNeighborDelay(const int delay) noexcept
+{
+	/*
+		delay = transmission delay to the neighboring neurons (bins)
+	*/
+	neighbor_delay_ = delay;
+}
+
+__attribute__((visibility("default"))) const void Neuron::ReserveDelays(const int length) noexcept
+{
+	/*
+		length = number of bins held by the delayed input ring buffer
+	*/
+	if (length > a_delayed_.size()) {
+		a_delayed_ = decltype(a_delayed_)(length, a_delayed_.get_allocator());
+	}
+}
+
+const void Neuron::ReserveHistory(const size_t bins) noexcept
+{
+	/*
+		bins = number of samples the history log holds without reallocation
+		an arena does not take blocks back, a log outgrowing its arena block moves to the heap
+		instead of leaving every outgrown block in the arena
+	*/
+	if (bins <= history_.capacity()) {
+		return;
+	}
+	
+	if (!history_.get_allocator().arena()) {
+		history_.reserve(bins);
+		return;
+	}
+	
+	history_t grown;
+	grown.reserve(bins);
+	grown.assign(history_.begin(), history_.end());
+	history_ = std::move(grown);
+}
+
+__attribute__((visibility("default"))) const void Neuron::EnablePlasticity() noexcept
+{
+	/*
+		makes the outgoing edges plastic, every neighbor edge gets its own gain
+		called once the neighbors are established
+	*/
+	plastic_ = true;
+	weights_.assign(GetNeighborCount(), 1.0);
+}
+
+const bool Neuron::Learn(const Neuron* first, const uint64_t* spiked) noexcept
+{
+	/*
+		first = first neuron of the array the targets are stored in
+		spiked = one bit per position in that array of the neurons with spikes since the last pass
+		updates the gains of the outgoing edges from the spikes since the last pass
+		pairs every postsynaptic spike with the presynaptic trace (potentiation)
+		and every presynaptic spike with the postsynaptic trace (depression)
+		gains and targets are walked as contiguous arrays, edges without spikes at either end are skipped
+		without touching the target
+		returns true if a gain changed
+	*/
+	bool changed = false;
+	
+	auto fired = [first, spiked](const Neuron* target) {
+		const size_t position = target - first;
+		return (spiked[position >> 6] >> (position & 63)) & 1;
+	};
+	
+	if (postsynaptic_ && (!events_.empty() || fired(postsynaptic_))) {
+		gain_ = std::clamp(gain_ + Plasticity(*postsynaptic_), 0.0, s_max_gain_);
+		changed = true;
+	}
+	
+	// neighbor edges without gains are not plastic
+	if (weights_.empty()) {
+		return changed;
+	}
+	
+	Neuron* const* neighbors = neighbors_.data();
+	double* weights = weights_.data();
+	const size_t count = neighbors_.size();
+	
+	for (size_t i = 0; i < count; i++) {
+		if (!neighbors[i] || (events_.empty() && !fired(neighbors[i]))) {
+			continue;
+		}
+		weights[i] = std::clamp(weights[i] + Plasticity(*neighbors[i]), 0.0, s_max_gain_);
+		changed = true;
+	}
+	
+	// the range follows the stored edges
+	weights += count;
+	for (size_t r = 0; r < range_count_; r++) {
+		if (events_.empty() && !fired(range_ + r)) {
+			continue;
+		}
+		weights[r] = std::clamp(weights[r] + Plasticity(range_[r]), 0.0, s_max_gain_);
+		changed = true;
+	}
+	
+	return changed;
+}
+
+const void Neuron::Consolidate() noexcept
+{
+	/*
+		folds the spikes since the last pass into the traces, once all edges are updated
+	*/
+	for (int i = 0; i < events_.size(); i++) {
+		if (trace_time_ >= 0) {
+			trace_plus_ *= FastMath::Exp(-(events_[i] - trace_time_) / s_tau_plus_);
+			trace_minus_ *= FastMath::Exp(-(events_[i] - trace_time_) / s_tau_minus_);
+		}
+		trace_plus_ += 1;
+		trace_minus_ += 1;
+		trace_time_ = events_[i];
+	}
+	events_.clear();
+}
+
+const bool Neuron::HasEvents() const noexcept
+{
+	/*
+		returns true if the neuron spiked since the last plasticity pass
+	*/
+	return !events_.empty();
+}
+
+const std::vector<double>& Neuron::GetEvents() const noexcept
+{
+	/*
+		returns the spike times [ms] since the last plasticity pass or publication
+	*/
+	return events_;
+}
+
+const void Neuron::ClearEvents() noexcept
+{
+	/*
+		drops the spike times once published, networks without plasticity never consolidate them
+	*/
+	events_.clear();
+}
+
+__attribute__((visibility("default"))) const double Neuron::GetGain() const noexcept
+{
+	/*
+		Getter gain_
+	*/
+	return gain_;
+}
+
+__attribute__((visibility("default"))) const double Neuron::GetNeighborGain(const int index) const noexcept
+{
+	/*
+		returns plastic gain of the neighbor edge, 1 without plasticity
+	*/
+	return plastic_ ? weights_[index] : 1.0;
+}
+
+__attribute__((visibility("default"))) const void Neuron::SetPlasticity(const double a_plus, const double a_minus, const double tau_plus, const double tau_minus, const double max_gain) noexcept
+{
+	/*
+		a_plus, a_minus = gain change of a pre-post and a post-pre spike pair at zero lag
+		tau_plus, tau_minus = trace decay time constants [ms]
+		max_gain = upper bound of the gains
+	*/
+	Neuron::s_a_plus_ = a_plus;
+	Neuron::s_a_minus_ = a_minus;
+	Neuron::s_tau_plus_ = tau_plus;
+	Neuron::s_tau_minus_ = tau_minus;
+	Neuron::s_max_gain_ = max_gain;
+}
+
+__attribute__((visibility("default"))) const void Neuron::SetMembranePotential(const double Vm) noexcept
+{
+	/*
+		Vm = membrane potential (mV)
+	*/
+	Vm_ = Vm;
+}
+
+__attribute__((visibility("default"))) const void Neuron::SetMembraneCapacitance(const double Cm) noexcept
+{
+	/*
+		Cm = Membrane Capacitance Density assignment (C)
+	*/
+	Cm_ = Cm;
+}
+
+__attribute__((visibility("default"))) const void Neuron::SetOutputCurrent(const double oc) noexcept
+{
+	/*
+		oc = output current (µA)
+	*/
+	oc_ = oc;
+}
+
+__attribute__((visibility("default"))) const void Neuron::SetNeighboringInfluence(const double nc) noexcept
+{
+	/*
+		nc = neighboring current influence (µA)
+	*/
+	nc_ = nc;
+}
+
+__attribute__((visibility("default"))) const void Neuron::Randomize(const uint64_t seed) noexcept
+{
+	/*
+		seed = random stream of this neuron
+		draws the output and neighboring currents from the ranges of the constructor
+		without the shared rand() state, independent replicas draw in parallel
+	*/
+	uint64_t x = seed;
+	double f[2];
+	
+	for (int i = 0; i < 2; i++) {
+		// splitmix64
+		x += 0x9e3779b97f4a7c15ULL;
+		uint64_t z = x;
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+		z ^= z >> 31;
+		f[i] = (double)(z >> 11) * (1.0 / 9007199254740992.0);
+	}
+	
+	oc_ = 0.01 + f[0] * (0.05 - 0.01);
+	nc_ = 0.001 + f[1] * (0.005 - 0.001);
+}
+
+__attribute__((visibility("default"))) const void Neuron::Skip() noexcept
+{
+	/*
+		draws the currents of a neuron that is not constructed from the shared rand() state,
+		the neurons constructed afterwards get the currents they would get after it
+	*/
+	Rand(0.01, 0.05);
+	Rand(0.001, 0.005);
+}
+
+__attribute__((visibility("default"))) const double Neuron::GetMembranePotential() const noexcept
+{
+	/*
+		Getter Vm_
+	*/
+	return Vm_;
+}
+
+__attribute__((visibility("default"))) const double Neuron::GetMembraneCapacitance() const noexcept
+{
+	/*
+		Getter Cm_
+	*/
+	return Cm_;
+}
+
+__attribute__((visibility("default"))) const double Neuron::GetOutputCurrent() const noexcept
+{
+	/*
+		Getter oc_
+	*/
+	return oc_;
+}
+
+__attribute__((visibility("default"))) const double Neuron::GetNeighboringInfluence() const noexcept
+{
+	/*
+		Getter nc_
+	*/
+	return nc_;
+}
+
+__attribute__((visibility("default"))) const neuron_t Neuron::GetNeuronId() noexcept
 {
 	/*
-		stores neighboring Neuron pointer
+		rerturn neuron id;
 	*/
-	neighbors_.emplace_back(neighbor);
+	return id_;
 }
 
-__attribute__((visibility("default"))) inline const void Neuron::SetMembranePotential(const double Vm) noexcept
+__attribute__((visibility("default"))) const int Neuron::GetPostsynapticDelay() const noexcept
 {
 	/*
-		Vm = membrane potential (mV)
+		Getter post_delay_
 	*/
-	Vm_ = Vm;
+	return post_delay_;
 }
 
-__attribute__((visibility("default"))) inline const void Neuron::SetMembraneCapacitance(const double Cm) noexcept
+__attribute__((visibility("default"))) const int Neuron::GetNeighborDelay() const noexcept
 {
 	/*
-		Cm = Membrane Capacitance Density assignment (C)
+		Getter neighbor_delay_
 	*/
-	Cm_ = Cm;
+	return neighbor_delay_;
 }
 
-__attribute__((visibility("default"))) inline const void Neuron::SetOutputCurrent(const double oc) noexcept
+__attribute__((visibility("default"))) const bool Neuron::HasPostsynapticNeuron() const noexcept
 {
 	/*
-		oc = output current (µA)
+		returns true if a postsynaptic neuron is assigned
 	*/
-	oc_ = oc;
+	return postsynaptic_ != nullptr;
 }
 
-__attribute__((visibility("default"))) inline const void Neuron::SetNeighboringInfluence(const double nc) noexcept
+__attribute__((visibility("default"))) const bool Neuron::HasNeighbors() const noexcept
 {
 	/*
-		nc = neighboring current influence (µA)
+		returns true if neighboring neurons are assigned
 	*/
-	nc_ = nc;
+	return !neighbors_.empty() || range_count_ > 0;
 }
 
-__attribute__((visibility("default"))) inline const double Neuron::GetMembranePotential() const noexcept
+__attribute__((visibility("default"))) const size_t Neuron::GetNeighborCount() const noexcept
 {
 	/*
-		Getter Vm_
+		returns number of neighboring neurons, stored and in the range
 	*/
-	return Vm_;
+	return neighbors_.size() + range_count_;
 }
 
-__attribute__((visibility("default"))) inline const double Neuron::GetMembraneCapacitance() const noexcept
+__attribute__((visibility("default"))) Neuron* Neuron::GetNeighbor(const int index) const noexcept
 {
 	/*
-		Getter Cm_
+		returns pointer to the neighboring neuron, the range follows the stored neighbors
 	*/
-	return Cm_;
+	return (index < neighbors_.size()) ? neighbors_[index] : range_ + (index - neighbors_.size());
 }
 
-__attribute__((visibility("default"))) inline const double Neuron::GetOutputCurrent() const noexcept
+__attribute__((visibility("default"))) Neuron* Neuron::GetPostsynapticNeuron() const noexcept
 {
 	/*
-		Getter oc_
+		returns pointer to the postsynaptic neuron, nullptr if none is assigned
 	*/
-	return oc_;
+	return postsynaptic_;
 }
 
-__attribute__((visibility("default"))) inline const double Neuron::GetNeighboringInfluence() const noexcept
+__attribute__((visibility("default"))) const double Neuron::GetSpikeTime() const noexcept
 {
 	/*
-		Getter nc_
+		returns last interpolated threshold crossing time [ms], -1 if not spiked
 	*/
-	return nc_;
+	return spike_time_;
 }
 
-__attribute__((visibility("default"))) inline const neuron_t Neuron::GetNeuronId() noexcept
+__attribute__((visibility("default"))) const size_t Neuron::GetUpdateCount() const noexcept
 {
 	/*
-		rerturn neuron id;
+		returns number of Hodgkin-Huxley updates performed
 	*/
-	return id_;
+	return updates_;
 }
 
-__attribute__((visibility("default"))) std::vector<double>& Neuron::GetHistory() noexcept
+__attribute__((visibility("default"))) history_t& Neuron::GetHistory() noexcept
 {
 	/*
 		returns membrane potential history log
 	*/
+	Flush();
 	return history_;
 }
 
@@ -225,10 +1033,19 @@ __attribute__((visibility("default"))) const size_t Neuron::GetHistorySize() noe
 	/*
 		returns membrane potential history log's size
 	*/
-	return history_.size();
+	return history_.size() + (recording_ ? idle_bins_ : 0);
+}
+
+__attribute__((visibility("default"))) Statistics& Neuron::GetStatistics() noexcept
+{
+	/*
+		returns streaming accumulators, including bins skipped while quiescent
+	*/
+	Flush();
+	return stats_;
 }
 
-__attribute__((visibility("default"))) inline const bool Neuron::IsInhibitory() noexcept
+__attribute__((visibility("default"))) const bool Neuron::IsInhibitory() noexcept
 {
 	/*
 		return true if the output current is inhibitor, negative
@@ -236,7 +1053,7 @@ __attribute__((visibility("default"))) inline const bool Neuron::IsInhibitory()
 	return oc_ < 0;
 }
 
-__attribute__((visibility("default"))) inline const bool Neuron::IsExhitatory() noexcept
+__attribute__((visibility("default"))) const bool Neuron::IsExhitatory() noexcept
 {
 	/*
 		return true if the output current is exhitatory, positive
@@ -244,12 +1061,20 @@ __attribute__((visibility("default"))) inline const bool Neuron::IsExhitatory()
 	return oc_ > 0;
 }
 
+__attribute__((visibility("default"))) const bool Neuron::IsRecording() const noexcept
+{
+	/*
+		returns true if the membrane potential of every bin is recorded
+	*/
+	return recording_;
+}
+
 inline const double Neuron::AM(const double Vm) noexcept
 {
 	/*
 		αm function
 	*/
-	return 0.1 * (Vm + 40.0) / (1.0 - exp(- (Vm + 40.0) / 10.0));
+	return 0.1 * (Vm + 40.0) / (1.0 - FastMath::Exp(- (Vm + 40.0) / 10.0));
 }
 
 inline const double Neuron::BM(const double Vm) noexcept
@@ -257,7 +1082,7 @@ inline const double Neuron::BM(const double Vm) noexcept
 	/*
 		βm function
 	*/
-	return 4.0 * exp(- (Vm + 64.0) / 18.0);
+	return 4.0 * FastMath::Exp(- (Vm + 64.0) / 18.0);
 }
 
 inline const double Neuron::AH(const double Vm) noexcept
@@ -265,7 +1090,7 @@ inline const double Neuron::AH(const double Vm) noexcept
 	/*
 		αh function
 	*/
-	return 0.07 * exp(- (Vm + 65) / 20);
+	return 0.07 * FastMath::Exp(- (Vm + 65) / 20);
 }
 
 inline const double Neuron::BH(const double Vm) noexcept
@@ -273,7 +1098,7 @@ inline const double Neuron::BH(const double Vm) noexcept
 	/*
 		βh function
 	*/
-	return 1.0 / (1.0 + exp(- (Vm + 35.0) / 10.0));
+	return 1.0 / (1.0 + FastMath::Exp(- (Vm + 35.0) / 10.0));
 }
 
 inline const double Neuron::AN(const double Vm) noexcept
@@ -281,7 +1106,7 @@ inline const double Neuron::AN(const double Vm) noexcept
 	/*
 		αn function
 	*/
-	return 0.01 * (Vm + 55) / (1 - exp(- (Vm + 55.0) / 10.0));
+	return 0.01 * (Vm + 55) / (1 - FastMath::Exp(- (Vm + 55.0) / 10.0));
 }
 
 inline const double Neuron::BN(const double Vm) noexcept
@@ -289,14 +1114,14 @@ inline const double Neuron::BN(const double Vm) noexcept
 	/*
 		βn function
 	*/
-	return 0.125 * exp(- (Vm + 65.0) / 80.0);
+	return 0.125 * FastMath::Exp(- (Vm + 65.0) / 80.0);
 }
 
-const void Neuron::Step(double& x, const double Vm, const double dt, const double (*a)(const double), const double (*b)(const double)) noexcept
+inline const void Neuron::Step(double& x, const double aX, const double bX, const double dt) noexcept
 {
-	// α, β functions
-	const double aX = (*a)(Vm);
-	const double bX = (*b)(Vm);
+	/*
+		aX, bX = α, β functions evaluated at the membrane potential
+	*/
 
 	// τ
 	const double tau = 1 / (aX + bX);
@@ -304,10 +1129,10 @@ const void Neuron::Step(double& x, const double Vm, const double dt, const doubl
 	const double inf = aX * tau;
 
 	// update channel activation value
-	x = inf + (x - inf) * exp(- dt / tau);
+	x = inf + (x - inf) * FastMath::Exp(- dt / tau);
 }
 
-const double Neuron::HodgkinHuxley(const double dt, const double current_stimulus) noexcept
+inline const void Neuron::Integrate(double& Vm, double& m, double& h, double& n, const double Cm, const double dt, const double current_stimulus) noexcept
 {
 	/*
 		Hodgkin-Huxley Model
@@ -317,12 +1142,76 @@ const double Neuron::HodgkinHuxley(const double dt, const double current_stimulu
 		-C * V(t) = i * t - x * t - y * t - z * z + C1
 		V(t) = ((x + y + z - i) * t - c1) / C
 	 
-		return updated membrane potential
+		exponential Euler update of the membrane potential and channel activations
+	*/
+
+	// Currents: Na, K, leak
+	const double iNa = s_GNa_ * FastMath::Pow3(m) * h;
+	const double iK = s_GK_ * FastMath::Pow4(n);
+	const double iL = s_GL_;
+
+	// Sum of ion currents
+	const double iTotal = iNa + iK + iL;
+	
+	// membrane potential as it tends to ∞
+	const double V_inf = ((s_ENa_ * iNa + s_EK_ * iK + s_EL_ * iL) + current_stimulus) / iTotal;
+	
+	// update membrane potential τ
+	const double tau_v = Cm / iTotal;
+	
+	// update membrane potential
+	Vm = V_inf + (Vm - V_inf) * FastMath::Exp(- dt / tau_v);
+	
+	// update sodium channel activation membrane
+	Step(m, AM(Vm), BM(Vm), dt);
+	// update leak ion channels activation membrane
+	Step(h, AH(Vm), BH(Vm), dt);
+	// update potassium channel activation membrane
+	Step(n, AN(Vm), BN(Vm), dt);
+}
+
+inline const double Neuron::Membrane(const double Vm, const double m, const double h, const double n, const double Cm, const double dt, const double current_stimulus) noexcept
+{
+	/*
+		exponential Euler update of the membrane potential alone, the gates held
+	*/
+	
+	// Currents: Na, K, leak
+	const double iNa = s_GNa_ * FastMath::Pow3(m) * h;
+	const double iK = s_GK_ * FastMath::Pow4(n);
+	const double iL = s_GL_;
+	
+	// Sum of ion currents
+	const double iTotal = iNa + iK + iL;
+	
+	// membrane potential as it tends to ∞
+	const double V_inf = ((s_ENa_ * iNa + s_EK_ * iK + s_EL_ * iL) + current_stimulus) / iTotal;
+	
+	return V_inf + (Vm - V_inf) * FastMath::Exp(- dt * iTotal / Cm);
+}
+
+inline const void Neuron::Gates(const double Vm, double& m, double& h, double& n, const double dt) noexcept
+{
+	/*
+		exponential Euler update of the gates with the rates of the membrane potential
+	*/
+	Step(m, AM(Vm), BM(Vm), dt);
+	Step(h, AH(Vm), BH(Vm), dt);
+	Step(n, AN(Vm), BN(Vm), dt);
+}
+
+inline const void Neuron::IntegrateMultirate(double& Vm, double& m, double& h, double& n, double& dh, double& dn, const double Cm, const double dt, const double slow_dt, const double current_stimulus) noexcept
+{
+	/*
+		exponential Euler update of the membrane potential and the fast sodium activation every bin
+		h and n relax about ten times slower than m, they advance over slow_dt on the first bin of their interval,
+		slow_dt = 0 on the other bins skips four of the six rate evaluations and two of the gate exponentials
+		dh, dn = change of h and n per bin, they are interpolated in between, centered on the values of the interval
 	*/
 
 	// Currents: Na, K, leak
-	const double iNa = s_GNa_ * pow(m_, 3) * h_;
-	const double iK = s_GK_ * pow(n_, 4);
+	const double iNa = s_GNa_ * FastMath::Pow3(m) * h;
+	const double iK = s_GK_ * FastMath::Pow4(n);
 	const double iL = s_GL_;
 
 	// Sum of ion currents
@@ -332,50 +1221,469 @@ const double Neuron::HodgkinHuxley(const double dt, const double current_stimulu
 	const double V_inf = ((s_ENa_ * iNa + s_EK_ * iK + s_EL_ * iL) + current_stimulus) / iTotal;
 	
 	// update membrane potential τ
-	const double tau_v = Cm_ / iTotal;
+	const double tau_v = Cm / iTotal;
 	
 	// update membrane potential
-	Vm_ = V_inf + (Vm_ - V_inf) * exp(- dt / tau_v);
+	Vm = V_inf + (Vm - V_inf) * FastMath::Exp(- dt / tau_v);
+	
+	// update sodium channel activation membrane
+	Step(m, AM(Vm), BM(Vm), dt);
+	
+	if (slow_dt <= 0) {
+		// interpolated slow gates
+		h += dh;
+		n += dn;
+		return;
+	}
+	
+	// bins between the interpolated gates of the last bin and the values of the interval they are centered on
+	const double lag = 0.5 * (slow_dt / dt - 1);
+	const double h0 = h - dh * lag;
+	const double n0 = n - dn * lag;
+	
+	// update leak ion channels activation membrane over the whole interval
+	h = h0;
+	Step(h, AH(Vm), BH(Vm), slow_dt);
+	// update potassium channel activation membrane over the whole interval
+	n = n0;
+	Step(n, AN(Vm), BN(Vm), slow_dt);
+	
+	dh = (h - h0) * dt / slow_dt;
+	dn = (n - n0) * dt / slow_dt;
+	h -= dh * lag;
+	n -= dn * lag;
+}
+
+__attribute__((visibility("default"))) const void Neuron::IntegrateBatch(double* __restrict Vm, double* __restrict m, double* __restrict h, double* __restrict n, double* __restrict dh, double* __restrict dn, const double* __restrict Cm, const double* __restrict current_stimulus, const size_t count, const double dt, const double slow_dt) noexcept
+{
+	/*
+		Hodgkin-Huxley update of a whole layer stored as arrays
+		dh, dn = change of the slow gates per bin, unused with the single rate update
+		slow_dt = time [ms] the slow gates h and n advance over, dt every bin, 0 interpolates them
+		the exponentials are inlined, the loop vectorizes over the neurons
+	*/
+	if (slow_dt == dt) {
+		for (size_t i = 0; i < count; i++) {
+			Integrate(Vm[i], m[i], h[i], n[i], Cm[i], dt, current_stimulus[i]);
+		}
+	} else if (slow_dt > 0) {
+		for (size_t i = 0; i < count; i++) {
+			IntegrateMultirate(Vm[i], m[i], h[i], n[i], dh[i], dn[i], Cm[i], dt, slow_dt, current_stimulus[i]);
+		}
+	} else {
+		for (size_t i = 0; i < count; i++) {
+			IntegrateMultirate(Vm[i], m[i], h[i], n[i], dh[i], dn[i], Cm[i], dt, 0, current_stimulus[i]);
+		}
+	}
+}
+
+const void Neuron::IntegrateGates(const double* __restrict Vm, double* __restrict m, double* __restrict h, double* __restrict n, const size_t count, const double dt) noexcept
+{
+	/*
+		exponential Euler update of the channel activations of count compartments stored as arrays
+		at their membrane potentials after the bin, the loop vectorizes over the compartments
+	*/
+	for (size_t i = 0; i < count; i++) {
+		// update sodium channel activation membrane
+		Step(m[i], AM(Vm[i]), BM(Vm[i]), dt);
+		// update leak ion channels activation membrane
+		Step(h[i], AH(Vm[i]), BH(Vm[i]), dt);
+		// update potassium channel activation membrane
+		Step(n[i], AN(Vm[i]), BN(Vm[i]), dt);
+	}
+}
+
+__attribute__((visibility("default"))) const void Neuron::IntegrateCoupled(double* __restrict Vm, double* __restrict m, double* __restrict h, double* __restrict n, const double* __restrict Cm, const double* __restrict nc, const double* __restrict current_stimulus, const size_t count, const double dt, double* __restrict work, const bool forward) noexcept
+{
+	/*
+		Hodgkin-Huxley update of an all-to-all layer stored as arrays, whose spiking neurons inject
+		nc * exp(-Vm / Vrest) into every neighbor during the bin, the trapezoidal mean of the currents
+		at the start and at the end of the bin, the explicit update uses the start of the bin only
+		work = 4 * count scratch values
+		with the gates of the start of the bin the update of a neuron is linear in its input current,
+		Vm = p + q * I, the end of bin currents are linearized around the last iterate, the layer matrix is then
+		diagonal plus rank one and Sherman-Morrison solves it in O(count)
+		forward = every neuron injects into the neurons after it only, the layer matrix is then triangular and
+		one sweep in array order solves the end of bin currents exactly
+	*/
+	// membrane potential without neighbor currents and its sensitivity to the input current
+	double* __restrict p = work;
+	double* __restrict q = work + count;
+	// neighbor currents and their derivatives
+	double* __restrict c = work + 2 * count;
+	double* __restrict w = work + 3 * count;
+	
+	// half of the neighbor currents at the start of the bin, of the layer and of the neurons before the current one
+	double C = 0;
+	double P = 0;
+	
+	for (size_t i = 0; i < count; i++) {
+		c[i] = (Vm[i] >= s_Vthreashold_) ? 0.5 * nc[i] * FastMath::Exp(- Vm[i] / s_Vrest_) : 0;
+		C += c[i];
+	}
+	
+	for (size_t i = 0; i < count; i++) {
+		// neighbor currents received at the start of the bin
+		const double received = forward ? P : C - c[i];
+		P += c[i];
+		
+		// Currents: Na, K, leak
+		const double iNa = s_GNa_ * FastMath::Pow3(m[i]) * h[i];
+		const double iK = s_GK_ * FastMath::Pow4(n[i]);
+		const double iL = s_GL_;
+		
+		// Sum of ion currents
+		const double iTotal = iNa + iK + iL;
+		
+		// decay of the membrane potential over the bin
+		const double decay = FastMath::Exp(- dt * iTotal / Cm[i]);
+		
+		q[i] = (1 - decay) / iTotal;
+		p[i] = Vm[i] * decay + q[i] * ((s_ENa_ * iNa + s_EK_ * iK + s_EL_ * iL) + current_stimulus[i] + received);
+		// first iterate without the end of bin currents
+		Vm[i] = p[i];
+	}
+	
+	if (forward) {
+		// half of the end of bin currents of the neurons before the current one, already solved
+		P = 0;
+		
+		for (size_t i = 0; i < count; i++) {
+			Vm[i] = p[i] + q[i] * P;
+			P += (Vm[i] >= s_Vthreashold_) ? 0.5 * nc[i] * FastMath::Exp(- Vm[i] / s_Vrest_) : 0;
+		}
+	}
+	
+	for (int iteration = 0; !forward && iteration < s_coupling_iterations_; iteration++) {
+		// coupling gain of the linearized layer, at least 1 has no stable solution
+		double gain = 0;
+		
+		// end of bin current of every neuron and its derivative, 0 unless spiking
+		for (size_t i = 0; i < count; i++) {
+			c[i] = (Vm[i] >= s_Vthreashold_) ? 0.5 * nc[i] * FastMath::Exp(- Vm[i] / s_Vrest_) : 0;
+			w[i] = - c[i] / s_Vrest_;
+			gain += w[i] * q[i] / (1 + w[i] * q[i]);
+		}
+		
+		if (gain >= 1) {
+			// neighbor currents held at the iterate
+			std::fill_n(w, count, 0.0);
+			gain = 0;
+		}
+		
+		// sum of the linearized end of bin currents at zero potential
+		C = 0;
+		
+		for (size_t i = 0; i < count; i++) {
+			c[i] -= w[i] * Vm[i];
+			C += c[i];
+		}
+		
+		// Sherman-Morrison: weighted sum of the next iterate over the spiking neurons
+		double S = 0;
+		
+		for (size_t i = 0; i < count; i++) {
+			S += w[i] * (p[i] + q[i] * (C - c[i])) / (1 + w[i] * q[i]);
+		}
+		
+		S /= 1 - gain;
+		
+		bool settled = true;
+		
+		for (size_t i = 0; i < count; i++) {
+			const double next = (p[i] + q[i] * (C - c[i] + S)) / (1 + w[i] * q[i]);
+			settled &= ((next >= s_Vthreashold_) == (Vm[i] >= s_Vthreashold_)) && std::fabs(next - Vm[i]) < 1e-9;
+			Vm[i] = next;
+		}
+		
+		if (settled) {
+			break;
+		}
+	}
+	
+	for (size_t i = 0; i < count; i++) {
+		// update sodium channel activation membrane
+		Step(m[i], AM(Vm[i]), BM(Vm[i]), dt);
+		// update leak ion channels activation membrane
+		Step(h[i], AH(Vm[i]), BH(Vm[i]), dt);
+		// update potassium channel activation membrane
+		Step(n[i], AN(Vm[i]), BN(Vm[i]), dt);
+	}
+}
+
+const void Neuron::IntegrateLayer(Neuron* neurons, const size_t count, const double dt, const bool forward, std::vector<double>& work) noexcept
+{
+	/*
+		neurons = contiguous neurons of a layer, each injecting its neighbor current into all the others,
+		or forward into all the neurons after it or into none
+		work = scratch of the layer, resized on demand
+		integrates one bin of the layer with IntegrateCoupled, the neurons receive the neighbor currents of its spikes
+		within the bin, they must not be transmitted to the next bin
+		quiescent neurons are integrated as well, the spikes of the bin may reach them
+	*/
+	work.resize(15 * count);
+	
+	// state of the layer, its start of bin copy, capacitances, neighbor currents, input and solver scratch
+	double* Vm = work.data();
+	double* m = Vm + count;
+	double* h = m + count;
+	double* n = h + count;
+	double* V0 = n + count;
+	double* m0 = V0 + count;
+	double* h0 = m0 + count;
+	double* n0 = h0 + count;
+	double* Cm = n0 + count;
+	double* nc = Cm + count;
+	double* Ic = nc + count;
+	
+	for (size_t i = 0; i < count; i++) {
+		Neuron& neuron = neurons[i];
+		
+		Ic[i] = neuron.Input();
+		// skipped bins are written to the history log before the bin
+		neuron.quiescent_ = false;
+		neuron.Flush();
+		
+		V0[i] = Vm[i] = neuron.Vm_;
+		m0[i] = m[i] = neuron.m_;
+		h0[i] = h[i] = neuron.h_;
+		n0[i] = n[i] = neuron.n_;
+		Cm[i] = neuron.Cm_;
+		// neurons without neighbors send no current
+		nc[i] = neuron.HasNeighbors() ? neuron.nc_ : 0;
+	}
+	
+	IntegrateCoupled(Vm, m, h, n, Cm, nc, Ic, count, dt, Ic + count, forward);
+	
+	for (size_t i = 0; i < count; i++) {
+		Neuron& neuron = neurons[i];
+		
+		neuron.Vm_ = Vm[i];
+		neuron.m_ = m[i];
+		neuron.h_ = h[i];
+		neuron.n_ = n[i];
+		
+		neuron.Finish(dt, Ic[i], V0[i], m0[i], h0[i], n0[i]);
+	}
+}
+
+inline const void Neuron::Finish(const double dt, const double current_stimulus, const double V0, const double m0, const double h0, const double n0) noexcept
+{
+	/*
+		V0, m0, h0, n0 = state at the start of the bin
+		ends an integrated bin: quiescence, sample, spike detection and the spike log
+	*/
+	updates_++;
+	
+	Settle(dt, current_stimulus, V0, m0, h0, n0);
 
-	// stores membrane potential in history log
-	history_.emplace_back(Vm_);
+	// stores membrane potential in history log and accumulators
+	Sample();
 	
 	// branchless cell state update
 	spiked_ = (Vm_ >= s_Vthreashold_) ? true : false;
 	
-	// propagates output current to postsynaptic Neuron and neighboring current to neighboring Neurons in time step t
-	//for processing in time step t + 1
-	if (postsynaptic_) {
-		// increment postsynaptic neuron's current by transmitted output current
-		// branchless if spiked == true
-		postsynaptic_->InjectCurrent(oc_ * spiked_);
+	// interpolate threshold crossing time on an upstroke
+	if (spiked_ && V0 < s_Vthreashold_) {
+		spike_time_ = time_ + dt * (s_Vthreashold_ - V0) / (Vm_ - V0);
+		stats_.Spike(spike_time_);
+		if (plastic_ || monitored_) {
+			events_.push_back(spike_time_);
+		}
+	}
+	
+	time_ += dt;
+	
+	if (spiked_) {
+		// delivered by the network once the layer or window is integrated
+		spikes_.emplace_back(bin_, Vm_);
 	}
+	
+	bin_++;
+}
 
-	for (int i = 0; i < neighbors_.size(); i++) {
-		if (neighbors_[i]) {
-			// increment neighboring neurons' current exponentially
-			// branchless if spike == true
-			neighbors_[i]->InjectCurrent(NeighborCurrent() * spiked_);
-		}
+const double Neuron::HodgkinHuxley(const double dt, const double current_stimulus, const int slow_interval) noexcept
+{
+	/*
+		Hodgkin-Huxley Model
+	 
+		return updated membrane potential
+	*/
+	
+	// state at the start of the bin
+	const double V0 = Vm_, m0 = m_, h0 = h_, n0 = n_;
+	
+	if (slow_interval > 1) {
+		// slow gates advance over the whole interval on its first bin and are interpolated on the others
+		const double slow_dt = (bin_ % slow_interval == 0) ? dt * slow_interval : 0;
+		IntegrateMultirate(Vm_, m_, h_, n_, dh_, dn_, Cm_, dt, slow_dt, current_stimulus);
+	} else {
+		// integrate membrane potential and channel activations
+		Integrate(Vm_, m_, h_, n_, Cm_, dt, current_stimulus);
 	}
 	
-	// update sodium channel activation membrane
-	Step(m_, Vm_, dt, &Neuron::AM, &Neuron::BM);
-	// update leak ion channels activation membrane
-	Step(h_, Vm_, dt, &Neuron::AH, &Neuron::BH);
-	// update potassium channel activation membrane
-	Step(n_, Vm_, dt, &Neuron::AN, &Neuron::BN);
+	Finish(dt, current_stimulus, V0, m0, h0, n0);
 
 	return Vm_;
 }
 
-const double Neuron::NeighborCurrent() noexcept
+const double Neuron::Input() noexcept
+{
+	/*
+		sum of current retrived atomically
+		includes the delayed current received in the current bin
+	*/
+	double Ic = a_Isum_.exchange(0);
+	
+	if (!a_delayed_.empty()) {
+		Ic += a_delayed_[bin_ % a_delayed_.size()].exchange(0);
+	}
+	
+	return Ic;
+}
+
+const void Neuron::Accumulate(std::atomic<double>& sum, const double input) noexcept
+{
+	/*
+		lock-free atomic addition
+	*/
+	double expected = sum.load();
+	while (!sum.compare_exchange_weak(expected, expected + input));
+}
+
+const bool Neuron::Wake(const double dt, const double current_stimulus) noexcept
+{
+	/*
+		dt = delta time
+		current_stimulus = input current of the bin
+		skips the bin of a quiescent cell without input current
+		otherwise writes the skipped bins to the history log before integrating
+		return true if the bin has to be integrated
+	*/
+	if (quiescent_ && current_stimulus == 0) {
+		Idle(dt);
+		return false;
+	}
+	
+	quiescent_ = false;
+	Flush();
+	
+	return true;
+}
+
+const void Neuron::Settle(const double dt, const double current_stimulus, const double V0, const double m0, const double h0, const double n0) noexcept
+{
+	/*
+		marks the cell quiescent if it reached a fixed point without input current
+	*/
+	const double rate = s_quiescent_rate_ * dt;
+	
+	quiescent_ = current_stimulus == 0 && std::fabs(Vm_ - V0) < rate && std::fabs(m_ - m0) < rate && std::fabs(h_ - h0) < rate && std::fabs(n_ - n0) < rate;
+}
+
+inline const void Neuron::Sample() noexcept
+{
+	/*
+		stores the membrane potential of the bin in the history log and the accumulators
+	*/
+	if (recording_) {
+		Store(Vm_);
+	}
+	stats_.Add(Vm_);
+}
+
+inline const void Neuron::Store(const double Vm, const size_t bins) noexcept
+{
+	/*
+		Vm = membrane potential [mV]
+		bins = number of bins with this membrane potential
+		appends to the trace writer's record if one is open, to the history log otherwise
+	*/
+	if (!trace_) {
+		if (history_.size() + bins > history_.capacity()) {
+			ReserveHistory(std::max(2 * history_.capacity(), history_.size() + bins));
+		}
+		history_.insert(history_.end(), bins, Vm);
+		return;
+	}
+	
+	for (size_t i = 0; i < bins; i++) {
+		memcpy(trace_, &Vm, sizeof(double));
+		trace_ += sizeof(double);
+	}
+}
+
+const void Neuron::Flush() noexcept
+{
+	/*
+		writes the run-length of skipped bins to the history log
+		the membrane potential did not change while the cell was quiescent
+	*/
+	if (recording_) {
+		Store(Vm_, idle_bins_);
+	}
+	stats_.Add(Vm_, idle_bins_);
+	idle_bins_ = 0;
+}
+
+const double Neuron::NeighborCurrent(const double Vm) const noexcept
 {
 	/*
+		Vm = membrane potential of the spike
 		Calculates ∆I effect of this spiking neuron to its neighbors
 		using an exponential function
 	*/
-	return nc_ * exp(- Vm_ / s_Vrest_);
+	return nc_ * FastMath::Exp(- Vm / s_Vrest_);
+}
+
+const double Neuron::PreTrace(const double t) const noexcept
+{
+	/*
+		t = time [ms]
+		presynaptic trace of the spikes strictly before t
+	*/
+	double trace = (trace_time_ >= 0) ? trace_plus_ * FastMath::Exp(-(t - trace_time_) / s_tau_plus_) : 0;
+	
+	for (int i = 0; i < events_.size() && events_[i] < t; i++) {
+		trace += FastMath::Exp(-(t - events_[i]) / s_tau_plus_);
+	}
+	
+	return trace;
+}
+
+const double Neuron::PostTrace(const double t) const noexcept
+{
+	/*
+		t = time [ms]
+		postsynaptic trace of the spikes strictly before t
+	*/
+	double trace = (trace_time_ >= 0) ? trace_minus_ * FastMath::Exp(-(t - trace_time_) / s_tau_minus_) : 0;
+	
+	for (int i = 0; i < events_.size() && events_[i] < t; i++) {
+		trace += FastMath::Exp(-(t - events_[i]) / s_tau_minus_);
+	}
+	
+	return trace;
+}
+
+const double Neuron::Plasticity(const Neuron& post) const noexcept
+{
+	/*
+		post = target of the edge
+		returns the gain change of the edge from this neuron to post
+	*/
+	double change = 0;
+	
+	// presynaptic spikes before postsynaptic spikes potentiate
+	for (int i = 0; i < post.events_.size(); i++) {
+		change += s_a_plus_ * PreTrace(post.events_[i]);
+	}
+	// postsynaptic spikes before presynaptic spikes depress
+	for (int i = 0; i < events_.size(); i++) {
+		change -= s_a_minus_ * post.PostTrace(events_[i]);
+	}
+	
+	return change;
 }
 
 inline const double Neuron::Rand(const double min, const double max)
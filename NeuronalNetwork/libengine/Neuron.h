@@ -9,26 +9,63 @@
 #ifndef Neuron_
 #define Neuron_
 
-#pragma GCC visibility push(hidden)
+#include "Arena.h"
+#include "Statistics.h"
 
 #include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
 #include <vector>
 
+#pragma GCC visibility push(hidden)
+
 typedef unsigned int neuron_t;
 
+template <int... Layers>
+class StaticNetwork;
+class Cable;
+
+typedef std::vector<double, ArenaAllocator<double>> history_t;
+
 class Neuron
 {	
+	// fixed topologies share the model constants
+	template <int... Layers>
+	friend class StaticNetwork;
+	// multi-compartment cells share the channel constants
+	friend class Cable;
+	
 	// array of neighboring neurons pointer
-	std::vector<Neuron*> neighbors_;
+	std::vector<Neuron*, ArenaAllocator<Neuron*>> neighbors_;
+	// contiguous neighbors following neighbors_, given by their first neuron and count instead of stored edges
+	Neuron* range_ = nullptr;
+	size_t range_count_ = 0;
+	// plastic gains of the neighbor edges, stored then range, empty without plasticity
+	std::vector<double, ArenaAllocator<double>> weights_;
+	
+	// spike times [ms] since the last plasticity pass or publication
+	std::vector<double> events_;
 
 	// Vm log
-	std::vector<double> history_;
+	history_t history_;
+	// unaligned in place record of a trace writer the bins are stored to instead of the log, nullptr without
+	char* trace_ = nullptr;
+	
+	// streaming accumulators of the membrane potential and spikes
+	Statistics stats_;
+	
+	// log of spikes (bin, Vm) not yet delivered to the targets of the neuron
+	std::vector<std::pair<size_t, double>> spikes_;
 	
 	// pointer to postsynaptic neuron
 	Neuron* postsynaptic_ = nullptr;
 
 	// atomic input current sum [µA]
 	std::atomic<double> a_Isum_ = 0;
+	
+	// ring buffer of delayed input current [µA] indexed by bin
+	std::vector<std::atomic<double>, ArenaAllocator<std::atomic<double>>> a_delayed_;
 
 	// membrane potential [mV]
 	double Vm_ = -64.9964;
@@ -42,6 +79,22 @@ class Neuron
 	double m_ = 0.0530;
 	// leak ions channel deactivation conductance
 	double h_ = 0.5960;
+	// change of h and n per bin between their multi-rate updates, 0 with the single rate update
+	double dh_ = 0;
+	double dn_ = 0;
+
+	// adaptive integration sub-step [ms], carried over between bins
+	double substep_ = 0;
+	// times [ms] and membrane potentials of the last two accepted adaptive sub-steps with the same input current,
+	// the error of the next sub-step is estimated from them, and the number of them known
+	double past_time_[2] = {0, 0};
+	double past_Vm_[2] = {0, 0};
+	double past_input_ = 0;
+	int past_count_ = 0;
+	// simulated time [ms] elapsed for this neuron
+	double time_ = 0;
+	// interpolated threshold crossing time [ms] of the last spike
+	double spike_time_ = -1;
 
 	// output current [µA]
 	double oc_ = 0.01;
@@ -49,11 +102,39 @@ class Neuron
 	// neighbor current increase [µA]
 	double nc_ = 0.001;
 	
+	// plastic gain of the postsynaptic edge
+	double gain_ = 1.0;
+	// eligibility traces of the spikes before the last plasticity pass, decayed lazily from trace_time_
+	double trace_plus_ = 0;
+	double trace_minus_ = 0;
+	// time [ms] the traces were last updated, -1 before the first spike
+	double trace_time_ = -1;
+	
+	// number of Hodgkin-Huxley updates performed
+	size_t updates_ = 0;
+	// run-length of skipped bins not yet written to the history log
+	size_t idle_bins_ = 0;
+	// index of the bin being processed
+	size_t bin_ = 0;
+	
+	// transmission delay [bins] to the postsynaptic neuron, -1 uses the network default
+	int post_delay_ = -1;
+	// transmission delay [bins] to the neighboring neurons, -1 uses the network default
+	int neighbor_delay_ = -1;
+	
 	// neuron id
 	neuron_t id_;
 	
 	// boolean indicate of cell state
 	bool spiked_ = false;
+	// boolean indicate of cell resting at a fixed point
+	bool quiescent_ = false;
+	// boolean indicate of the membrane potential being logged every bin
+	bool recording_ = true;
+	// boolean indicate of spike timing dependent plasticity of the outgoing edges
+	bool plastic_ = false;
+	// boolean indicate of the spike times being published
+	bool monitored_ = false;
 
 	// static membrane resting potential
 	inline constexpr static const double s_Vrest_ = -64.9964;
@@ -68,26 +149,81 @@ class Neuron
 	inline constexpr static const double s_ENa_ = 50.0;
 	inline constexpr static const double s_EK_ = -77.0;
 	inline constexpr static const double s_EL_ = -54.4;
+	
+	// smallest adaptive sub-step [ms]
+	inline constexpr static const double s_min_substep_ = 1e-4;
+	// largest growth of an adaptive sub-step after an accepted one, geometric over quiescent stretches
+	inline constexpr static const double s_max_growth_ = 1.25;
+	// largest state change rate [1/ms] of a cell considered at a fixed point
+	inline constexpr static const double s_quiescent_rate_ = 1e-6;
+	
+	// potentiation and depression amplitudes of the spike timing dependent plasticity
+	inline static double s_a_plus_ = 0.01;
+	inline static double s_a_minus_ = 0.012;
+	// decay time constants [ms] of the presynaptic and postsynaptic traces
+	inline static double s_tau_plus_ = 20.0;
+	inline static double s_tau_minus_ = 20.0;
+	// largest gain of a plastic edge
+	inline static double s_max_gain_ = 2.0;
+	
+	// Newton iterations of the implicitly coupled layer update, ends early once the spiking neurons are settled
+	inline constexpr static const int s_coupling_iterations_ = 4;
 
 public:
-	Neuron(neuron_t neuron_id, const int num_bins = 10000, const int max_neighbors = 10000);
-	Neuron(neuron_t neuron_id, const double oc, const double nc, const int num_bins = 10000, const int max_neighbors = 10000);
-	Neuron(neuron_t neuron_id, const double Vm, const double Cm, const double n, const double m, const double h, const int num_bins = 10000, const int max_neighbors = 10000);
+	Neuron(neuron_t neuron_id, const int num_bins = 10000, const int max_neighbors = 10000, Arena* arena = nullptr);
+	Neuron(neuron_t neuron_id, const double oc, const double nc, const int num_bins = 10000, const int max_neighbors = 10000, Arena* arena = nullptr);
+	Neuron(neuron_t neuron_id, const double Vm, const double Cm, const double n, const double m, const double h, const int num_bins = 10000, const int max_neighbors = 10000, Arena* arena = nullptr);
 	Neuron(Neuron&& other);
 	virtual ~Neuron();
 	
 	Neuron& operator=(const Neuron& other);
+	
+	const void Swap(Neuron& other) noexcept;
+	const void Relink(Neuron* first, const int* position, const size_t count) noexcept;
 
-	const double Process(const double dt) noexcept;
+	const double Process(const double dt, const int slow_interval = 1) noexcept;
+	const void ProcessAdaptive(const double dt, const double tolerance, const int bins = 1, const double* drive = nullptr) noexcept;
+	
+	__attribute__((visibility("default"))) static const void IntegrateBatch(double* __restrict Vm, double* __restrict m, double* __restrict h, double* __restrict n, double* __restrict dh, double* __restrict dn, const double* __restrict Cm, const double* __restrict current_stimulus, const size_t count, const double dt, const double slow_dt) noexcept;
+	__attribute__((visibility("default"))) static const void IntegrateCoupled(double* __restrict Vm, double* __restrict m, double* __restrict h, double* __restrict n, const double* __restrict Cm, const double* __restrict nc, const double* __restrict current_stimulus, const size_t count, const double dt, double* __restrict work, const bool forward = false) noexcept;
+	static const void IntegrateLayer(Neuron* neurons, const size_t count, const double dt, const bool forward, std::vector<double>& work) noexcept;
 	const void InjectCurrent(const double input) noexcept;
+	const void InjectCurrent(const double input, const size_t bin) noexcept;
+	
+	const bool Dormant() noexcept;
+	const void Idle(const double dt) noexcept;
+	
+	const void Record(const bool record) noexcept;
+	const void Trace(char* samples) noexcept;
+	const void Monitor(const bool monitor) noexcept;
+	std::vector<std::pair<size_t, double>>& GetSpikes() noexcept;
+	const void Transmit(const size_t bin, const double Vm, const bool neighbors = true) noexcept;
 
 	const void AddPostsynapticNeuron(Neuron* next) noexcept;
 	const void AddNeighbor(Neuron* neighbor) noexcept;
+	const void AddNeighbors(Neuron* first, const size_t count) noexcept;
+	
+	const void SetPostsynapticDelay(const int delay) noexcept;
+	const void SetNeighborDelay(const int delay) noexcept;
+	const void ReserveDelays(const int length) noexcept;
+	const void ReserveHistory(const size_t bins) noexcept;
+	
+	const void EnablePlasticity() noexcept;
+	const bool Learn(const Neuron* first, const uint64_t* spiked) noexcept;
+	const void Consolidate() noexcept;
+	const bool HasEvents() const noexcept;
+	const std::vector<double>& GetEvents() const noexcept;
+	const void ClearEvents() noexcept;
+	const double GetGain() const noexcept;
+	const double GetNeighborGain(const int index) const noexcept;
+	static const void SetPlasticity(const double a_plus, const double a_minus, const double tau_plus, const double tau_minus, const double max_gain) noexcept;
 	
 	const void SetMembranePotential(const double Vm) noexcept;
 	const void SetMembraneCapacitance(const double Cm) noexcept;
 	const void SetOutputCurrent(const double oc) noexcept;
-	const void SetNeighboringInfluence(const double nc) noexcept;
+	__attribute__((visibility("default"))) const void SetNeighboringInfluence(const double nc) noexcept;
+	const void Randomize(const uint64_t seed) noexcept;
+	static const void Skip() noexcept;
 	
 	const double GetMembranePotential() const noexcept;
 	const double GetMembraneCapacitance() const noexcept;
@@ -95,12 +231,23 @@ public:
 	const double GetNeighboringInfluence() const noexcept;
 	
 	const neuron_t GetNeuronId() noexcept;
+	const int GetPostsynapticDelay() const noexcept;
+	const int GetNeighborDelay() const noexcept;
+	const bool HasPostsynapticNeuron() const noexcept;
+	const bool HasNeighbors() const noexcept;
+	const size_t GetNeighborCount() const noexcept;
+	Neuron* GetNeighbor(const int index) const noexcept;
+	Neuron* GetPostsynapticNeuron() const noexcept;
+	const double GetSpikeTime() const noexcept;
+	const size_t GetUpdateCount() const noexcept;
 
-	std::vector<double>& GetHistory() noexcept;
+	history_t& GetHistory() noexcept;
 	const size_t GetHistorySize() noexcept;
+	Statistics& GetStatistics() noexcept;
 
 	const bool IsInhibitory() noexcept;
 	const bool IsExhitatory() noexcept;
+	const bool IsRecording() const noexcept;
 
 private:
 	static const double AM(const double Vm) noexcept;
@@ -112,11 +259,33 @@ private:
 	static const double AN(const double Vm) noexcept;
 	static const double BN(const double Vm) noexcept;
 
-	const void Step(double& x, const double Vm, const double dt, const double (*a)(const double), const double (*b)(const double)) noexcept;
+	static const void Step(double& x, const double aX, const double bX, const double dt) noexcept;
+
+	static const void Integrate(double& Vm, double& m, double& h, double& n, const double Cm, const double dt, const double current_stimulus) noexcept;
+	static const double Membrane(const double Vm, const double m, const double h, const double n, const double Cm, const double dt, const double current_stimulus) noexcept;
+	static const void Gates(const double Vm, double& m, double& h, double& n, const double dt) noexcept;
+	static const void IntegrateGates(const double* __restrict Vm, double* __restrict m, double* __restrict h, double* __restrict n, const size_t count, const double dt) noexcept;
+	static const void IntegrateMultirate(double& Vm, double& m, double& h, double& n, double& dh, double& dn, const double Cm, const double dt, const double slow_dt, const double current_stimulus) noexcept;
 
-	const double HodgkinHuxley(const double dt, const double current_stimulus) noexcept;
+	const double HodgkinHuxley(const double dt, const double current_stimulus, const int slow_interval) noexcept;
+	const void Span(const double dt, const double tolerance, const int bins, const double Ic) noexcept;
+	const void Close(const double dt, const double Vm, const bool crossed) noexcept;
 
-	const double NeighborCurrent() noexcept;
+	const double Input() noexcept;
+	static const void Accumulate(std::atomic<double>& sum, const double input) noexcept;
+
+	const bool Wake(const double dt, const double current_stimulus) noexcept;
+	inline const void Finish(const double dt, const double current_stimulus, const double V0, const double m0, const double h0, const double n0) noexcept;
+	const void Settle(const double dt, const double current_stimulus, const double V0, const double m0, const double h0, const double n0) noexcept;
+	inline const void Sample() noexcept;
+	inline const void Store(const double Vm, const size_t bins = 1) noexcept;
+	const void Flush() noexcept;
+
+	const double NeighborCurrent(const double Vm) const noexcept;
+	
+	const double PreTrace(const double t) const noexcept;
+	const double PostTrace(const double t) const noexcept;
+	const double Plasticity(const Neuron& post) const noexcept;
 	
 	static const double Rand(const double min, const double max);
 } __attribute__((aligned (64)));
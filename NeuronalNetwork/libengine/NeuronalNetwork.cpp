@@ -8,15 +8,22 @@
 
 #include "NeuronalNetwork.h"
 
+#include <algorithm>
 #include <iostream>
 #include <cmath>
 #include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstring>
 #include <numeric>
 
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
 __attribute__((visibility("default"))) NeuronalNetwork::NeuronalNetwork()
 {
-	// initialize threadpool
-	sp_threadpool_ = new ThreadPool<NeuronThread, NeuronArg, void*>();
+	// threadpool is created by Prepare unless the network runs serially
 }
 
 __attribute__((visibility("default"))) NeuronalNetwork::NeuronalNetwork(std::vector<int> layers)
@@ -28,9 +35,6 @@ __attribute__((visibility("default"))) NeuronalNetwork::NeuronalNetwork(std::vec
 	int sum_neurons = std::accumulate(layers_sizes_.begin(), layers_sizes_.end(), 0);
 	
 	AllocateNeurons(sum_neurons);
-	
-	// initialize threadpool
-	sp_threadpool_ = new ThreadPool<NeuronThread, NeuronArg, void*>(sum_neurons);
 }
 
 __attribute__((visibility("default"))) NeuronalNetwork::NeuronalNetwork(std::initializer_list<int> layers)
@@ -42,9 +46,31 @@ __attribute__((visibility("default"))) NeuronalNetwork::NeuronalNetwork(std::ini
 	int sum_neurons = std::accumulate(layers_sizes_.begin(), layers_sizes_.end(), 0);
 	
 	AllocateNeurons(sum_neurons);
+}
+
+__attribute__((visibility("default"))) NeuronalNetwork::NeuronalNetwork(std::vector<int> layers, Communicator* communicator)
+{
+	/*
+		Constructor of the partition of a network integrated by this process of the group
+		every process owns a contiguous range of neuron ids, Prepare only allocates the owned neurons
+		and the neurons with edges into them, once InitializeNetwork declared the edges
+	*/
+	layers_sizes_ = std::move(layers);
+	communicator_ = communicator;
 	
-	// initialize threadpool
-	sp_threadpool_ = new ThreadPool<NeuronThread, NeuronArg, void*>(sum_neurons);
+	const long sum_neurons = std::accumulate(layers_sizes_.begin(), layers_sizes_.end(), 0);
+	
+	if (!communicator_) {
+		AllocateNeurons(sum_neurons);
+		return;
+	}
+	
+	const int rank = communicator_->Rank();
+	const int size = communicator_->Size();
+	
+	// balanced partition of the neuron ids, their positions are assigned once allocated
+	first_ = (int)((sum_neurons * rank) / size);
+	end_ = (int)((sum_neurons * (rank + 1)) / size) - first_;
 }
 
 __attribute__((visibility("default"))) NeuronalNetwork::~NeuronalNetwork()
@@ -52,8 +78,23 @@ __attribute__((visibility("default"))) NeuronalNetwork::~NeuronalNetwork()
 	/*
 		Deconstructor
 	*/
-	if (sp_threadpool_) {
-		delete sp_threadpool_;
+	if (threadpool_) {
+		delete threadpool_;
+	}
+	
+	if (counters_) {
+		delete counters_;
+	}
+	
+	if (tracing_) {
+		// the open records of the writer get their samples before the neurons are released
+		Stage();
+	}
+	
+	if (branches_) {
+		// children still running keep their own mapping
+		Wait();
+		munmap(branches_, sizeof(double) * branch_count_ * neurons_.size() * branch_bins_);
 	}
 }
 
@@ -65,15 +106,13 @@ __attribute__((visibility("default"))) void NeuronalNetwork::InitializeNetwork()
 		adds references to postsynaptic neurons
 	 */
 	int count = 0;
+	// number of neurons in the network, a partition may store fewer
+	const int sum_neurons = GetLayerOffset((int)layers_sizes_.size());
 	
 	for (int i = 0; i < layers_sizes_.size(); i++) {
 		for (int j = count; j < layers_sizes_[i]; j++) {
-			for (int m = count; m < layers_sizes_[i]; m++) {
-				if (j != m) {
-					// adds all neighboring neurons in the layer
-					neurons_[j].AddNeighbor(&neurons_[m]);
-				}
-			}
+			// adds all neighboring neurons in the layer
+			AddNeighbors(j, count, layers_sizes_[i]);
 			count++;
 		}
 	}
@@ -83,222 +122,2087 @@ __attribute__((visibility("default"))) void NeuronalNetwork::InitializeNetwork()
 	for (int i = 0; i < layers_sizes_.size() - 1; i++) {
 		count += layers_sizes_[i];
 		// branchless initial index of layer
-		int branchless = ((i == 0) ? 0 : (i == layers_sizes_.size() - 1) ? (int)neurons_.size() - layers_sizes_.back() : layers_sizes_[i - 1]);
+		int branchless = ((i == 0) ? 0 : (i == layers_sizes_.size() - 1) ? sum_neurons - layers_sizes_.back() : layers_sizes_[i - 1]);
+		// outgoing edges of the layer are given by its projections
+		if (HasProjection(i)) {
+			continue;
+		}
 		for (int j = branchless; j < layers_sizes_[i] + branchless; j++) {
 			// assigns postsynaptic neuron using a modulo
-			neurons_[j].AddPostsynapticNeuron(&neurons_[count + j % layers_sizes_[i + 1]]);
+			AddPostsynapticNeuron(j, count + j % layers_sizes_[i + 1]);
+		}
+	}
+}
+
+__attribute__((visibility("default"))) const void NeuronalNetwork::AddNeighbor(const int source, const int target) noexcept
+{
+	/*
+		source, target = neuron ids
+		adds the target to the neighbors of the source, called by InitializeNetwork
+		a partition only keeps the edges into its owned neurons, wired once they are allocated
+	*/
+	if (!communicator_) {
+		neurons_[GetPosition(source)].AddNeighbor(&neurons_[GetPosition(target)]);
+		return;
+	}
+	
+	// edges into the neurons of other processes are kept by them
+	if (target < first_ || target >= first_ + end_ - begin_) {
+		return;
+	}
+	
+	if (!prepared_) {
+		neighbor_edges_.emplace_back(source, target);
+		return;
+	}
+	
+	if (GetPosition(source) >= 0) {
+		neurons_[GetPosition(source)].AddNeighbor(&neurons_[GetPosition(target)]);
+	}
+}
+
+__attribute__((visibility("default"))) const void NeuronalNetwork::AddNeighbors(const int source, const int first, const int last) noexcept
+{
+	/*
+		source = neuron id
+		first, last = neuron ids [first, last), the source itself is skipped
+		adds the ids to the neighbors of the source, called by InitializeNetwork
+		a range on one side of the source is kept as a range without storing an edge,
+		renumbered networks and partitions store the edges
+	*/
+	const int begin = (source == first) ? first + 1 : first;
+	const int end = (source == last - 1) ? last - 1 : last;
+	
+	if (!communicator_ && positions_.empty() && begin < end && (source < begin || source >= end)) {
+		neurons_[GetPosition(source)].AddNeighbors(&neurons_[GetPosition(begin)], end - begin);
+		return;
+	}
+	
+	for (int m = first; m < last; m++) {
+		if (m != source) {
+			AddNeighbor(source, m);
 		}
 	}
 }
 
+__attribute__((visibility("default"))) const void NeuronalNetwork::AddPostsynapticNeuron(const int source, const int target) noexcept
+{
+	/*
+		source, target = neuron ids
+		sets the target as postsynaptic neuron of the source, called by InitializeNetwork
+		a partition only keeps the edges into its owned neurons, wired once they are allocated
+	*/
+	if (!communicator_) {
+		neurons_[GetPosition(source)].AddPostsynapticNeuron(&neurons_[GetPosition(target)]);
+		return;
+	}
+	
+	if (!prepared_) {
+		// a later edge of the source replaces this one, edges into other processes are dropped once all are declared
+		postsynaptic_edges_.emplace_back(source, target);
+		return;
+	}
+	
+	// edges into the neurons of other processes are kept by them
+	if (target < first_ || target >= first_ + end_ - begin_) {
+		return;
+	}
+	
+	if (GetPosition(source) >= 0) {
+		neurons_[GetPosition(source)].AddPostsynapticNeuron(&neurons_[GetPosition(target)]);
+	}
+}
+
+__attribute__((visibility("default"))) const void NeuronalNetwork::Prepare() noexcept
+{
+	/*
+		establishes the network once, before the first bin
+		later calls keep the connectivity and the state of the neurons
+	*/
+	if (prepared_) {
+		return;
+	}
+	
+	InitializeNetwork();
+	
+	if (communicator_) {
+		// owned neurons and the neurons of other processes with edges into them, kept in id order
+		AllocatePartition();
+	} else if (s_reordering_) {
+		// renumber the neurons within their layers along their edges
+		Reorder();
+	}
+	
+	// resolve transmission delays and the synchronization window
+	ConfigureDelays();
+	
+	plastic_ = s_plasticity_;
+	
+	for (int i = 0; plastic_ && i < neurons_.size(); i++) {
+		// one gain per established edge
+		neurons_[i].EnablePlasticity();
+	}
+	
+	// layers whose neighbor currents are solved with their membrane update
+	ConfigureCoupling();
+	
+	if (!communicator_) {
+		// single process integrates all neurons
+		begin_ = 0;
+		end_ = (int)neurons_.size();
+	}
+	
+	if (!serial_ && !threadpool_) {
+		// initialize threadpool
+		threadpool_ = new ThreadPool<NeuronThread, NeuronArg, void*>((int)neurons_.size());
+		// the workers of a profiled network count their runs
+		ProfileWorkers();
+	}
+	
+	if (s_profiling_ && !counters_) {
+		// also counts the worker threads started from now on, the network is then stepped from this thread
+		counters_ = new PerfCounters(true);
+		phases_.assign((size_t)Phase::count, PerfCounters::Counts());
+		ProfileWorkers();
+	}
+	
+	prepared_ = true;
+}
+
 __attribute__((visibility("default"))) const void NeuronalNetwork::Start() noexcept
 {
 	/*
 		Performs Voltage clamp on layer 1
 		resues the threadpool to compute each layer sequentially
+		runs the remaining bins up to num_bins
 	*/
-	InitializeNetwork();
+	Prepare();
 	
 	// start and stop variables to store time stamps
 	std::chrono::time_point<std::chrono::system_clock> start, end;
 	
-	int count = 0;
-	// sum of neurons in all the layers
-	const int sum_neurons = std::accumulate(layers_sizes_.begin(), layers_sizes_.end(), 0);
 	// iterates over the number of bins
-	for (int t = 0; t < NeuronalNetwork::s_num_bins_; t++) {
+	while (bin_ < num_bins_ && !Cancelled()) {
 		// start time stamp for each bin
 		start = std::chrono::system_clock::now();
-		// iterates over the number of layers
-		for (int i = 0; i < layers_sizes_.size(); i++) {
-			count += layers_sizes_[i];
-			// branchless calculation of initial index of each layer i the array of total neurons in the system
-			int branchless = ((i == 0) ? 0 : (i == layers_sizes_.size() - 1) ? sum_neurons - layers_sizes_.back() : layers_sizes_[i - 1]);
-			// iterate over an individual layer
-			for (int j = branchless; j < layers_sizes_[i] + branchless; j++) {
-				// if iterating over the first layer
-				if (i == 0) { //  && (t < 5000 || t > 15000)
-					// voltage clamp neuron in first layer
-					neurons_[j].InjectCurrent(s_Iclamp_);
-				}
-				// add tasks to threadpool
-				sp_threadpool_->set_task<Neuron*, double>(&neurons_[j], s_dt_);
-			}
-			// start thread pool
-			sp_threadpool_->start();
-			// wait until threads have joined
-			sp_threadpool_->join();
-		}
+		
+		const int t = bin_;
+		const int bins = Advance(num_bins_ - bin_);
 		
 		// every 10 bins
-		if (t % 10 == 0) {
+		if (t % 10 < bins) {
 			// calculate end time
 			end = std::chrono::system_clock::now();
 			
 			// calculate time difference
 			std::chrono::duration<double> elapsed_seconds = end - start;
 			// print time step percentage and time difference
-			std::cout << "time step: " << (((double)t)/((double)NeuronalNetwork::s_num_bins_)) * 100 << "%, elapsed time: " << elapsed_seconds.count() << "s\n";
+			std::cout << "time step: " << (((double)t)/((double)num_bins_)) * 100 << "%, elapsed time: " << elapsed_seconds.count() << "s\n";
 		}
 	}
+	
+	if (writer_) {
+		// samples since the last hand-off
+		Persist();
+	}
+	
+	if (archive_) {
+		// last partial blocks
+		Archive();
+	}
+	
+	if (counters_) {
+		// run summary per phase and per worker thread
+		PrintProfile();
+	}
 }
 
-__attribute__((visibility("default"))) const void NeuronalNetwork::Stop() noexcept
+__attribute__((visibility("default"))) const int NeuronalNetwork::Step(const int bins) noexcept
 {
 	/*
-		asks theadpool to stop execution and clears the queue
+		bins = number of bins to integrate
+		advances the persistent network, stimuli and readouts are possible between calls
+		returns the next bin to integrate
 	*/
-	sp_threadpool_->stop();
-	sp_threadpool_->clear();
+	Prepare();
+	
+	const int last = bin_ + bins;
+	
+	while (bin_ < last && !Cancelled()) {
+		Advance(last - bin_);
+	}
+	
+	return bin_;
 }
 
-__attribute__((visibility("default"))) const void NeuronalNetwork::Cancel() noexcept
+__attribute__((visibility("default"))) const int NeuronalNetwork::RunUntil(const int bin) noexcept
 {
 	/*
-		forces theadpool to cancel execution
-		does not clear allocated objects
+		bin = bin to stop before
+		returns the next bin to integrate
 	*/
-	sp_threadpool_->cancel();
-	Stop();
+	return Step(std::max(bin - bin_, 0));
 }
 
-__attribute__((visibility("default"))) const void NeuronalNetwork::AllocateNeurons(size_t n) noexcept
+__attribute__((visibility("default"))) const int NeuronalNetwork::GetBin() const noexcept
 {
 	/*
-		Stores n neurons into the neurons_ vector;
+		returns the next bin to integrate
 	*/
-	for (int i = 0; i < n; i++) {
-		// initialize Neuron with random output current and neighboring current
-		neurons_.emplace_back(i, NeuronalNetwork::s_num_bins_, NeuronalNetwork::s_max_neighbors_);
-	}
+	return bin_;
 }
 
-__attribute__((visibility("default"))) std::vector<Neuron>& NeuronalNetwork::GetNeurons() noexcept
+__attribute__((visibility("default"))) const void NeuronalNetwork::Configure(const double clamp, const double dt, const int bins) noexcept
 {
 	/*
-		return neuron vector reference
+		clamp = current clamp of the first layer (µA)
+		dt = delta t, bin size (ms)
+		bins = number of bins run by Start, the recorded histories are reserved for them
+		settings of this network only, the defaults of other networks are left as they are
 	*/
-	return neurons_;
+	Iclamp_ = clamp;
+	dt_ = dt;
+	num_bins_ = bins;
+	
+	for (int i = 0; i < neurons_.size(); i++) {
+		// histories are only reserved if the membrane potential is recorded
+		if (neurons_[i].GetHistory().capacity() > 0) {
+			neurons_[i].ReserveHistory(bins);
+		}
+	}
 }
 
-__attribute__((visibility("default"))) const bool NeuronalNetwork::Stopped() noexcept
+__attribute__((visibility("default"))) const double NeuronalNetwork::GetTimeStep() const noexcept
 {
 	/*
-		checks if threadpool has stopped
+		returns delta t of this network, bin size
 	*/
-	return sp_threadpool_->stopped();
+	return dt_;
 }
 
-__attribute__((visibility("default"))) const void NeuronalNetwork::SetCurrentClamp(const double cc) noexcept
+__attribute__((visibility("default"))) const double NeuronalNetwork::GetCurrentClamp() const noexcept
 {
 	/*
-		sets static voltage_clamp
+		returns the current clamp [µA] of the first layer of this network
 	*/
-	NeuronalNetwork::s_Iclamp_ = cc;
+	return Iclamp_;
 }
 
-__attribute__((visibility("default"))) const void NeuronalNetwork::SetTimeStep(const double dt) noexcept
+__attribute__((visibility("default"))) const int NeuronalNetwork::GetSlowInterval() const noexcept
 {
 	/*
-		sets static delta t, bin size
+		returns the bins between updates of the slow gates h and n of this network
 	*/
-	NeuronalNetwork::s_dt_ = dt;
+	return slow_interval_;
 }
 
-__attribute__((visibility("default"))) const void NeuronalNetwork::SetNumBins(const int nb) noexcept
+__attribute__((visibility("default"))) const int NeuronalNetwork::Fork(const int branches, const int bins) noexcept
 {
 	/*
-		sets static number of bins, iterations
+		branches = number of child processes continuing from the current bin
+		bins = bins of every branch returned by Wait
+		every branch shares the connectivity and the recordings up to now copy-on-write with this process,
+		only the pages a branch writes, its neuron states and new samples, are copied
+		returns the branch in the child processes, which must call Join once done, -1 in this process
+		the membrane potentials must be recorded, they are the results of the branches
 	*/
-	NeuronalNetwork::s_num_bins_ = nb;
+	if (branch_ >= 0) {
+		printf("branch %d: nested fork error\n", branch_);
+		return -1;
+	}
+	
+	if (communicator_ && communicator_->Size() > 1) {
+		printf("fork error: the network is partitioned over %d processes\n", communicator_->Size());
+		return -1;
+	}
+	
+	for (int j = begin_; j < end_; j++) {
+		if (!neurons_[j].IsRecording()) {
+			printf("fork error: the membrane potential of neuron %u is not recorded, the branches would return no bins\n", neurons_[j].GetNeuronId());
+			return -1;
+		}
+	}
+	
+	// the worker threads of other networks may hold the static mutexes, the children get them unlocked
+	pthread_once(&s_atfork_, &NeuronalNetwork::RegisterFork);
+	
+	// connectivity is established once and shared by all branches
+	Prepare();
+	
+	if (writer_) {
+		// the branches do not stream, the file gets the bins up to the fork once
+		Persist();
+	}
+	
+	if (branches_) {
+		// results of the previous fork
+		Wait();
+		munmap(branches_, sizeof(double) * branch_count_ * neurons_.size() * branch_bins_);
+		branches_ = nullptr;
+	}
+	
+	branch_count_ = std::max(branches, 0);
+	branch_bins_ = std::max(bins, 0);
+	forked_ = bin_;
+	
+	const size_t bytes = sizeof(double) * branch_count_ * neurons_.size() * branch_bins_;
+	
+	if (bytes > 0) {
+		void* mapped = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+		
+		if (mapped == MAP_FAILED) {
+			printf("fork error: %zu bytes of branch results can not be mapped\n", bytes);
+			branch_count_ = 0;
+			return -1;
+		}
+		
+		branches_ = (double*)mapped;
+	}
+	
+	// buffered output would be printed again by every branch
+	std::cout.flush();
+	fflush(stdout);
+	
+	for (int i = 0; i < branch_count_; i++) {
+		const pid_t pid = fork();
+		
+		if (pid == 0) {
+			// the worker threads and the writer thread of this process do not exist in the child
+			branch_ = i;
+			children_.clear();
+			writer_ = nullptr;
+			telemetry_ = nullptr;
+			
+			if (counters_) {
+				delete counters_;
+				counters_ = nullptr;
+				ProfileWorkers();
+			}
+			
+			return branch_;
+		}
+		
+		if (pid < 0) {
+			printf("fork error: branch %d can not be started\n", i);
+			continue;
+		}
+		
+		children_.push_back(pid);
+	}
+	
+	return -1;
 }
 
-__attribute__((visibility("default"))) const void NeuronalNetwork::SetMaxNeighbors(const int mn) noexcept
+__attribute__((visibility("default"))) const void NeuronalNetwork::Join() noexcept
 {
 	/*
-		sets static estimated max number of neighbors
-		used to reserve memory in vectors, to reduce computation time of growing a vector dynamically
+		stores the membrane potentials of the branch since the fork and ends the child process
+		returns without effect in the forking process
+		a branch that stopped recording ends with a failure, which Wait reports
 	*/
-	NeuronalNetwork::s_max_neighbors_ = mn;
+	if (branch_ < 0) {
+		return;
+	}
+	
+	const size_t n = neurons_.size();
+	
+	for (int j = 0; j < n; j++) {
+		if (!neurons_[j].IsRecording()) {
+			printf("branch %d: join error: the membrane potential of neuron %u is not recorded\n", branch_, neurons_[j].GetNeuronId());
+			std::cout.flush();
+			fflush(stdout);
+			_exit(1);
+		}
+	}
+	
+	double* branch = branches_ + (size_t)branch_ * n * branch_bins_;
+	
+	for (int j = 0; j < n; j++) {
+		history_t& history = neurons_[j].GetHistory();
+		// bin of the first sample still in the history
+		const int first = bin_ - (int)neurons_[j].GetHistorySize();
+		const int begin = std::max(forked_ - first, 0);
+		const int count = std::max(std::min(branch_bins_, (int)history.size() - begin), 0);
+		
+		if (count > 0) {
+			memcpy(&branch[(size_t)neurons_[j].GetNeuronId() * branch_bins_], history.data() + begin, count * sizeof(double));
+		}
+	}
+	
+	// skips the destructors, the mapping and the parent's state are released by the parent
+	std::cout.flush();
+	fflush(stdout);
+	_exit(0);
 }
 
-pthread_mutex_t* NeuronalNetwork::ResultMutex() noexcept
+__attribute__((visibility("default"))) const double* NeuronalNetwork::Wait() noexcept
 {
 	/*
-		returns result mutex
+		waits for every branch of the last fork
+		returns the membrane potentials of the branches, branch b and neuron id i occupy
+		[(b * neurons + i) * bins, (b * neurons + i + 1) * bins), bins not integrated by a branch are 0
+		nullptr in the branches or without fork
 	*/
-	return &s_result_m_;
+	if (branch_ >= 0) {
+		return nullptr;
+	}
+	
+	for (int i = 0; i < children_.size(); i++) {
+		int status = 0;
+		
+		if (waitpid(children_[i], &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+			printf("fork error: branch process %d did not join\n", (int)children_[i]);
+		}
+	}
+	
+	children_.clear();
+	
+	return branches_;
 }
 
-pthread_mutex_t* NeuronalNetwork::QueueMutex() noexcept
+__attribute__((visibility("default"))) const int NeuronalNetwork::GetBranch() const noexcept
 {
 	/*
-		returns queue mutex
+		returns the branch integrated by this process, -1 in the forking process
 	*/
-	return &s_queue_m_;
+	return branch_;
 }
 
-NeuronalNetwork::NeuronArg::NeuronArg() {}
+__attribute__((visibility("default"))) const int NeuronalNetwork::GetBranchCount() const noexcept
+{
+	/*
+		returns number of branches of the last fork
+	*/
+	return branch_count_;
+}
 
-NeuronalNetwork::NeuronArg::NeuronArg(Neuron* neuron, double dt)
+__attribute__((visibility("default"))) const int NeuronalNetwork::GetBranchBins() const noexcept
 {
-	neuron_ = neuron;
-	dt_ = dt;
+	/*
+		returns bins recorded per branch of the last fork
+	*/
+	return branch_bins_;
 }
 
-// move constructor
-NeuronalNetwork::NeuronArg::NeuronArg(NeuronArg&& other): neuron_(std::move(other.neuron_)), dt_(std::move(other.dt_)) {}
+__attribute__((visibility("default"))) const void NeuronalNetwork::InjectCurrent(const int index, const double current) noexcept
+{
+	/*
+		index = neuron index
+		current = stimulus current added to the next bin of the neuron (µA)
+	*/
+	const int k = GetPosition(index);
+	
+	// neuron integrated by another process
+	if (!Owns(k)) {
+		return;
+	}
+	
+	neurons_[k].InjectCurrent(current);
+}
 
-NeuronalNetwork::NeuronArg::~NeuronArg() {}
+__attribute__((visibility("default"))) const void NeuronalNetwork::AddStimulus(const Stimulus& stimulus) noexcept
+{
+	/*
+		stimulus = protocol applied from the next bin on, replaces the current clamp of the first layer
+	*/
+	stimuli_.push_back(stimulus);
+}
 
-NeuronalNetwork::NeuronThread::NeuronThread(std::vector<NeuronArg>* queue, void* results, std::atomic<int>* count)
+__attribute__((visibility("default"))) const void NeuronalNetwork::ClearStimuli() noexcept
 {
-	queue_ = queue;
-	results_ = results;
-	a_count_ = count;
+	/*
+		removes all protocols, the current clamp of the first layer applies again
+	*/
+	stimuli_.clear();
 }
 
-// move construtor
-NeuronalNetwork::NeuronThread::NeuronThread(NeuronThread&& other): queue_(std::move(other.queue_)), results_(std::move(other.results_)), a_count_(std::move(other.a_count_)) {}
+__attribute__((visibility("default"))) const void NeuronalNetwork::AddProjection(const Projection& projection) noexcept
+{
+	/*
+		projection = weight matrix between a presynaptic and a postsynaptic range of neurons
+		added before the first bin it replaces the modulo wiring of the presynaptic layer,
+		added later the delays and the synchronization window are resolved again
+	*/
+	projections_.push_back(projection);
+	
+	if (!prepared_) {
+		return;
+	}
+	
+	ConfigureDelays();
+}
 
-NeuronalNetwork::NeuronThread::~NeuronThread() {}
+__attribute__((visibility("default"))) const bool NeuronalNetwork::HasProjection(const int layer) const noexcept
+{
+	/*
+		layer = layer index
+		returns true if a projection starts in the layer
+	*/
+	const int offset = GetLayerOffset(layer);
+	
+	for (int k = 0; k < projections_.size(); k++) {
+		if (projections_[k].GetSource() >= offset && projections_[k].GetSource() < offset + layers_sizes_[layer]) {
+			return true;
+		}
+	}
+	
+	return false;
+}
 
-void* NeuronalNetwork::NeuronThread::run() noexcept 
+__attribute__((visibility("default"))) const double NeuronalNetwork::GetMembranePotential(const int index) const noexcept
 {
 	/*
-		overwritten virtual run function
-		pulls neuron argument ( neuron pointer and delta t) from queue
-		performs calculation of membrane potential
+		index = neuron index
+		returns the membrane potential after the last integrated bin (mV)
 	*/
-	NeuronArg arg;
+	return neurons_[GetPosition(index)].GetMembranePotential();
+}
 
-	while (true) {
-		// lock queue mutex
-		pthread_mutex_lock(&s_queue_m_);
-		// breaks while loop if queue is empty or stopped flag is triggered
-		if (queue_->empty() || stopped()) {
-			// unlock queue mutex
-			pthread_mutex_unlock(&s_queue_m_);
-			break;
+const int NeuronalNetwork::Advance(const int bins) noexcept
+{
+	/*
+		bins = maximum number of bins to integrate
+		integrates one synchronization window, or one bin if the layers are processed sequentially
+		returns the number of integrated bins
+	*/
+	int count = 1;
+	
+	if (counters_) {
+		// time between steps is not attributed to any phase
+		marked_ = counters_->Read();
+	}
+	
+	if (writer_ && !archive_ && !tracing_) {
+		// records the neurons store their samples to until the next hand-off
+		Trace();
+		Mark(Phase::archive);
+	}
+	
+	if (window_ > 0) {
+		// spikes arrive at least window_ bins later, neurons run independently until the next synchronization
+		// windows end on the reduction intervals, so that every interval counts the spikes of its own bins
+		count = std::min({window_, bins, std::max(s_reduce_interval_ - (bin_ - reduced_), 1)});
+		
+		if (tracing_) {
+			// the records hold the bins up to the next hand-off
+			count = std::min(count, std::max(s_write_interval_ - (bin_ - written_), 1));
 		}
-		// moves neuron argument from back of queue to local variable
-		arg = std::move(queue_->back());
-		// pop last element in the queue
-		queue_->pop_back();
-		// unlock queue mutex
-		pthread_mutex_unlock(&s_queue_m_);
 		
-		if (arg.neuron_) {
-			// update membrane potential
-			arg.neuron_->Process(arg.dt_);
+		// stimulus currents of the window
+		Drive(count);
+		Mark(Phase::drive);
+		
+		for (int j = begin_; j < end_; j++) {
+			if (serial_) {
+				// integrate in the calling thread
+				Integrate(NeuronArg(&neurons_[j], dt_, tolerance_, slow_interval_, count, &drive_[(size_t)(j - begin_) * count]));
+				continue;
+			}
+			// add tasks to threadpool
+			threadpool_->set_task<Neuron*, double, double, int, int, const double*>(&neurons_[j], dt_, tolerance_, slow_interval_, count, &drive_[(size_t)(j - begin_) * count]);
 		}
-		// increments count
-		(*a_count_)++;
+		if (!serial_) {
+			// start thread pool
+			threadpool_->start();
+			// wait until threads have joined
+			threadpool_->join();
+		}
+		Mark(Phase::integrate);
+		// exchange spikes of the window between processes and deliver them
+		Exchange(begin_, end_);
+		Mark(Phase::exchange);
+	} else {
+		// stimulus currents of the bin
+		Drive(1);
+		Mark(Phase::drive);
+		
+		// initial index of each layer in the array of total neurons in the system
+		int offset = 0;
+		// iterates over the number of layers
+		for (int i = 0; i < layers_sizes_.size(); offset += layers_sizes_[i], i++) {
+			// positions of the layer integrated by this process
+			const int first = std::max(Locate(offset), begin_);
+			const int last = std::min(Locate(offset + layers_sizes_[i]), end_);
+			// neighbor currents of the layer received within the bin
+			const bool coupled = coupling_[i] != Coupling::none;
+			// iterate over an individual layer
+			for (int j = first; j < last; j++) {
+				if (drive_[j - begin_] != 0) {
+					// stimulate neuron
+					neurons_[j].InjectCurrent(drive_[j - begin_]);
+				}
+				if (coupled) {
+					// integrated with the whole layer
+					continue;
+				}
+				// skip neurons resting at a fixed point without input
+				if (neurons_[j].Dormant()) {
+					neurons_[j].Idle(dt_);
+					continue;
+				}
+				if (serial_) {
+					// integrate in the calling thread
+					Integrate(NeuronArg(&neurons_[j], dt_, tolerance_, slow_interval_));
+					continue;
+				}
+				// add tasks to threadpool
+				threadpool_->set_task<Neuron*, double, double, int>(&neurons_[j], dt_, tolerance_, slow_interval_);
+			}
+			if (coupled) {
+				// one solve of the layer in the calling thread
+				Neuron::IntegrateLayer(&neurons_[first], last - first, dt_, coupling_[i] == Coupling::forward, coupled_);
+			} else if (!serial_) {
+				// start thread pool
+				threadpool_->start();
+				// wait until threads have joined
+				threadpool_->join();
+			}
+			Mark(Phase::integrate);
+			// exchange spikes of the layer between processes and deliver them
+			Exchange(first, last, !coupled);
+			Mark(Phase::exchange);
+		}
+	}
+	
+	bin_ += count;
+	
+	if (telemetry_) {
+		// samples and spikes of the monitored neurons, before the plasticity pass consumes the spike times
+		Publish();
+		Mark(Phase::publish);
+	}
+	
+	if (plastic_) {
+		// gains of the edges with spikes in the window
+		Learn();
+		Mark(Phase::learn);
+	}
+	
+	if (bin_ - reduced_ >= s_reduce_interval_) {
+		// population rates of the interval
+		Reduce();
+		Mark(Phase::reduce);
+	}
+	
+	const bool move = archive_ && bin_ - archived_ >= archive_->GetBlock();
+	
+	if (writer_ && (bin_ - written_ >= s_write_interval_ || move)) {
+		// copies of the recorded membrane potentials to the writer, before the move empties the histories
+		Stage();
+		Mark(Phase::archive);
+	}
+	
+	if (move) {
+		// whole blocks of the recorded membrane potentials
+		Move();
+		Mark(Phase::archive);
+	}
+	
+	return count;
+}
+
+__attribute__((visibility("default"))) const void NeuronalNetwork::Stop() noexcept
+{
+	/*
+		asks theadpool to stop execution and clears the queue
+	*/
+	if (!threadpool_) {
+		return;
+	}
+	threadpool_->stop();
+	threadpool_->clear();
+}
+
+__attribute__((visibility("default"))) const void NeuronalNetwork::Cancel() noexcept
+{
+	/*
+		asks a running Start or Step to return at the next bin boundary, callable from any thread
+		the state of the bins integrated so far is kept, later calls of Start and Step return at once
+	*/
+	a_cancelled_.store(true, std::memory_order_release);
+}
+
+__attribute__((visibility("default"))) const bool NeuronalNetwork::Cancelled() const noexcept
+{
+	/*
+		returns true once Cancel was called
+	*/
+	return a_cancelled_.load(std::memory_order_acquire);
+}
+
+__attribute__((visibility("default"))) const void NeuronalNetwork::AllocateNeurons(size_t n) noexcept
+{
+	/*
+		Stores n neurons into the neurons_ vector;
+		the neurons, their neighbor arrays and history logs are carved from one arena reservation
+	*/
+	// history logs are only reserved if the membrane potential is recorded
+	const int bins = NeuronalNetwork::s_recording_ ? num_bins_ : 0;
+	const size_t bytes = n * (sizeof(Neuron) + bins * sizeof(double) + NeuronalNetwork::s_max_neighbors_ * sizeof(Neuron*) + 4 * alignof(Neuron));
+	arena_.Reserve(bytes, NeuronalNetwork::s_huge_pages_);
+	
+	if (neurons_.empty()) {
+		neurons_ = neurons_t(ArenaAllocator<Neuron>(&arena_));
+	}
+	neurons_.reserve(neurons_.size() + n);
+	
+	for (int i = 0; i < n; i++) {
+		// initialize Neuron with random output current and neighboring current
+		neurons_.emplace_back(i, bins, NeuronalNetwork::s_max_neighbors_, &arena_);
+		neurons_.back().Record(NeuronalNetwork::s_recording_);
+	}
+}
+
+__attribute__((visibility("default"))) const void NeuronalNetwork::Reorder() noexcept
+{
+	/*
+		renumbers the neurons within their layers in reverse Cuthill-McKee order of their edges
+		the targets of a neuron then lie close to it in GetNeurons, the span of the edges narrows
+		the layers keep their ranges, ids are kept and GetPosition maps them to the new positions
+		spikes are delivered in id order, the membrane potentials are the same as without renumbering
+		runs once the connectivity is established, before the first bin
+	*/
+	const int n = (int)neurons_.size();
+	
+	if (n == 0 || !positions_.empty() || bin_ > 0) {
+		return;
+	}
+	
+	Neuron* first = neurons_.data();
+	
+	// undirected adjacency of the neighbor and postsynaptic edges
+	std::vector<std::vector<int>> adjacency(n);
+	
+	for (int i = 0; i < n; i++) {
+		for (int k = 0; k < neurons_[i].GetNeighborCount(); k++) {
+			const int j = (int)(neurons_[i].GetNeighbor(k) - first);
+			adjacency[i].push_back(j);
+			adjacency[j].push_back(i);
+		}
+		if (neurons_[i].HasPostsynapticNeuron()) {
+			const int j = (int)(neurons_[i].GetPostsynapticNeuron() - first);
+			adjacency[i].push_back(j);
+			adjacency[j].push_back(i);
+		}
+	}
+	
+	for (int i = 0; i < n; i++) {
+		std::sort(adjacency[i].begin(), adjacency[i].end());
+		adjacency[i].erase(std::unique(adjacency[i].begin(), adjacency[i].end()), adjacency[i].end());
+	}
+	
+	// breadth first search from the lowest degree neuron of every component, lower degrees first
+	std::vector<int> degrees(n);
+	std::iota(degrees.begin(), degrees.end(), 0);
+	std::stable_sort(degrees.begin(), degrees.end(), [&](const int a, const int b) {
+		return adjacency[a].size() < adjacency[b].size();
+	});
+	
+	std::vector<int> order;
+	std::vector<bool> visited(n, false);
+	order.reserve(n);
+	
+	for (int r = 0; r < n; r++) {
+		if (visited[degrees[r]]) {
+			continue;
+		}
+		
+		visited[degrees[r]] = true;
+		order.push_back(degrees[r]);
+		
+		for (size_t head = order.size() - 1; head < order.size(); head++) {
+			std::vector<int>& edges = adjacency[order[head]];
+			std::stable_sort(edges.begin(), edges.end(), [&](const int a, const int b) {
+				return adjacency[a].size() < adjacency[b].size();
+			});
+			for (int j : edges) {
+				if (!visited[j]) {
+					visited[j] = true;
+					order.push_back(j);
+				}
+			}
+		}
+	}
+	
+	// reversed order, each layer filled from its own offset
+	std::vector<int> layers(n, 0);
+	std::vector<int> next(layers_sizes_.size() + 1, 0);
+	
+	for (int i = 0, offset = 0; i < layers_sizes_.size(); offset += layers_sizes_[i], i++) {
+		std::fill(layers.begin() + std::min(offset, n), layers.begin() + std::min(offset + layers_sizes_[i], n), i);
+		next[i] = offset;
+	}
+	
+	std::vector<int> position(n);
+	
+	for (int r = n - 1; r >= 0; r--) {
+		position[order[r]] = next[layers[order[r]]]++;
+	}
+	
+	// apply the permutation in place, cycle by cycle
+	std::vector<int> target = position;
+	
+	for (int i = 0; i < n; i++) {
+		while (target[i] != i) {
+			const int t = target[i];
+			neurons_[i].Swap(neurons_[t]);
+			std::swap(target[i], target[t]);
+		}
+	}
+	
+	for (int i = 0; i < n; i++) {
+		neurons_[i].Relink(first, position.data(), n);
+	}
+	
+	positions_.assign(n, 0);
+	
+	for (int i = 0; i < n; i++) {
+		positions_[neurons_[i].GetNeuronId()] = i;
+	}
+}
+
+__attribute__((visibility("default"))) const int NeuronalNetwork::GetPosition(const int id) const noexcept
+{
+	/*
+		id = neuron id
+		returns the position of the neuron in GetNeurons, the id itself unless reordered or partitioned
+		-1 if the neuron is not stored by this process
+	*/
+	if (!locals_.empty()) {
+		const std::vector<int>::const_iterator it = std::lower_bound(locals_.begin(), locals_.end(), id);
+		return (it != locals_.end() && *it == id) ? (int)(it - locals_.begin()) : -1;
+	}
+	
+	if (id < 0 || id >= neurons_.size()) {
+		return -1;
+	}
+	
+	return positions_.empty() ? id : positions_[id];
+}
+
+__attribute__((visibility("default"))) neurons_t& NeuronalNetwork::GetNeurons() noexcept
+{
+	/*
+		return neuron vector reference
+	*/
+	return neurons_;
+}
+
+__attribute__((visibility("default"))) const std::vector<int>& NeuronalNetwork::GetLayers() const noexcept
+{
+	/*
+		return layer sizes reference
+	*/
+	return layers_sizes_;
+}
+
+__attribute__((visibility("default"))) const void NeuronalNetwork::SetTelemetry(Telemetry* telemetry, const std::vector<int>& neurons, const int decimation) noexcept
+{
+	/*
+		telemetry = ring buffer the monitored neurons are published to, nullptr stops publishing
+		neurons = indices of the monitored neurons
+		decimation = bins between membrane potential samples
+	*/
+	for (int i = 0; i < monitored_.size(); i++) {
+		neurons_[GetPosition(monitored_[i])].Monitor(false);
+	}
+	
+	telemetry_ = telemetry;
+	monitored_.clear();
+	
+	for (int i = 0; telemetry_ && i < neurons.size(); i++) {
+		const int k = GetPosition(neurons[i]);
+		if (k >= 0) {
+			monitored_.push_back(neurons[i]);
+			// spike times are logged from now on
+			neurons_[k].Monitor(true);
+		}
+	}
+	
+	decimation_ = std::max(decimation, 1);
+	sampled_ = -1;
+}
+
+__attribute__((visibility("default"))) const void NeuronalNetwork::SetArchive(TraceArchive* archive) noexcept
+{
+	/*
+		archive = compressed store the recorded membrane potentials are moved to, nullptr keeps them in the histories
+		the histories only hold the bins since the last move, GetHistory then returns these bins
+	*/
+	if (tracing_) {
+		// the bins stored in place go to the writer, the archive starts with the histories
+		Stage();
+	}
+	
+	archive_ = archive;
+	archived_ = bin_;
+	
+	for (int i = 0; archive_ && i < neurons_.size(); i++) {
+		neurons_[i].Record(true);
+	}
+}
+
+__attribute__((visibility("default"))) const void NeuronalNetwork::Archive() noexcept
+{
+	/*
+		moves the recorded membrane potentials into the archive and encodes the partial blocks
+	*/
+	if (!archive_) {
+		return;
+	}
+	
+	if (writer_) {
+		Stage();
+	}
+	
+	Move();
+	archive_->Flush();
+}
+
+__attribute__((visibility("default"))) const void NeuronalNetwork::SetWriter(TraceWriter* writer) noexcept
+{
+	/*
+		writer = file the recorded membrane potentials are streamed to, nullptr stops
+		the neurons store their samples in place into the writer's staging blocks, the writer thread does the I/O
+		the histories only hold the samples that did not fit, they are dropped once handed off,
+		an archive keeps the histories and the samples are copied out of them instead
+	*/
+	if (writer_) {
+		// the previous writer gets the samples up to now
+		Stage();
+	}
+	
+	writer_ = writer;
+	written_ = bin_;
+	
+	staged_.assign(neurons_.size(), 0);
+	sent_.assign(neurons_.size(), bin_);
+	
+	for (int j = 0; writer_ && j < neurons_.size(); j++) {
+		neurons_[j].Record(true);
+		// samples already in the history are streamed as well
+		sent_[j] = bin_ - (int)neurons_[j].GetHistorySize();
+	}
+}
+
+__attribute__((visibility("default"))) const void NeuronalNetwork::Persist() noexcept
+{
+	/*
+		hands the samples since the last hand-off to the writer and waits until they are in the file
+	*/
+	if (!writer_) {
+		return;
+	}
+	
+	Stage();
+	writer_->Flush();
+}
+
+__attribute__((visibility("default"))) const bool NeuronalNetwork::Owns(const int index) const noexcept
+{
+	/*
+		index = position of the neuron
+		returns true if the neuron is integrated by this process
+	*/
+	return index >= begin_ && index < end_;
+}
+
+__attribute__((visibility("default"))) const void NeuronalNetwork::SetSerial(const bool serial) noexcept
+{
+	/*
+		serial = true integrates the neurons in the calling thread instead of the threadpool
+		for small networks run as independent replicas, set before the first step
+	*/
+	serial_ = serial;
+}
+
+__attribute__((visibility("default"))) const PerfCounters::Counts NeuronalNetwork::GetPhaseCounts(const Phase phase) const noexcept
+{
+	/*
+		phase = phase of the bins
+		returns the counts of the stepping thread and its workers accumulated in the phase, zero unless profiled
+	*/
+	return ((size_t)phase < phases_.size()) ? phases_[(size_t)phase] : PerfCounters::Counts();
+}
+
+__attribute__((visibility("default"))) const std::vector<PerfCounters::Counts> NeuronalNetwork::GetWorkerCounts() noexcept
+{
+	/*
+		returns the counts of every worker thread of the threadpool, empty if serial
+		only read between steps
+	*/
+	std::vector<PerfCounters::Counts> workers;
+	
+	if (!threadpool_) {
+		return workers;
+	}
+	
+	std::vector<NeuronThread>* threads = threadpool_->threads();
+	
+	for (int i = 0; i < threads->size(); i++) {
+		workers.push_back((*threads)[i].GetCounts());
+	}
+	
+	return workers;
+}
+
+__attribute__((visibility("default"))) const void NeuronalNetwork::PrintProfile() noexcept
+{
+	/*
+		prints the time, hardware counts and throughput of every phase and every worker thread
+		the phases include the worker threads, counts read 0 if the counters are unavailable
+	*/
+	static const char* names[] = {"drive", "integrate", "exchange", "learn", "publish", "reduce", "archive"};
+	
+	PerfCounters::Counts total;
+	for (int i = 0; i < phases_.size(); i++) {
+		total += phases_[i];
+	}
+	
+	// neuron updates per second
+	const double throughput = (total.seconds_ > 0) ? (double)(end_ - begin_) * bin_ / total.seconds_ : 0;
+	
+	printf("profile: %i bins, %.3fs, %.3g neuron bins/s%s\n", bin_, total.seconds_, throughput, (counters_ && counters_->Available()) ? "" : ", hardware counters unavailable");
+	
+	for (int i = 0; i < phases_.size(); i++) {
+		const PerfCounters::Counts& counts = phases_[i];
+		if (counts.intervals_ == 0) {
+			continue;
+		}
+		printf("  %-10s %9.4fs %5.1f%%  cycles %12llu  IPC %5.2f  LLC misses %10llu  branch misses %10llu\n", names[i], counts.seconds_, (total.seconds_ > 0) ? 100.0 * counts.seconds_ / total.seconds_ : 0, (unsigned long long)counts.cycles_, counts.GetIPC(), (unsigned long long)counts.cache_misses_, (unsigned long long)counts.branch_misses_);
+	}
+	
+	const std::vector<PerfCounters::Counts> workers = GetWorkerCounts();
+	
+	for (int i = 0; i < workers.size(); i++) {
+		if (workers[i].intervals_ == 0) {
+			continue;
+		}
+		printf("  worker %-3i %9.4fs %6zu runs  cycles %12llu  IPC %5.2f  LLC misses %10llu  branch misses %10llu\n", i, workers[i].seconds_, workers[i].intervals_, (unsigned long long)workers[i].cycles_, workers[i].GetIPC(), (unsigned long long)workers[i].cache_misses_, (unsigned long long)workers[i].branch_misses_);
+	}
+}
+
+__attribute__((visibility("default"))) const bool NeuronalNetwork::Stopped() noexcept
+{
+	/*
+		checks if threadpool has stopped
+	*/
+	return !threadpool_ || threadpool_->stopped();
+}
+
+__attribute__((visibility("default"))) const void NeuronalNetwork::SetCurrentClamp(const double cc) noexcept
+{
+	/*
+		sets static voltage_clamp, applies to networks built afterwards
+	*/
+	NeuronalNetwork::s_Iclamp_ = cc;
+}
+
+__attribute__((visibility("default"))) const void NeuronalNetwork::SetTimeStep(const double dt) noexcept
+{
+	/*
+		sets static delta t, bin size, applies to networks built afterwards
+	*/
+	NeuronalNetwork::s_dt_ = dt;
+}
+
+__attribute__((visibility("default"))) const bool NeuronalNetwork::SetTolerance(const double tol) noexcept
+{
+	/*
+		sets static adaptive integration tolerance [mV], applies to networks built afterwards
+		bins are then spike exchange intervals integrated with adaptive sub-steps, which span the bins of a
+		synchronization window, processed layer by layer every bin they only refine the bins
+		returns false and keeps the tolerance if the slow gates are integrated at multiple rates
+		or the neighbor currents implicitly
+	*/
+	if (tol > 0 && s_slow_interval_ > 1) {
+		printf("adaptive integration error: the slow gates are updated every %d bins, multi-rate integration is fixed step only\n", s_slow_interval_);
+		return false;
+	}
+	if (tol > 0 && s_implicit_) {
+		printf("adaptive integration error: the neighbor currents are solved implicitly with the fixed time step\n");
+		return false;
+	}
+	
+	NeuronalNetwork::s_tolerance_ = tol;
+	return true;
+}
+
+__attribute__((visibility("default"))) const bool NeuronalNetwork::SetSlowInterval(const int bins) noexcept
+{
+	/*
+		bins = bins between updates of the slow gates h and n of the fixed time step integration, applies to networks built afterwards
+		the gates then advance over the whole interval at once, with the rates at the end of its first bin, and are
+		interpolated on the other bins, 1 restores the single rate update
+		the other bins save four of the six rate evaluations and two of the gate exponentials
+		returns false and keeps the interval if the networks built afterwards integrate adaptively,
+		their sub-steps update all gates together, or solve the neighbor currents implicitly
+	*/
+	if (bins > 1 && s_tolerance_ > 0) {
+		printf("multi-rate error: adaptive integration with a tolerance of %g mV updates all gates every sub-step\n", s_tolerance_);
+		return false;
+	}
+	if (bins > 1 && s_implicit_) {
+		printf("multi-rate error: the implicitly coupled layers update all gates every bin\n");
+		return false;
+	}
+	
+	NeuronalNetwork::s_slow_interval_ = std::max(bins, 1);
+	return true;
+}
+
+__attribute__((visibility("default"))) const bool NeuronalNetwork::SetImplicitCoupling(const bool implicit) noexcept
+{
+	/*
+		implicit = solves the neighbor currents of a layer together with its membrane update, applies to networks built afterwards
+		the spikes of a bin then reach the neighbors within the bin instead of the next one
+		returns false and keeps the setting if the networks integrate adaptively or the slow gates at multiple rates,
+		the coupled update integrates all gates of the layer with the fixed time step
+	*/
+	if (implicit && s_slow_interval_ > 1) {
+		printf("implicit coupling error: the slow gates are updated every %d bins, the coupled layers update all gates every bin\n", s_slow_interval_);
+		return false;
+	}
+	if (implicit && s_tolerance_ > 0) {
+		printf("implicit coupling error: adaptive integration with a tolerance of %g mV integrates the neurons independently\n", s_tolerance_);
+		return false;
+	}
+	
+	NeuronalNetwork::s_implicit_ = implicit;
+	return true;
+}
+
+__attribute__((visibility("default"))) const void NeuronalNetwork::SetNumBins(const int nb) noexcept
+{
+	/*
+		sets static number of bins, iterations, applies to networks built afterwards
+		the histories of a network are reserved for its number of bins
+	*/
+	NeuronalNetwork::s_num_bins_ = nb;
+}
+
+__attribute__((visibility("default"))) const void NeuronalNetwork::SetMaxNeighbors(const int mn) noexcept
+{
+	/*
+		sets static estimated max number of neighbors
+		used to reserve memory in vectors, to reduce computation time of growing a vector dynamically
+	*/
+	NeuronalNetwork::s_max_neighbors_ = mn;
+}
+
+__attribute__((visibility("default"))) const void NeuronalNetwork::SetHugePages(const bool huge_pages) noexcept
+{
+	/*
+		sets static huge page backing of the neuron arena
+	*/
+	NeuronalNetwork::s_huge_pages_ = huge_pages;
+}
+
+__attribute__((visibility("default"))) const void NeuronalNetwork::SetRecording(const bool recording) noexcept
+{
+	/*
+		sets static recording of the membrane potential of every bin
+		without recording only the streaming accumulators are kept, applies to networks built afterwards
+	*/
+	NeuronalNetwork::s_recording_ = recording;
+}
+
+__attribute__((visibility("default"))) const void NeuronalNetwork::SetReduceInterval(const int bins) noexcept
+{
+	/*
+		sets static number of bins between reductions of the neuron accumulators into the layers
+	*/
+	NeuronalNetwork::s_reduce_interval_ = std::max(bins, 1);
+}
+
+__attribute__((visibility("default"))) const void NeuronalNetwork::SetPlasticity(const bool plasticity) noexcept
+{
+	/*
+		sets static spike timing dependent plasticity of the postsynaptic and neighbor edges
+		parameters are set with Neuron::SetPlasticity
+	*/
+	NeuronalNetwork::s_plasticity_ = plasticity;
+}
+
+__attribute__((visibility("default"))) const void NeuronalNetwork::SetSynapticDelay(const int delay) noexcept
+{
+	/*
+		sets static transmission delay between layers (bins)
+		used by neurons without an explicit postsynaptic delay
+	*/
+	NeuronalNetwork::s_synaptic_delay_ = delay;
+}
+
+__attribute__((visibility("default"))) const void NeuronalNetwork::SetNeighborDelay(const int delay) noexcept
+{
+	/*
+		sets static transmission delay between neighboring neurons (bins)
+		used by neurons without an explicit neighbor delay
+	*/
+	NeuronalNetwork::s_neighbor_delay_ = delay;
+}
+
+__attribute__((visibility("default"))) const void NeuronalNetwork::SetReordering(const bool reordering) noexcept
+{
+	/*
+		sets static renumbering of the neurons within their layers, applies to networks prepared afterwards
+		ids stay stable, the position of a neuron in GetNeurons is given by GetPosition
+	*/
+	NeuronalNetwork::s_reordering_ = reordering;
+}
+
+__attribute__((visibility("default"))) const void NeuronalNetwork::SetProfiling(const bool profiling) noexcept
+{
+	/*
+		sets static hardware counters per phase and per worker thread, applies to networks prepared afterwards
+		every phase boundary then costs a few system calls, every worker run opens its own counters
+	*/
+	NeuronalNetwork::s_profiling_ = profiling;
+}
+
+__attribute__((visibility("default"))) const void NeuronalNetwork::Reduce() noexcept
+{
+	/*
+		reduces the spikes of every layer since the last reduction into its population rate
+		only complete intervals are closed, the spikes of a partial interval are carried to the next one
+		neurons are only read between windows, when no thread integrates them
+	*/
+	if (bin_ - reduced_ < s_reduce_interval_) {
+		return;
+	}
+	
+	populations_.resize(layers_sizes_.size());
+	
+	for (int i = 0; i < layers_sizes_.size(); i++) {
+		const int offset = GetLayerOffset(i);
+		size_t spikes = 0;
+		int neurons = 0;
+		
+		for (int j = std::max(Locate(offset), begin_); j < std::min(Locate(offset + layers_sizes_[i]), end_); j++) {
+			spikes += neurons_[j].GetStatistics().TakeIntervalSpikes();
+			neurons++;
+		}
+		
+		populations_[i].Add(spikes, neurons, bin_ - reduced_, dt_);
+	}
+	
+	reduced_ = bin_;
+}
+
+__attribute__((visibility("default"))) Statistics& NeuronalNetwork::GetNeuronStatistics(const int index) noexcept
+{
+	/*
+		index = neuron index
+		returns the accumulators of the neuron
+	*/
+	return neurons_[GetPosition(index)].GetStatistics();
+}
+
+__attribute__((visibility("default"))) Statistics NeuronalNetwork::GetLayerStatistics(const int layer) noexcept
+{
+	/*
+		layer = layer index
+		returns the accumulators of the owned neurons of the layer merged together
+	*/
+	Statistics statistics;
+	const int offset = GetLayerOffset(layer);
+	
+	for (int j = std::max(Locate(offset), begin_); j < std::min(Locate(offset + layers_sizes_[layer]), end_); j++) {
+		statistics.Merge(neurons_[j].GetStatistics());
+	}
+	
+	return statistics;
+}
+
+__attribute__((visibility("default"))) const PopulationStatistics& NeuronalNetwork::GetPopulationStatistics(const int layer) const noexcept
+{
+	/*
+		layer = layer index
+		returns the population rate time series of the layer
+	*/
+	static const PopulationStatistics empty;
+	return (layer < populations_.size()) ? populations_[layer] : empty;
+}
+
+const int NeuronalNetwork::GetLayerOffset(const int layer) const noexcept
+{
+	/*
+		returns the index of the first neuron of the layer
+	*/
+	return std::accumulate(layers_sizes_.begin(), layers_sizes_.begin() + layer, 0);
+}
+
+const int NeuronalNetwork::Locate(const int id) const noexcept
+{
+	/*
+		returns the position of the first stored neuron with an id not below id
+		ranges of layer or stimulus ids map to ranges of positions, renumbering keeps the layer ranges
+	*/
+	if (locals_.empty()) {
+		return id;
+	}
+	
+	return (int)(std::lower_bound(locals_.begin(), locals_.end(), id) - locals_.begin());
+}
+
+const void NeuronalNetwork::AllocatePartition() noexcept
+{
+	/*
+		allocates the owned neurons and the neurons of other processes with edges into them, in id order,
+		and wires the edges declared by InitializeNetwork
+		the other neurons are never integrated, they transmit the gathered spikes of their process to the owned neurons
+		the random currents of every id are drawn, stored or not, all processes build the same neurons
+	*/
+	const int sum_neurons = GetLayerOffset((int)layers_sizes_.size());
+	const int count = end_ - begin_;
+	
+	// last postsynaptic neuron declared for every source, kept if it is owned
+	std::stable_sort(postsynaptic_edges_.begin(), postsynaptic_edges_.end(), [](const std::pair<int, int>& a, const std::pair<int, int>& b) {
+		return a.first < b.first;
+	});
+	
+	std::vector<std::pair<int, int>> postsynaptic;
+	
+	for (int k = 0; k < postsynaptic_edges_.size(); k++) {
+		const bool last = k + 1 == postsynaptic_edges_.size() || postsynaptic_edges_[k + 1].first != postsynaptic_edges_[k].first;
+		const int target = postsynaptic_edges_[k].second;
+		if (last && target >= first_ && target < first_ + count) {
+			postsynaptic.push_back(postsynaptic_edges_[k]);
+		}
+	}
+	
+	postsynaptic_edges_.swap(postsynaptic);
+	
+	locals_.resize(count);
+	std::iota(locals_.begin(), locals_.end(), first_);
+	
+	for (int k = 0; k < neighbor_edges_.size(); k++) {
+		locals_.push_back(neighbor_edges_[k].first);
+	}
+	for (int k = 0; k < postsynaptic_edges_.size(); k++) {
+		locals_.push_back(postsynaptic_edges_[k].first);
+	}
+	
+	std::sort(locals_.begin(), locals_.end());
+	locals_.erase(std::unique(locals_.begin(), locals_.end()), locals_.end());
+	
+	// neighbor arrays are reserved to the edges into the owned neurons
+	std::vector<int> neighbors(locals_.size(), 0);
+	for (int k = 0; k < neighbor_edges_.size(); k++) {
+		neighbors[Locate(neighbor_edges_[k].first)]++;
+	}
+	
+	// history logs of the owned neurons are only reserved if the membrane potential is recorded
+	const int bins = NeuronalNetwork::s_recording_ ? num_bins_ : 0;
+	const size_t bytes = locals_.size() * (sizeof(Neuron) + 4 * alignof(Neuron)) + (size_t)count * bins * sizeof(double) + neighbor_edges_.size() * sizeof(Neuron*);
+	arena_.Reserve(bytes, NeuronalNetwork::s_huge_pages_);
+	
+	neurons_ = neurons_t(ArenaAllocator<Neuron>(&arena_));
+	neurons_.reserve(locals_.size());
+	
+	for (int i = 0, k = 0; i < sum_neurons; i++) {
+		if (k == locals_.size() || locals_[k] != i) {
+			Neuron::Skip();
+			continue;
+		}
+		const bool owned = i >= first_ && i < first_ + count;
+		neurons_.emplace_back(i, owned ? bins : 0, neighbors[k], &arena_);
+		neurons_.back().Record(owned && NeuronalNetwork::s_recording_);
+		k++;
+	}
+	
+	begin_ = Locate(first_);
+	end_ = begin_ + count;
+	
+	for (int k = 0; k < neighbor_edges_.size(); k++) {
+		neurons_[GetPosition(neighbor_edges_[k].first)].AddNeighbor(&neurons_[GetPosition(neighbor_edges_[k].second)]);
+	}
+	for (int k = 0; k < postsynaptic_edges_.size(); k++) {
+		neurons_[GetPosition(postsynaptic_edges_[k].first)].AddPostsynapticNeuron(&neurons_[GetPosition(postsynaptic_edges_[k].second)]);
+	}
+	
+	neighbor_edges_ = std::vector<std::pair<int, int>>();
+	postsynaptic_edges_ = std::vector<std::pair<int, int>>();
+}
+
+const void NeuronalNetwork::Learn() noexcept
+{
+	/*
+		batched plasticity pass after a window, neurons are not integrated meanwhile
+		the neurons that spiked are marked once in a bitmap by position, so that the edges test a bit instead of their target
+		skipped entirely if no neuron spiked, the traces are consolidated once all gains are updated
+	*/
+	bool active = false;
+	
+	spiked_.assign((neurons_.size() + 63) / 64, 0);
+	
+	for (int j = begin_; j < end_; j++) {
+		if (neurons_[j].HasEvents()) {
+			spiked_[j >> 6] |= (uint64_t)1 << (j & 63);
+			active = true;
+		}
+	}
+	
+	if (!active) {
+		return;
+	}
+	
+	for (int j = begin_; j < end_; j++) {
+		if (serial_) {
+			// update in the calling thread
+			Plasticity(NeuronArg(&neurons_[j], neurons_.data(), spiked_.data()));
+			continue;
+		}
+		// add tasks to threadpool, every task only writes the gains of its own neuron
+		threadpool_->set_task<Neuron*, const Neuron*, const uint64_t*>(&neurons_[j], neurons_.data(), spiked_.data());
+	}
+	if (!serial_) {
+		// start thread pool
+		threadpool_->start();
+		// wait until threads have joined
+		threadpool_->join();
+	}
+	
+	for (int j = begin_; j < end_; j++) {
+		neurons_[j].Consolidate();
+	}
+}
+
+const void NeuronalNetwork::Publish() noexcept
+{
+	/*
+		publishes every spike of the monitored neurons since the last window with its bin and crossing time
+		and their membrane potential once every decimation bins
+		runs between windows before the plasticity pass consumes the spike times, the simulation threads never touch the ring buffer
+	*/
+	const bool sample = sampled_ < 0 || bin_ / decimation_ != sampled_ / decimation_;
+	
+	for (int k = 0; k < monitored_.size(); k++) {
+		const int id = monitored_[k];
+		const int j = GetPosition(id);
+		
+		if (!Owns(j)) {
+			continue;
+		}
+		
+		const std::vector<double>& events = neurons_[j].GetEvents();
+		for (int i = 0; i < events.size(); i++) {
+			// bin of the threshold crossing, within the window
+			const int bin = std::clamp((int)(events[i] / dt_), 0, bin_ - 1);
+			telemetry_->Publish(1, id, bin, events[i]);
+		}
+		
+		if (!plastic_) {
+			neurons_[j].ClearEvents();
+		}
+		
+		if (sample) {
+			telemetry_->Publish(0, id, bin_ - 1, neurons_[j].GetMembranePotential());
+		}
+	}
+	
+	if (sample) {
+		sampled_ = bin_;
+	}
+}
+
+const void NeuronalNetwork::Move() noexcept
+{
+	/*
+		appends the histories of the owned neurons to the archive and empties them
+		runs between windows, the histories are reused from their start
+	*/
+	for (int j = begin_; j < end_; j++) {
+		history_t& history = neurons_[j].GetHistory();
+		archive_->Append(neurons_[j].GetNeuronId(), history.data(), history.size());
+		history.clear();
+	}
+	
+	archived_ = bin_;
+	
+	if (writer_) {
+		std::fill(staged_.begin(), staged_.end(), 0);
+	}
+}
+
+const void NeuronalNetwork::Stage() noexcept
+{
+	/*
+		hands the samples of the owned neurons recorded since the last hand-off to the writer
+		closes the records stored in place, then copies the samples of the histories into the writer's blocks
+		runs between windows, the writer thread does the I/O while the next windows are integrated
+		without an archive the histories are dropped once handed off
+	*/
+	if (tracing_) {
+		for (int j = begin_; j < end_; j++) {
+			if (traced_[j]) {
+				// skipped bins are written out into the record
+				neurons_[j].Trace(nullptr);
+				sent_[j] = bin_;
+			}
+		}
+		writer_->Commit(bin_ - written_);
+		tracing_ = false;
+	}
+	
+	for (int j = begin_; j < end_; j++) {
+		history_t& history = neurons_[j].GetHistory();
+		
+		if (history.size() > staged_[j]) {
+			const size_t count = history.size() - staged_[j];
+			writer_->Write(neurons_[j].GetNeuronId(), sent_[j], history.data() + staged_[j], count);
+			sent_[j] += count;
+			staged_[j] = history.size();
+		}
+		
+		if (!archive_) {
+			history.clear();
+			staged_[j] = 0;
+		}
+	}
+	
+	written_ = bin_;
+}
+
+const void NeuronalNetwork::Trace() noexcept
+{
+	/*
+		opens one writer record of the next s_write_interval_ bins for every owned recording neuron,
+		the neurons store their samples in place, Stage closes the records with the bins integrated
+		the samples so far are handed off first, the neurons without room keep recording into their histories
+	*/
+	for (int j = begin_; j < end_; j++) {
+		// skipped bins are written out into the history
+		neurons_[j].Trace(nullptr);
+	}
+	
+	Stage();
+	
+	traced_.assign(neurons_.size(), 0);
+	
+	for (int j = begin_; j < end_; j++) {
+		if (!neurons_[j].IsRecording()) {
+			continue;
+		}
+		
+		char* samples = writer_->Reserve(neurons_[j].GetNeuronId(), bin_, s_write_interval_);
+		
+		if (samples) {
+			neurons_[j].Trace(samples);
+			traced_[j] = 1;
+		}
+	}
+	
+	tracing_ = true;
+}
+
+const void NeuronalNetwork::Drive(const int bins) noexcept
+{
+	/*
+		bins = window length
+		compiles the stimulus currents of the owned neurons for bins starting at the current bin
+	*/
+	drive_.assign((size_t)(end_ - begin_) * bins, 0);
+	
+	if (stimuli_.empty()) {
+		// voltage clamp neurons in first layer
+		const int last = std::min(end_, layers_sizes_.empty() ? 0 : Locate(layers_sizes_[0]));
+		for (int j = begin_; j < last; j++) {
+			std::fill_n(&drive_[(size_t)(j - begin_) * bins], bins, Iclamp_);
+		}
+		return;
+	}
+	
+	if (positions_.empty()) {
+		for (int i = 0; i < stimuli_.size(); i++) {
+			const int first = std::max(begin_, Locate(stimuli_[i].GetFirst()));
+			const int last = std::min(end_, Locate(stimuli_[i].GetLast()));
+			for (int j = first; j < last; j++) {
+				stimuli_[i].Compile(neurons_[j].GetNeuronId(), bin_, bins, &drive_[(size_t)(j - begin_) * bins]);
+			}
+		}
+		return;
+	}
+	
+	for (int j = begin_; j < end_; j++) {
+		// protocols target neuron ids, renumbered neurons are looked up by position
+		const int id = neurons_[j].GetNeuronId();
+		for (int i = 0; i < stimuli_.size(); i++) {
+			stimuli_[i].Compile(id, bin_, bins, &drive_[(size_t)(j - begin_) * bins]);
+		}
+	}
+}
+
+const void NeuronalNetwork::ConfigureDelays() noexcept
+{
+	/*
+		assigns default delays, reserves the delayed input ring buffers
+		the minimum delay of all edges sets the number of bins run between synchronizations
+	*/
+	int min_delay = INT_MAX;
+	int max_delay = 0;
+	
+	for (int i = 0; i < neurons_.size(); i++) {
+		if (neurons_[i].GetPostsynapticDelay() < 0) {
+			neurons_[i].SetPostsynapticDelay(s_synaptic_delay_);
+		}
+		if (neurons_[i].GetNeighborDelay() < 0) {
+			neurons_[i].SetNeighborDelay(s_neighbor_delay_);
+		}
+		
+		if (neurons_[i].HasPostsynapticNeuron()) {
+			min_delay = std::min(min_delay, neurons_[i].GetPostsynapticDelay());
+			max_delay = std::max(max_delay, neurons_[i].GetPostsynapticDelay());
+		}
+		if (neurons_[i].HasNeighbors()) {
+			min_delay = std::min(min_delay, neurons_[i].GetNeighborDelay());
+			max_delay = std::max(max_delay, neurons_[i].GetNeighborDelay());
+		}
+	}
+	
+	for (int k = 0; k < projections_.size(); k++) {
+		min_delay = std::min(min_delay, projections_[k].GetDelay());
+		max_delay = std::max(max_delay, projections_[k].GetDelay());
+	}
+	
+	if (communicator_) {
+		// every process runs the same window, the edges kept by the others count as well
+		std::vector<char> recv;
+		std::vector<size_t> counts;
+		
+		communicator_->Allgather(&min_delay, sizeof(int), recv, counts);
+		
+		for (size_t k = 0; k + sizeof(int) <= recv.size(); k += sizeof(int)) {
+			int delay = 0;
+			memcpy(&delay, &recv[k], sizeof(int));
+			min_delay = std::min(min_delay, delay);
+		}
+	}
+	
+	window_ = (min_delay == INT_MAX) ? 0 : min_delay;
+	
+	if (max_delay == 0) {
+		return;
+	}
+	
+	for (int i = 0; i < neurons_.size(); i++) {
+		// slots read within a window and written up to max_delay bins ahead
+		neurons_[i].ReserveDelays(max_delay + std::max(window_, 1));
+	}
+}
+
+const void NeuronalNetwork::ConfigureCoupling() noexcept
+{
+	/*
+		finds the layers whose neighbor currents are solved with their membrane update
+		a layer qualifies if each of its neurons sends to all the other neurons of the layer, or each to all
+		the neurons after it or to none, as InitializeNetwork connects them, without delays and gains
+		the other layers send their neighbor currents to the next bin
+	*/
+	coupling_.assign(layers_sizes_.size(), Coupling::none);
+	
+	if (!implicit_) {
+		return;
+	}
+	
+	if (communicator_ || plastic_ || tolerance_ > 0 || slow_interval_ > 1) {
+		printf("implicit coupling error: %s, the neighbor currents are sent to the next bin\n", communicator_ ? "the layers are partitioned" : plastic_ ? "the neighbor edges are plastic" : "the neurons are integrated adaptively or at multiple rates");
+		return;
+	}
+	
+	// initial index of each layer in the array of total neurons in the system
+	int offset = 0;
+	for (int i = 0; i < layers_sizes_.size(); offset += layers_sizes_[i], i++) {
+		const int first = Locate(offset);
+		const int last = Locate(offset + layers_sizes_[i]);
+		const Neuron* layer = neurons_.data();
+		
+		bool forward = true;
+		bool all = true;
+		bool edges = false;
+		
+		for (int j = first; j < last && (forward || all); j++) {
+			const size_t count = neurons_[j].GetNeighborCount();
+			
+			edges |= count > 0;
+			forward = forward && (count == 0 || count == last - j - 1);
+			all = all && count == last - first - 1;
+			
+			if (count > 0 && neurons_[j].GetNeighborDelay() > 0) {
+				forward = all = false;
+			}
+			
+			for (size_t k = 0; k < count && (forward || all); k++) {
+				const Neuron* neighbor = neurons_[j].GetNeighbor((int)k);
+				// neurons after j in order, or all others in order
+				forward = forward && neighbor == layer + j + 1 + k;
+				all = all && neighbor == layer + first + k + (first + k >= j);
+			}
+		}
+		
+		if (!edges) {
+			// nothing to solve
+			continue;
+		}
+		
+		if (!forward && !all) {
+			printf("implicit coupling error: the neighbor edges of layer %d are not all-to-all or forward without delay, they are sent to the next bin\n", i);
+			continue;
+		}
+		
+		coupling_[i] = all ? Coupling::all : Coupling::forward;
+	}
+}
+
+const void NeuronalNetwork::Exchange(const int begin, const int end, const bool neighbors) noexcept
+{
+	/*
+		begin, end = positions of the neurons integrated since the last exchange
+		neighbors = false if the neighbors of the neurons received their currents within the bin
+		gathers their spikes from every process and delivers all of them in (bin, id) order,
+		to the local targets of the spiking neurons and through the projections
+		every neuron then sums its input in the same order, whatever thread or process
+		integrated its sources and whatever their positions
+	*/
+	std::vector<SpikeMessage> spikes;
+	
+	for (int j = begin; j < end; j++) {
+		std::vector<std::pair<size_t, double>>& log = neurons_[j].GetSpikes();
+		for (int k = 0; k < log.size(); k++) {
+			spikes.push_back({neurons_[j].GetNeuronId(), (unsigned int)log[k].first, log[k].second});
+		}
+		log.clear();
+	}
+	
+	if (communicator_) {
+		std::vector<char> recv;
+		std::vector<size_t> counts;
+		
+		communicator_->Allgather(spikes.data(), spikes.size() * sizeof(SpikeMessage), recv, counts);
+		
+		// spikes of every process, the local ones included
+		spikes.resize(recv.size() / sizeof(SpikeMessage));
+		memcpy(spikes.data(), recv.data(), recv.size());
+	}
+	
+	std::sort(spikes.begin(), spikes.end(), [](const SpikeMessage& a, const SpikeMessage& b) {
+		return (a.bin_ != b.bin_) ? a.bin_ < b.bin_ : a.index_ < b.index_;
+	});
+	
+	for (int k = 0; k < spikes.size(); k++) {
+		const int j = GetPosition(spikes[k].index_);
+		// neurons of other processes without edges into the owned neurons are not stored
+		if (j >= 0) {
+			neurons_[j].Transmit(spikes[k].bin_, spikes[k].Vm_, neighbors);
+		}
+		if (!projections_.empty()) {
+			fired_.emplace_back(spikes[k].bin_, spikes[k].index_);
+		}
+	}
+	
+	Project();
+}
+
+const void NeuronalNetwork::Project() noexcept
+{
+	/*
+		delivers the collected spikes through the projections
+		the spikes of one bin form a sparse vector or a bitset multiplied with every weight matrix,
+		the currents are added to the owned postsynaptic neurons once per matrix instead of once per edge
+		rows and columns are neuron ids, they are looked up by position once renumbered
+	*/
+	if (fired_.empty()) {
+		return;
+	}
+	
+	std::sort(fired_.begin(), fired_.end());
+	
+	for (size_t first = 0, last = 0; first < fired_.size(); first = last) {
+		const size_t bin = fired_[first].first;
+		
+		// spikes of the same bin
+		while (last < fired_.size() && fired_[last].first == bin) {
+			last++;
+		}
+		
+		for (int p = 0; p < projections_.size(); p++) {
+			const Projection& projection = projections_[p];
+			
+			spiking_.Reset(projection.GetSources());
+			for (size_t k = first; k < last; k++) {
+				const int row = fired_[k].second - projection.GetSource();
+				if (row >= 0 && row < projection.GetSources()) {
+					spiking_.Add(row);
+				}
+			}
+			
+			if (spiking_.Empty()) {
+				continue;
+			}
+			
+			// list or bitset by the firing density of the bin
+			spiking_.Pack();
+			rows_.resize(projection.GetSources());
+			
+			// the input stays zero between deliveries, only the reached columns are visited and cleared
+			if (input_.size() < projection.GetColumns()) {
+				input_.resize(projection.GetColumns(), 0);
+			}
+			columns_.clear();
+			projection.Deliver(spiking_, rows_.data(), input_.data(), &columns_);
+			
+			// owned ids among the targets
+			const int target = projection.GetTarget();
+			const int begin = std::max(first_, target);
+			const int end = std::min(first_ + end_ - begin_, target + projection.GetTargets());
+			
+			for (const int c : columns_) {
+				const int j = target + c;
+				if (input_[c] == 0) {
+					continue;
+				}
+				if (j >= begin && j < end) {
+					const int k = GetPosition(j);
+					if (projection.GetDelay() > 0) {
+						neurons_[k].InjectCurrent(input_[c], bin + projection.GetDelay());
+					} else {
+						neurons_[k].InjectCurrent(input_[c]);
+					}
+				}
+				input_[c] = 0;
+			}
+		}
+	}
+	
+	fired_.clear();
+}
+
+const void NeuronalNetwork::Mark(const Phase phase) noexcept
+{
+	/*
+		phase = phase that ended
+		attributes the counts since the last mark to the phase
+	*/
+	if (!counters_) {
+		return;
+	}
+	
+	const PerfCounters::Counts counts = counters_->Read();
+	phases_[(size_t)phase] += counts - marked_;
+	marked_ = counts;
+}
+
+const void NeuronalNetwork::ProfileWorkers() noexcept
+{
+	/*
+		gives every worker thread of the threadpool its counters if this network is profiled, removes them otherwise
+	*/
+	if (!threadpool_) {
+		return;
+	}
+	
+	std::vector<NeuronThread>* threads = threadpool_->threads();
+	
+	for (int i = 0; i < threads->size(); i++) {
+		(*threads)[i].Profile(counters_ != nullptr);
+	}
+}
+
+const void NeuronalNetwork::Integrate(const NeuronArg& arg) noexcept
+{
+	/*
+		arg = neuron, time step, tolerance, slow interval, bins and stimulus currents of one task
+		integrates the bins of the task, in a pool thread or in the calling thread
+	*/
+	if (arg.neuron_ && arg.tolerance_ > 0) {
+		// sub-steps may span the bins of the task with the same input
+		arg.neuron_->ProcessAdaptive(arg.dt_, arg.tolerance_, arg.bins_, arg.drive_);
+		return;
+	}
+	
+	for (int i = 0; arg.neuron_ && i < arg.bins_; i++) {
+		if (arg.drive_ && arg.drive_[i] != 0) {
+			// stimulate neuron
+			arg.neuron_->InjectCurrent(arg.drive_[i]);
+		}
+		// skip neuron resting at a fixed point without input
+		if (arg.neuron_->Dormant()) {
+			arg.neuron_->Idle(arg.dt_);
+			continue;
+		}
+		// update membrane potential
+		arg.neuron_->Process(arg.dt_, arg.slow_interval_);
+	}
+}
+
+const void NeuronalNetwork::Plasticity(const NeuronArg& arg) noexcept
+{
+	/*
+		arg = neuron, first stored neuron and spiked bitmap of one task
+		updates the gains of the outgoing edges of the neuron, in a pool thread or in the calling thread
+	*/
+	if (arg.neuron_) {
+		arg.neuron_->Learn(arg.first_, arg.spiked_);
+	}
+}
+
+pthread_mutex_t* NeuronalNetwork::ResultMutex() noexcept
+{
+	/*
+		returns result mutex
+	*/
+	return &s_result_m_;
+}
+
+pthread_mutex_t* NeuronalNetwork::QueueMutex() noexcept
+{
+	/*
+		returns queue mutex
+	*/
+	return &s_queue_m_;
+}
+
+void NeuronalNetwork::RegisterFork() noexcept
+{
+	/*
+		installs the fork handlers once, every later fork of the process runs them
+	*/
+	pthread_atfork(&NeuronalNetwork::LockMutexes, &NeuronalNetwork::UnlockMutexes, &NeuronalNetwork::UnlockMutexes);
+}
+
+void NeuronalNetwork::LockMutexes() noexcept
+{
+	/*
+		before fork, waits until no worker thread of any network holds the static mutexes
+	*/
+	pthread_mutex_lock(&s_queue_m_);
+	pthread_mutex_lock(&s_result_m_);
+}
+
+void NeuronalNetwork::UnlockMutexes() noexcept
+{
+	/*
+		after fork, in the forking process and in the child, whose only thread is the one that locked them
+	*/
+	pthread_mutex_unlock(&s_result_m_);
+	pthread_mutex_unlock(&s_queue_m_);
+}
+
+NeuronalNetwork::NeuronArg::NeuronArg() {}
+
+NeuronalNetwork::NeuronArg::NeuronArg(Neuron* neuron, double dt, double tolerance, int slow_interval, int bins, const double* drive)
+{
+	neuron_ = neuron;
+	dt_ = dt;
+	tolerance_ = tolerance;
+	slow_interval_ = slow_interval;
+	bins_ = bins;
+	drive_ = drive;
+}
+
+NeuronalNetwork::NeuronArg::NeuronArg(Neuron* neuron, const Neuron* first, const uint64_t* spiked)
+{
+	neuron_ = neuron;
+	first_ = first;
+	spiked_ = spiked;
+}
+
+// move constructor
+NeuronalNetwork::NeuronArg::NeuronArg(NeuronArg&& other): neuron_(std::move(other.neuron_)), dt_(std::move(other.dt_)), tolerance_(std::move(other.tolerance_)), slow_interval_(std::move(other.slow_interval_)), bins_(std::move(other.bins_)), drive_(std::move(other.drive_)), first_(std::move(other.first_)), spiked_(std::move(other.spiked_)) {}
+
+NeuronalNetwork::NeuronArg::~NeuronArg() {}
+
+NeuronalNetwork::NeuronThread::NeuronThread(std::vector<NeuronArg>* queue, void* results, std::atomic<int>* count)
+{
+	queue_ = queue;
+	results_ = results;
+	a_count_ = count;
+}
+
+// move construtor
+NeuronalNetwork::NeuronThread::NeuronThread(NeuronThread&& other): queue_(std::move(other.queue_)), results_(std::move(other.results_)), a_count_(std::move(other.a_count_)), counts_(std::move(other.counts_)), counters_(std::move(other.counters_))
+{
+	other.counters_ = nullptr;
+}
+
+NeuronalNetwork::NeuronThread::~NeuronThread()
+{
+	if (counters_) {
+		delete counters_;
+	}
+}
+
+void* NeuronalNetwork::NeuronThread::run() noexcept 
+{
+	/*
+		overwritten virtual run function
+		pulls neuron argument ( neuron pointer and delta t) from queue
+		performs calculation of membrane potential
+	*/
+	NeuronArg arg;
+	
+	// the pool starts a new thread every run, the counters of the worker are reopened for it
+	if (counters_) {
+		counters_->Open();
+	}
+	const PerfCounters::Counts start = counters_ ? counters_->Read() : PerfCounters::Counts();
+
+	while (true) {
+		// lock queue mutex
+		pthread_mutex_lock(&s_queue_m_);
+		// breaks while loop if queue is empty or stopped flag is triggered
+		if (queue_->empty() || stopped()) {
+			// unlock queue mutex
+			pthread_mutex_unlock(&s_queue_m_);
+			break;
+		}
+		// moves neuron argument from back of queue to local variable
+		arg = std::move(queue_->back());
+		// pop last element in the queue
+		queue_->pop_back();
+		// unlock queue mutex
+		pthread_mutex_unlock(&s_queue_m_);
+		
+		if (arg.spiked_) {
+			Plasticity(arg);
+		} else {
+			Integrate(arg);
+		}
+		// increments count
+		(*a_count_)++;
+	}
+	
+	if (counters_) {
+		counts_ += counters_->Read() - start;
+		counters_->Close();
 	}
 	
 	return NULL;
 }
 
+const void NeuronalNetwork::NeuronThread::Profile(const bool profiled) noexcept
+{
+	/*
+		profiled = the worker counts its runs, its counters are allocated once and kept until unprofiled
+	*/
+	if (profiled && !counters_) {
+		counters_ = new PerfCounters();
+		// opened by every run in its own thread
+		counters_->Close();
+	} else if (!profiled && counters_) {
+		delete counters_;
+		counters_ = nullptr;
+	}
+}
+
+const PerfCounters::Counts& NeuronalNetwork::NeuronThread::GetCounts() const noexcept
+{
+	/*
+		Getter counts_
+	*/
+	return counts_;
+}
+
 
 
 
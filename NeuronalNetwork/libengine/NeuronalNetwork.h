@@ -9,72 +9,337 @@
 #ifndef NeuronalNetwork_
 #define NeuronalNetwork_
 
-#pragma GCC visibility push(hidden)
-
+#include "Communicator.h"
 #include "Neuron.h"
+#include "PerfCounters.h"
+#include "Projection.h"
+#include "Statistics.h"
+#include "Stimulus.h"
+#include "Telemetry.h"
 #include "ThreadPool.hpp"
+#include "TraceArchive.h"
+#include "TraceWriter.h"
 
 #include <pthread.h>
+#include <sys/types.h>
 
+#include <atomic>
 #include <vector>
 
+#pragma GCC visibility push(hidden)
+
+typedef std::vector<Neuron, ArenaAllocator<Neuron>> neurons_t;
+
 class NeuronalNetwork
 {
+public:
+	// phases of a bin or a window, profiled separately
+	enum class Phase
+	{
+		drive,
+		integrate,
+		exchange,
+		learn,
+		publish,
+		reduce,
+		archive,
+		count
+	};
+
+private:
 	// forward declaration of argument class
 	class NeuronArg;
 	// forward delcaration of thread class
 	class NeuronThread;
 	
+	// neighbor edges of a layer solved with its membrane update, none sends them to the next bin
+	enum class Coupling
+	{
+		none,
+		forward,
+		all
+	};
+	
 	// size of layers
 	std::vector<int> layers_sizes_;
 	
+	// memory of the neurons, their connectivity and recording buffers
+	Arena arena_;
+	
 	// array of neurons in entire system
-	std::vector<Neuron> neurons_;
+	neurons_t neurons_;
+	// position in neurons_ of every neuron id, empty while ids and positions coincide
+	std::vector<int> positions_;
+	// ids of the stored neurons in position order, empty unless partitioned
+	std::vector<int> locals_;
+	
+	// number of bins run between synchronizations, 0 processes the layers sequentially every bin
+	int window_ = 0;
+	
+	// process group sharing the network, nullptr if the network runs in a single process
+	Communicator* communicator_ = nullptr;
+	// range of positions integrated by this process
+	int begin_ = 0;
+	int end_ = 0;
+	// id of the first neuron integrated by this process, the owned ids are [first_, first_ + end_ - begin_)
+	int first_ = 0;
+	// (source, target) ids of the edges into the owned neurons, declared before a partition is allocated
+	std::vector<std::pair<int, int>> neighbor_edges_;
+	std::vector<std::pair<int, int>> postsynaptic_edges_;
+	
+	// stimulus protocols, the current clamp of the first layer applies without any
+	std::vector<Stimulus> stimuli_;
+	// stimulus currents of the owned neurons compiled for the current window, neuron major
+	std::vector<double> drive_;
+	
+	// weight matrices between ranges of neurons, delivered after every layer or window
+	std::vector<Projection> projections_;
+	// (bin, neuron) spikes of the last layer or window not yet delivered through the projections
+	std::vector<std::pair<size_t, int>> fired_;
+	// one bit per position of the neurons that spiked since the last plasticity pass
+	std::vector<uint64_t> spiked_;
+	// spikes of one bin over the presynaptic range, rows of one delivery, postsynaptic currents
+	// kept zero between deliveries and the columns a delivery reached
+	SpikeVector spiking_;
+	std::vector<int> rows_;
+	std::vector<double> input_;
+	std::vector<int> columns_;
+	
+	// coupling of every layer and scratch of the implicitly coupled layers
+	std::vector<Coupling> coupling_;
+	std::vector<double> coupled_;
+	
+	// accumulators of every layer
+	std::vector<PopulationStatistics> populations_;
+	// bin of the last reduction of the neuron accumulators
+	int reduced_ = 0;
+	
+	// live telemetry of the monitored neurons, nullptr if not published
+	Telemetry* telemetry_ = nullptr;
+	// indices of the monitored neurons
+	std::vector<int> monitored_;
+	// bins between membrane potential samples
+	int decimation_ = 1;
+	// bin of the last membrane potential samples
+	int sampled_ = -1;
 	
-	// static threadpool pointer
-	inline static ThreadPool<NeuronThread, NeuronArg, void*>* sp_threadpool_ = nullptr;
+	// compressed store the recorded membrane potentials are moved to, nullptr keeps them in the histories
+	TraceArchive* archive_ = nullptr;
+	// bin of the last move into the archive
+	int archived_ = 0;
+	
+	// file the recorded membrane potentials are streamed to from its own thread, nullptr keeps them in memory only
+	TraceWriter* writer_ = nullptr;
+	// samples of every owned neuron's history already handed to the writer
+	std::vector<size_t> staged_;
+	// bin of every owned neuron's next sample handed to the writer
+	std::vector<int> sent_;
+	// bin of the last hand-off to the writer
+	int written_ = 0;
+	// owned neurons storing their samples in place into the writer's records until the next hand-off
+	std::vector<char> traced_;
+	bool tracing_ = false;
+	
+	// membrane potentials of every forked branch, mapped shared with the children, nullptr unless forked
+	double* branches_ = nullptr;
+	// number of branches, bins recorded per branch and bin of the fork
+	int branch_count_ = 0;
+	int branch_bins_ = 0;
+	int forked_ = 0;
+	// branch integrated by this process, -1 in the forking process
+	int branch_ = -1;
+	// process ids of the branches not yet waited for, empty in the branches
+	std::vector<pid_t> children_;
+	
+	// hardware counters of the stepping thread and its worker threads, nullptr unless profiled
+	PerfCounters* counters_ = nullptr;
+	// counts of every phase
+	std::vector<PerfCounters::Counts> phases_;
+	// counts at the end of the last phase
+	PerfCounters::Counts marked_;
+	
+	// current clamp [µA] of the first layer, time step [ms], adaptive tolerance [mV], number of bins,
+	// bins between updates of the slow gates and implicit coupling, taken from the defaults when the network is built
+	double Iclamp_ = s_Iclamp_;
+	double dt_ = s_dt_;
+	double tolerance_ = s_tolerance_;
+	int num_bins_ = s_num_bins_;
+	int slow_interval_ = s_slow_interval_;
+	bool implicit_ = s_implicit_;
+	
+	// next bin to integrate
+	int bin_ = 0;
+	// connectivity and delays are established
+	bool prepared_ = false;
+	// outgoing edges of the neurons are plastic
+	bool plastic_ = false;
+	// neurons are integrated in the calling thread, without threadpool
+	bool serial_ = false;
+	// cooperative cancellation, checked at every bin boundary
+	std::atomic<bool> a_cancelled_{false};
+	
+	// threadpool pointer, created by Prepare and kept alive between steps, nullptr if serial
+	ThreadPool<NeuronThread, NeuronArg, void*>* threadpool_ = nullptr;
 	
 	// static mutexes
 	inline static pthread_mutex_t s_queue_m_ = PTHREAD_MUTEX_INITIALIZER;
 	inline static pthread_mutex_t s_result_m_ = PTHREAD_MUTEX_INITIALIZER;
+	// fork handlers holding the static mutexes across fork, registered by the first Fork
+	inline static pthread_once_t s_atfork_ = PTHREAD_ONCE_INIT;
 	
-	// mV
+	// default current clamp [µA] of networks built afterwards
 	inline static double s_Iclamp_ = 0.451;
-	// µs time step;
+	// default time step [ms] of networks built afterwards
 	inline static double s_dt_ = 0.01;
-	// number of bins, num_bins * dt = µs
+	// default adaptive integration tolerance [mV] of networks built afterwards, 0 integrates with the fixed time step
+	inline static double s_tolerance_ = 0;
+	// default bins between updates of the slow gates h and n of networks built afterwards, 1 updates every gate every bin
+	inline static int s_slow_interval_ = 1;
+	// default implicit coupling of the neighbor currents of networks built afterwards
+	inline static bool s_implicit_ = false;
+	// default number of bins of networks built afterwards, num_bins * dt = ms
 	inline static int s_num_bins_ = 10000;
 	// number of neighboring neurons
 	inline static int s_max_neighbors_ = 10000;
+	// back the arena with huge pages
+	inline static bool s_huge_pages_ = false;
+	// log the membrane potential of every bin, otherwise only the accumulators are kept
+	inline static bool s_recording_ = true;
+	// number of bins between reductions of the neuron accumulators into the layers
+	inline static int s_reduce_interval_ = 100;
+	// spike timing dependent plasticity of networks prepared afterwards
+	inline static bool s_plasticity_ = false;
+	// transmission delay [bins] between layers
+	inline static int s_synaptic_delay_ = 0;
+	// transmission delay [bins] between neighboring neurons
+	inline static int s_neighbor_delay_ = 0;
+	// renumber the neurons of networks prepared afterwards along their edges
+	inline static bool s_reordering_ = false;
+	// hardware counters per phase and per worker thread of networks prepared afterwards
+	inline static bool s_profiling_ = false;
+	// bins between hand-offs of the recorded membrane potentials to the writer
+	inline constexpr static const int s_write_interval_ = 64;
 
 public:
 	NeuronalNetwork();
 	NeuronalNetwork(std::vector<int> layers);
 	NeuronalNetwork(std::initializer_list<int> layers);
+	NeuronalNetwork(std::vector<int> layers, Communicator* communicator);
 	template <typename... Args>
 	NeuronalNetwork(Args... args);
 	virtual ~NeuronalNetwork();
 	
 	virtual void InitializeNetwork();
+	
+	const void AddNeighbor(const int source, const int target) noexcept;
+	const void AddNeighbors(const int source, const int first, const int last) noexcept;
+	const void AddPostsynapticNeuron(const int source, const int target) noexcept;
 
+	const void Prepare() noexcept;
 	const void Start() noexcept;
+	const int Step(const int bins = 1) noexcept;
+	const int RunUntil(const int bin) noexcept;
 	const void Stop() noexcept;
 	const void Cancel() noexcept;
+	const bool Cancelled() const noexcept;
+	
+	__attribute__((visibility("default"))) const int GetBin() const noexcept;
+	const void Configure(const double clamp, const double dt, const int bins) noexcept;
+	__attribute__((visibility("default"))) const double GetTimeStep() const noexcept;
+	__attribute__((visibility("default"))) const double GetCurrentClamp() const noexcept;
+	__attribute__((visibility("default"))) const int GetSlowInterval() const noexcept;
+	
+	const int Fork(const int branches, const int bins) noexcept;
+	const void Join() noexcept;
+	const double* Wait() noexcept;
+	const int GetBranch() const noexcept;
+	const int GetBranchCount() const noexcept;
+	const int GetBranchBins() const noexcept;
+	const void InjectCurrent(const int index, const double current) noexcept;
+	const void AddStimulus(const Stimulus& stimulus) noexcept;
+	const void ClearStimuli() noexcept;
+	const void AddProjection(const Projection& projection) noexcept;
+	const bool HasProjection(const int layer) const noexcept;
+	const double GetMembranePotential(const int index) const noexcept;
+	
+	const void Reduce() noexcept;
+	Statistics& GetNeuronStatistics(const int index) noexcept;
+	Statistics GetLayerStatistics(const int layer) noexcept;
+	const PopulationStatistics& GetPopulationStatistics(const int layer) const noexcept;
 	
 	const void AllocateNeurons(size_t n) noexcept;
+	const void Reorder() noexcept;
+	__attribute__((visibility("default"))) const int GetPosition(const int id) const noexcept;
 	
-	std::vector<Neuron>& GetNeurons() noexcept;
+	__attribute__((visibility("default"))) neurons_t& GetNeurons() noexcept;
+	const std::vector<int>& GetLayers() const noexcept;
+	
+	const void SetTelemetry(Telemetry* telemetry, const std::vector<int>& neurons, const int decimation = 1) noexcept;
+	const void SetArchive(TraceArchive* archive) noexcept;
+	const void Archive() noexcept;
+	const void SetWriter(TraceWriter* writer) noexcept;
+	const void Persist() noexcept;
+	const bool Owns(const int index) const noexcept;
+	const void SetSerial(const bool serial) noexcept;
+	
+	const PerfCounters::Counts GetPhaseCounts(const Phase phase) const noexcept;
+	const std::vector<PerfCounters::Counts> GetWorkerCounts() noexcept;
+	const void PrintProfile() noexcept;
 
-	static const bool Stopped() noexcept;
+	const bool Stopped() noexcept;
 
 	static const void SetCurrentClamp(const double cc) noexcept;
 	static const void SetTimeStep(const double dt) noexcept;
+	static const bool SetTolerance(const double tol) noexcept;
+	static const bool SetSlowInterval(const int bins) noexcept;
+	static const bool SetImplicitCoupling(const bool implicit) noexcept;
 	static const void SetNumBins(const int nb) noexcept;
 	static const void SetMaxNeighbors(const int mn) noexcept;
+	static const void SetHugePages(const bool huge_pages) noexcept;
+	static const void SetRecording(const bool recording) noexcept;
+	static const void SetReduceInterval(const int bins) noexcept;
+	static const void SetPlasticity(const bool plasticity) noexcept;
+	static const void SetSynapticDelay(const int delay) noexcept;
+	static const void SetNeighborDelay(const int delay) noexcept;
+	static const void SetReordering(const bool reordering) noexcept;
+	static const void SetProfiling(const bool profiling) noexcept;
 
 private:
+	const int Advance(const int bins) noexcept;
+	const void Drive(const int bins) noexcept;
+	const void Learn() noexcept;
+	const void Publish() noexcept;
+	const void Move() noexcept;
+	const void Stage() noexcept;
+	const void Trace() noexcept;
+	const int GetLayerOffset(const int layer) const noexcept;
+	const int Locate(const int id) const noexcept;
+	const void AllocatePartition() noexcept;
+	const void ConfigureDelays() noexcept;
+	const void ConfigureCoupling() noexcept;
+	const void Exchange(const int begin, const int end, const bool neighbors = true) noexcept;
+	const void Project() noexcept;
+	const void Mark(const Phase phase) noexcept;
+	
+	struct SpikeMessage
+	{
+		// id of the spiking neuron
+		neuron_t index_;
+		// bin of the spike
+		unsigned int bin_;
+		// membrane potential of the spike
+		double Vm_;
+	};
+	
+	const void ProfileWorkers() noexcept;
+	static const void Integrate(const NeuronArg& arg) noexcept;
+	static const void Plasticity(const NeuronArg& arg) noexcept;
+	
 	static pthread_mutex_t* ResultMutex() noexcept;
 	static pthread_mutex_t* QueueMutex() noexcept;
+	static void RegisterFork() noexcept;
+	static void LockMutexes() noexcept;
+	static void UnlockMutexes() noexcept;
 	
 	struct NeuronArg
 	{
@@ -83,9 +348,21 @@ private:
 		Neuron* neuron_ = nullptr;
 		// delta time
 		double dt_ = 0;
+		// adaptive integration tolerance
+		double tolerance_ = 0;
+		// bins between updates of the slow gates
+		int slow_interval_ = 1;
+		// number of consecutive bins to process
+		int bins_ = 1;
+		// stimulus current of every bin, nullptr without stimulus
+		const double* drive_ = nullptr;
+		// first stored neuron and spiked bitmap of a plasticity task, nullptr for an integration task
+		const Neuron* first_ = nullptr;
+		const uint64_t* spiked_ = nullptr;
 
 		NeuronArg();
-		NeuronArg(Neuron* neuron, const double dt);
+		NeuronArg(Neuron* neuron, const double dt, const double tolerance = 0, const int slow_interval = 1, const int bins = 1, const double* drive = nullptr);
+		NeuronArg(Neuron* neuron, const Neuron* first, const uint64_t* spiked);
 		NeuronArg(NeuronArg&& other);
 		~NeuronArg();
 
@@ -101,6 +378,10 @@ private:
 		void* results_ = nullptr;
 		// atomic count pointer
 		std::atomic<int>* a_count_ = nullptr;
+		// hardware counts of all runs of this worker, profiled networks only
+		PerfCounters::Counts counts_;
+		// hardware counters of this worker, nullptr unless the network is profiled
+		PerfCounters* counters_ = nullptr;
 
 	public:
 		explicit NeuronThread(std::vector<NeuronArg>* queue, void* results, std::atomic<int>* count);
@@ -108,8 +389,20 @@ private:
 		~NeuronThread();
 
 		void* run() noexcept;
+		const void Profile(const bool profiled) noexcept;
+		const PerfCounters::Counts& GetCounts() const noexcept;
 	};
 };
 
 #pragma GCC visibility pop
+
+template <typename... Args>
+NeuronalNetwork::NeuronalNetwork(Args... args): NeuronalNetwork(std::vector<int>{static_cast<int>(args)...})
+{
+	/*
+		Constructor from a pack of layer sizes, e.g. NeuronalNetwork(16, 4, 1)
+		the same pack parameterizes StaticNetwork<16, 4, 1>
+	*/
+}
+
 #endif /* NeuronalNetwork_ */
@@ -0,0 +1,156 @@
+//
+//  PerfCounters.cpp
+//  NeuronalNetwork
+//
+//  Created by Nicolas Fricker on 04/10/20.
+//  Copyright © 2020 Nicolas Fricker. All rights reserved.
+//
+
+#include "PerfCounters.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <cstring>
+
+__attribute__((visibility("default"))) PerfCounters::PerfCounters(const bool inherit)
+{
+	/*
+		inherit = true also counts the threads created afterwards by the calling thread,
+		their counts are added once they have exited
+		opens and starts the counters of the calling thread
+	*/
+	Open(inherit);
+}
+
+__attribute__((visibility("default"))) PerfCounters::~PerfCounters()
+{
+	/*
+		Deconstructor
+	*/
+	Close();
+}
+
+const void PerfCounters::Open(const bool inherit) noexcept
+{
+	/*
+		inherit = true also counts the threads created afterwards by the calling thread
+		(re)opens the counters for the calling thread and restarts the wall time,
+		the events only ever count the thread that opened them
+	*/
+	Close();
+	start_ = std::chrono::steady_clock::now();
+
+#ifdef __linux__
+	const uint64_t configs[s_events_] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+
+	for (int i = 0; i < s_events_; i++) {
+		perf_event_attr attribute;
+		memset(&attribute, 0, sizeof(attribute));
+		attribute.size = sizeof(attribute);
+		attribute.type = PERF_TYPE_HARDWARE;
+		attribute.config = configs[i];
+		attribute.exclude_kernel = 1;
+		attribute.exclude_hv = 1;
+		attribute.inherit = inherit ? 1 : 0;
+
+		// calling thread, any cpu, no group
+		fds_[i] = (int)syscall(SYS_perf_event_open, &attribute, 0, -1, -1, 0);
+	}
+#endif
+}
+
+const void PerfCounters::Close() noexcept
+{
+	/*
+		closes the counters, they read 0 until opened again
+	*/
+#ifdef __linux__
+	for (int i = 0; i < s_events_; i++) {
+		if (fds_[i] >= 0) {
+			close(fds_[i]);
+		}
+		fds_[i] = -1;
+	}
+#endif
+}
+
+__attribute__((visibility("default"))) const PerfCounters::Counts PerfCounters::Read() const noexcept
+{
+	/*
+		returns the counts and the wall time since construction, intervals are differences of two reads
+	*/
+	Counts counts;
+	counts.seconds_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+
+	uint64_t values[s_events_] = {0, 0, 0, 0};
+
+#ifdef __linux__
+	for (int i = 0; i < s_events_; i++) {
+		if (fds_[i] >= 0 && read(fds_[i], &values[i], sizeof(uint64_t)) != sizeof(uint64_t)) {
+			values[i] = 0;
+		}
+	}
+#endif
+
+	counts.cycles_ = values[0];
+	counts.instructions_ = values[1];
+	counts.cache_misses_ = values[2];
+	counts.branch_misses_ = values[3];
+
+	return counts;
+}
+
+__attribute__((visibility("default"))) const bool PerfCounters::Available() const noexcept
+{
+	/*
+		returns true if at least one hardware counter could be opened
+	*/
+	for (int i = 0; i < s_events_; i++) {
+		if (fds_[i] >= 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+PerfCounters::Counts& PerfCounters::Counts::operator+=(const Counts& other) noexcept
+{
+	/*
+		accumulates another interval
+	*/
+	seconds_ += other.seconds_;
+	cycles_ += other.cycles_;
+	instructions_ += other.instructions_;
+	cache_misses_ += other.cache_misses_;
+	branch_misses_ += other.branch_misses_;
+	intervals_ += other.intervals_;
+	return *this;
+}
+
+PerfCounters::Counts PerfCounters::Counts::operator-(const Counts& other) const noexcept
+{
+	/*
+		returns the interval between two reads
+	*/
+	Counts counts;
+	counts.seconds_ = seconds_ - other.seconds_;
+	counts.cycles_ = cycles_ - other.cycles_;
+	counts.instructions_ = instructions_ - other.instructions_;
+	counts.cache_misses_ = cache_misses_ - other.cache_misses_;
+	counts.branch_misses_ = branch_misses_ - other.branch_misses_;
+	counts.intervals_ = 1;
+	return counts;
+}
+
+const double PerfCounters::Counts::GetIPC() const noexcept
+{
+	/*
+		returns instructions per cycle, 0 without counters
+	*/
+	return (cycles_ > 0) ? (double)instructions_ / cycles_ : 0;
+}
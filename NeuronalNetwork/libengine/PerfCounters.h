@@ -0,0 +1,66 @@
+//
+//  PerfCounters.h
+//  NeuronalNetwork
+//
+//  Created by Nicolas Fricker on 04/10/20.
+//  Copyright © 2020 Nicolas Fricker. All rights reserved.
+//
+
+#ifndef PerfCounters_
+#define PerfCounters_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#pragma GCC visibility push(hidden)
+
+class PerfCounters
+{
+	/*
+		Hardware performance counters of the calling thread: cycles, instructions,
+		last level cache misses and branch misses, read through perf_event_open on Linux
+		counters that can not be opened (other systems, perf_event_paranoid, containers) read 0,
+		the wall time is always measured
+	*/
+public:
+	struct Counts
+	{
+		// elapsed wall time [s]
+		double seconds_ = 0;
+		uint64_t cycles_ = 0;
+		uint64_t instructions_ = 0;
+		uint64_t cache_misses_ = 0;
+		uint64_t branch_misses_ = 0;
+		// number of measured intervals
+		size_t intervals_ = 0;
+
+		Counts& operator+=(const Counts& other) noexcept;
+		Counts operator-(const Counts& other) const noexcept;
+		const double GetIPC() const noexcept;
+	};
+
+	// number of hardware events
+	inline constexpr static const int s_events_ = 4;
+
+private:
+	// file descriptors of the events, -1 if unavailable
+	int fds_[s_events_] = {-1, -1, -1, -1};
+	// time of construction
+	std::chrono::time_point<std::chrono::steady_clock> start_;
+
+public:
+	PerfCounters(const bool inherit = false);
+	~PerfCounters();
+
+	PerfCounters(const PerfCounters& other) = delete;
+	PerfCounters& operator=(const PerfCounters& other) = delete;
+
+	const void Open(const bool inherit = false) noexcept;
+	const void Close() noexcept;
+	const Counts Read() const noexcept;
+	const bool Available() const noexcept;
+};
+
+#pragma GCC visibility pop
+#endif /* PerfCounters_ */
@@ -0,0 +1,412 @@
+//
+//  Projection.cpp
+//  NeuronalNetwork
+//
+//  Created by Nicolas Fricker on 04/10/20.
+//  Copyright © 2020 Nicolas Fricker. All rights reserved.
+//
+
+#include "Projection.h"
+
+#include <algorithm>
+#include <cmath>
+
+Projection::Projection() {}
+
+__attribute__((visibility("default"))) Projection Projection::Dense(const int source, const int sources, const int target, const int targets, const std::vector<double>& weights, const int delay)
+{
+	/*
+		source, sources = first presynaptic neuron and number of presynaptic neurons
+		target, targets = first postsynaptic neuron and number of postsynaptic neurons
+		weights = row major sources x targets matrix [µA]
+		delay = transmission delay [bins]
+	*/
+	Projection projection;
+	projection.format_ = Format::dense;
+	projection.source_ = source;
+	projection.sources_ = sources;
+	projection.target_ = target;
+	projection.targets_ = targets;
+	projection.delay_ = delay;
+	projection.stride_ = (targets + s_block_cols_ - 1) / s_block_cols_ * s_block_cols_;
+	projection.weights_.assign((size_t)sources * projection.stride_, 0);
+
+	for (int r = 0; r < sources; r++) {
+		for (int c = 0; c < targets && (size_t)r * targets + c < weights.size(); c++) {
+			projection.weights_[(size_t)r * projection.stride_ + c] = weights[(size_t)r * targets + c];
+		}
+	}
+
+	projection.Sum();
+
+	return projection;
+}
+
+__attribute__((visibility("default"))) Projection Projection::Sparse(const int source, const int sources, const int target, const int targets, const std::vector<std::tuple<int, int, double>>& entries, const int delay)
+{
+	/*
+		source, sources = first presynaptic neuron and number of presynaptic neurons
+		target, targets = first postsynaptic neuron and number of postsynaptic neurons
+		entries = (row, column, weight [µA]) of the non-zero weights, duplicates add up
+		delay = transmission delay [bins]
+	*/
+	Projection projection;
+	projection.format_ = Format::sparse;
+	projection.source_ = source;
+	projection.sources_ = sources;
+	projection.target_ = target;
+	projection.targets_ = targets;
+	projection.delay_ = delay;
+	projection.stride_ = (targets + s_block_cols_ - 1) / s_block_cols_ * s_block_cols_;
+
+	const int block_rows = (sources + s_block_rows_ - 1) / s_block_rows_;
+	const int block_size = s_block_rows_ * s_block_cols_;
+
+	// entries ordered by block row, block column
+	std::vector<std::tuple<int, int, double>> sorted;
+	for (int i = 0; i < entries.size(); i++) {
+		const int r = std::get<0>(entries[i]);
+		const int c = std::get<1>(entries[i]);
+		if (r >= 0 && r < sources && c >= 0 && c < targets) {
+			sorted.push_back(entries[i]);
+		}
+	}
+	std::sort(sorted.begin(), sorted.end(), [](const std::tuple<int, int, double>& a, const std::tuple<int, int, double>& b) {
+		const int ra = std::get<0>(a) / s_block_rows_, rb = std::get<0>(b) / s_block_rows_;
+		return (ra != rb) ? ra < rb : std::get<1>(a) / s_block_cols_ < std::get<1>(b) / s_block_cols_;
+	});
+
+	projection.block_rows_.assign(block_rows + 1, 0);
+
+	for (int i = 0; i < sorted.size(); i++) {
+		const int br = std::get<0>(sorted[i]) / s_block_rows_;
+		const int bc = std::get<1>(sorted[i]) / s_block_cols_;
+
+		// opens a new block unless the entry falls into the previous one
+		if (i == 0 || br != std::get<0>(sorted[i - 1]) / s_block_rows_ || bc != std::get<1>(sorted[i - 1]) / s_block_cols_) {
+			projection.block_cols_.push_back(bc);
+			projection.weights_.resize(projection.weights_.size() + block_size, 0);
+			projection.block_rows_[br + 1]++;
+		}
+
+		const size_t block = projection.block_cols_.size() - 1;
+		projection.weights_[block * block_size + (std::get<0>(sorted[i]) % s_block_rows_) * s_block_cols_ + std::get<1>(sorted[i]) % s_block_cols_] += std::get<2>(sorted[i]);
+	}
+
+	// block counts to offsets
+	for (int br = 0; br < block_rows; br++) {
+		projection.block_rows_[br + 1] += projection.block_rows_[br];
+	}
+
+	projection.Sum();
+
+	return projection;
+}
+
+__attribute__((visibility("default"))) Projection Projection::Random(const int source, const int sources, const int target, const int targets, const double density, const double weight, const uint64_t seed, const int delay)
+{
+	/*
+		source, sources = first presynaptic neuron and number of presynaptic neurons
+		target, targets = first postsynaptic neuron and number of postsynaptic neurons
+		density = probability of an edge between a presynaptic and a postsynaptic neuron
+		weight = weight of every edge [µA]
+		seed = random stream of the edges
+		dense storage above a density of 1/4, blocked sparse storage below
+	*/
+	std::vector<std::tuple<int, int, double>> entries;
+
+	for (int r = 0; r < sources; r++) {
+		for (int c = 0; c < targets; c++) {
+			// splitmix64 of the edge
+			uint64_t x = seed + (((uint64_t)r << 32) | (uint32_t)c) * 0x9e3779b97f4a7c15ULL;
+			x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+			x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+			x ^= x >> 31;
+			if ((double)(x >> 11) * (1.0 / 9007199254740992.0) < density) {
+				entries.emplace_back(r, c, weight);
+			}
+		}
+	}
+
+	if (density < 0.25) {
+		return Sparse(source, sources, target, targets, entries, delay);
+	}
+
+	std::vector<double> weights((size_t)sources * targets, 0);
+	for (int i = 0; i < entries.size(); i++) {
+		weights[(size_t)std::get<0>(entries[i]) * targets + std::get<1>(entries[i])] = std::get<2>(entries[i]);
+	}
+
+	return Dense(source, sources, target, targets, weights, delay);
+}
+
+__attribute__((visibility("default"))) Projection Projection::Procedural(const int source, const int sources, const int target, const int targets, const double density, const double weight, const uint64_t seed, const int delay)
+{
+	/*
+		source, sources = first presynaptic neuron and number of presynaptic neurons
+		target, targets = first postsynaptic neuron and number of postsynaptic neurons
+		density = probability of an edge between a presynaptic and a postsynaptic neuron
+		weight = weight of every edge [µA]
+		seed = random stream of the edges, the edges of a presynaptic neuron depend on the seed and its id only
+		delay = transmission delay [bins]
+		no edge is stored, the memory of the projection does not grow with the number of edges
+	*/
+	Projection projection;
+	projection.format_ = Format::procedural;
+	projection.source_ = source;
+	projection.sources_ = sources;
+	projection.target_ = target;
+	projection.targets_ = targets;
+	projection.delay_ = delay;
+	projection.stride_ = (targets + s_block_cols_ - 1) / s_block_cols_ * s_block_cols_;
+	projection.density_ = std::clamp(density, 0.0, 1.0);
+	projection.weight_ = weight;
+	projection.seed_ = seed;
+
+	return projection;
+}
+
+const void Projection::Deliver(const int* rows, const size_t count, double* __restrict input, std::vector<int>* columns) const noexcept
+{
+	/*
+		rows = presynaptic neurons that spiked, relative to the first presynaptic neuron
+		count = number of spikes
+		input = input array of GetColumns() postsynaptic currents, the weights of the spike rows are added to it
+		columns = if given, the columns that received a weight are appended, possibly more than once,
+		the caller visits them instead of all columns
+	*/
+	if (format_ == Format::dense) {
+		DeliverDense(rows, count, input);
+		Touch(columns);
+	} else if (format_ == Format::sparse) {
+		DeliverSparse(rows, count, input, 1, columns);
+	} else {
+		DeliverProcedural(rows, count, input, columns);
+	}
+}
+
+__attribute__((visibility("default"))) const void Projection::Deliver(const SpikeVector& spikes, int* rows, double* __restrict input, std::vector<int>* columns) const noexcept
+{
+	/*
+		spikes = presynaptic neurons that spiked in one bin, relative to the first presynaptic neuron
+		rows = scratch array of GetSources() rows
+		input = input array of GetColumns() postsynaptic currents, the weights of the spike rows are added to it
+		columns = if given, the columns that received a weight are appended, possibly more than once
+		a bitset of more than half of the rows is delivered as the column sums minus the silent rows
+	*/
+	if (!spikes.IsDense()) {
+		Deliver(spikes.GetRows().data(), spikes.GetRows().size(), input, columns);
+		return;
+	}
+
+	if (format_ == Format::procedural || 2 * spikes.GetCount() <= sources_) {
+		Deliver(rows, spikes.Gather(rows, false), input, columns);
+		return;
+	}
+
+	Touch(columns);
+
+	for (int c = 0; c < stride_; c++) {
+		input[c] += sums_[c];
+	}
+
+	const size_t count = spikes.Gather(rows, true);
+
+	if (format_ == Format::dense) {
+		DeliverDense(rows, count, input, -1);
+	} else {
+		DeliverSparse(rows, count, input, -1);
+	}
+}
+
+const void Projection::DeliverDense(const int* rows, const size_t count, double* __restrict input, const double sign) const noexcept
+{
+	/*
+		accumulates the spike rows one column tile at a time, the tile of the input stays in cache
+		sign = -1 subtracts the rows
+	*/
+	const double* weights = weights_.data();
+
+	for (int c0 = 0; c0 < stride_; c0 += s_tile_) {
+		const int width = std::min(s_tile_, stride_ - c0);
+		double* __restrict tile = input + c0;
+
+		for (size_t k = 0; k < count; k++) {
+			const double* __restrict row = weights + (size_t)rows[k] * stride_ + c0;
+			// contiguous rows, vectorized
+			for (int c = 0; c < width; c++) {
+				tile[c] += sign * row[c];
+			}
+		}
+	}
+}
+
+const void Projection::DeliverSparse(const int* rows, const size_t count, double* __restrict input, const double sign, std::vector<int>* columns) const noexcept
+{
+	/*
+		adds the row of every non-zero block of the spike's block row, one block row is s_block_cols_ wide
+		sign = -1 subtracts the rows
+		columns = if given, the columns of every visited block are appended
+	*/
+	const double* weights = weights_.data();
+	const int block_size = s_block_rows_ * s_block_cols_;
+
+	for (size_t k = 0; k < count; k++) {
+		const int br = rows[k] / s_block_rows_;
+		const int offset = (rows[k] % s_block_rows_) * s_block_cols_;
+
+		for (int b = block_rows_[br]; b < block_rows_[br + 1]; b++) {
+			const double* __restrict row = weights + (size_t)b * block_size + offset;
+			double* __restrict tile = input + block_cols_[b] * s_block_cols_;
+			// fixed width, unrolled and vectorized
+			for (int c = 0; c < s_block_cols_; c++) {
+				tile[c] += sign * row[c];
+			}
+
+			if (columns != nullptr) {
+				for (int c = 0; c < s_block_cols_; c++) {
+					columns->push_back(block_cols_[b] * s_block_cols_ + c);
+				}
+			}
+		}
+	}
+}
+
+const void Projection::DeliverProcedural(const int* rows, const size_t count, double* __restrict input, std::vector<int>* columns) const noexcept
+{
+	/*
+		regenerates the edges of every spike row from the hash of the seed and the presynaptic id
+		the gaps between the columns of a row are geometric, the cost is the number of edges of the row
+		columns = if given, the column of every edge is appended
+	*/
+	if (density_ <= 0) {
+		return;
+	}
+
+	// scale of the geometric gaps, 0 connects every column
+	const double scale = (density_ < 1) ? 1.0 / std::log1p(-density_) : 0;
+
+	for (size_t k = 0; k < count; k++) {
+		// stream of the presynaptic neuron
+		uint64_t state = seed_ ^ ((uint64_t)(source_ + rows[k]) * 0x9e3779b97f4a7c15ULL);
+
+		for (long c = -1; ; ) {
+			// uniform in (0, 1]
+			const double u = ((Next(state) >> 11) + 1) * (1.0 / 9007199254740992.0);
+			// clamped before the conversion, a tiny u at a low density overflows a long
+			c += 1 + (long)std::min(std::log(u) * scale, (double)targets_);
+			if (c >= targets_) {
+				break;
+			}
+			input[c] += weight_;
+			if (columns != nullptr) {
+				columns->push_back((int)c);
+			}
+		}
+	}
+}
+
+const void Projection::Touch(std::vector<int>* columns) const noexcept
+{
+	/*
+		columns = if given, every column is appended, a dense delivery reaches all of them
+	*/
+	if (columns == nullptr) {
+		return;
+	}
+
+	for (int c = 0; c < stride_; c++) {
+		columns->push_back(c);
+	}
+}
+
+const void Projection::Sum() noexcept
+{
+	/*
+		sums all rows of every column, delivered once at construction
+	*/
+	std::vector<int> rows(sources_);
+	for (int r = 0; r < sources_; r++) {
+		rows[r] = r;
+	}
+
+	sums_.assign(stride_, 0);
+	Deliver(rows.data(), rows.size(), sums_.data());
+}
+
+inline const uint64_t Projection::Next(uint64_t& state) noexcept
+{
+	/*
+		state = splitmix64 state, advanced
+		returns the next random number of the stream
+	*/
+	uint64_t x = (state += 0x9e3779b97f4a7c15ULL);
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+__attribute__((visibility("default"))) const Projection::Format Projection::GetFormat() const noexcept
+{
+	/*
+		Getter format_
+	*/
+	return format_;
+}
+
+__attribute__((visibility("default"))) const int Projection::GetSource() const noexcept
+{
+	/*
+		Getter source_
+	*/
+	return source_;
+}
+
+__attribute__((visibility("default"))) const int Projection::GetSources() const noexcept
+{
+	/*
+		Getter sources_
+	*/
+	return sources_;
+}
+
+__attribute__((visibility("default"))) const int Projection::GetTarget() const noexcept
+{
+	/*
+		Getter target_
+	*/
+	return target_;
+}
+
+__attribute__((visibility("default"))) const int Projection::GetTargets() const noexcept
+{
+	/*
+		Getter targets_
+	*/
+	return targets_;
+}
+
+__attribute__((visibility("default"))) const int Projection::GetColumns() const noexcept
+{
+	/*
+		returns length of the input array, the number of postsynaptic neurons padded to whole blocks
+	*/
+	return stride_;
+}
+
+__attribute__((visibility("default"))) const int Projection::GetDelay() const noexcept
+{
+	/*
+		Getter delay_
+	*/
+	return delay_;
+}
+
+__attribute__((visibility("default"))) const size_t Projection::GetStoredWeights() const noexcept
+{
+	/*
+		returns number of stored weights, including the zeros of padding and partially filled blocks
+		0 for procedural projections
+	*/
+	return weights_.size();
+}
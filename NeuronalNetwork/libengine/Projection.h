@@ -0,0 +1,102 @@
+//
+//  Projection.h
+//  NeuronalNetwork
+//
+//  Created by Nicolas Fricker on 04/10/20.
+//  Copyright © 2020 Nicolas Fricker. All rights reserved.
+//
+
+#ifndef Projection_
+#define Projection_
+
+#include "SpikeVector.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+#pragma GCC visibility push(hidden)
+
+class Projection
+{
+	/*
+		Weight matrix between a presynaptic and a postsynaptic range of neurons
+		spikes are delivered as a sparse vector times matrix product over the spike list,
+		accumulated into the input array of the postsynaptic range
+		dense matrices are row major with padded rows, sparse matrices are stored in blocked CSR,
+		procedural matrices store only their rule and regenerate the edges of a row at every spike
+		if more than half of the presynaptic neurons spiked, the silent rows are subtracted from the column sums
+	*/
+public:
+	enum class Format
+	{
+		dense,
+		sparse,
+		procedural
+	};
+
+private:
+	Format format_ = Format::dense;
+
+	// first presynaptic neuron and number of presynaptic neurons (rows)
+	int source_ = 0;
+	int sources_ = 0;
+	// first postsynaptic neuron and number of postsynaptic neurons (columns)
+	int target_ = 0;
+	int targets_ = 0;
+	// transmission delay [bins]
+	int delay_ = 0;
+
+	// distance between dense rows and length of the input array, padded to whole blocks
+	int stride_ = 0;
+	// dense weights, or the values of the non-zero blocks [µA]
+	std::vector<double> weights_;
+	// first block of every block row, sparse only
+	std::vector<int> block_rows_;
+	// block column of every non-zero block, sparse only
+	std::vector<int> block_cols_;
+	// sum of all rows of every column [µA], dense and sparse only
+	std::vector<double> sums_;
+	// edge probability, weight of every edge [µA] and random stream of the edges, procedural only
+	double density_ = 0;
+	double weight_ = 0;
+	uint64_t seed_ = 0;
+
+	// sparse block size, a block row is one vector register wide
+	inline constexpr static const int s_block_rows_ = 4;
+	inline constexpr static const int s_block_cols_ = 8;
+	// dense column tile held in cache while the spike rows are accumulated
+	inline constexpr static const int s_tile_ = 512;
+
+public:
+	Projection();
+
+	static Projection Dense(const int source, const int sources, const int target, const int targets, const std::vector<double>& weights, const int delay = 0);
+	static Projection Sparse(const int source, const int sources, const int target, const int targets, const std::vector<std::tuple<int, int, double>>& entries, const int delay = 0);
+	static Projection Random(const int source, const int sources, const int target, const int targets, const double density, const double weight, const uint64_t seed = 0, const int delay = 0);
+	static Projection Procedural(const int source, const int sources, const int target, const int targets, const double density, const double weight, const uint64_t seed = 0, const int delay = 0);
+
+	const void Deliver(const int* rows, const size_t count, double* __restrict input, std::vector<int>* columns = nullptr) const noexcept;
+	const void Deliver(const SpikeVector& spikes, int* rows, double* __restrict input, std::vector<int>* columns = nullptr) const noexcept;
+
+	const Format GetFormat() const noexcept;
+	const int GetSource() const noexcept;
+	const int GetSources() const noexcept;
+	const int GetTarget() const noexcept;
+	const int GetTargets() const noexcept;
+	const int GetColumns() const noexcept;
+	const int GetDelay() const noexcept;
+	const size_t GetStoredWeights() const noexcept;
+
+private:
+	const void DeliverDense(const int* rows, const size_t count, double* __restrict input, const double sign = 1) const noexcept;
+	const void DeliverSparse(const int* rows, const size_t count, double* __restrict input, const double sign = 1, std::vector<int>* columns = nullptr) const noexcept;
+	const void DeliverProcedural(const int* rows, const size_t count, double* __restrict input, std::vector<int>* columns = nullptr) const noexcept;
+	const void Touch(std::vector<int>* columns) const noexcept;
+	const void Sum() noexcept;
+	static const uint64_t Next(uint64_t& state) noexcept;
+};
+
+#pragma GCC visibility pop
+#endif /* Projection_ */
@@ -8,12 +8,21 @@
 
 #include "PythonWrapper.h"
 
+#include <algorithm>
 #include <iostream>
 #include <cmath>
 #include <chrono>
+#include <cstring>
+#include <numeric>
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 MyNN::MyNN(std::vector<int> layers): NeuronalNetwork(layers), layers(std::move(layers)), neurons(&GetNeurons()) {}
 
+MyNN::MyNN(std::vector<int> layers, Communicator* communicator): NeuronalNetwork(layers, communicator), layers(std::move(layers)), neurons(&GetNeurons()) {}
+
 MyNN::~MyNN() {}
 
 void MyNN::InitializeNetwork()
@@ -22,15 +31,13 @@ void MyNN::InitializeNetwork()
 		Overwritten method to initialize network (in this case it is a linear model)
 	*/
 	int count = 0;
+	// number of neurons in the network, a partition stores fewer
+	const int sum_neurons = std::accumulate(layers.begin(), layers.end(), 0);
 	
 	for (int i = 0; i < layers.size(); i++) {
 		for (int j = count; j < layers[i]; j++) {
-			for (int m = count; m < layers[i]; m++) {
-				if (j != m) {
-					// adds all neighboring neurons in the layer
-					(*neurons)[j].AddNeighbor(&(*neurons)[m]);
-				}
-			}
+			// adds all neighboring neurons in the layer
+			AddNeighbors(j, count, layers[i]);
 			count++;
 		}
 	}
@@ -40,10 +47,14 @@ void MyNN::InitializeNetwork()
 	for (int i = 0; i < layers.size() - 1; i++) {
 		count += layers[i];
 		// branchless initial index of layer
-		int branchless = ((i == 0) ? 0 : (i == layers.size() - 1) ? (int)neurons->size() - layers.back() : layers[i - 1]);
+		int branchless = ((i == 0) ? 0 : (i == layers.size() - 1) ? sum_neurons - layers.back() : layers[i - 1]);
+		// outgoing edges of the layer are given by its projections
+		if (HasProjection(i)) {
+			continue;
+		}
 		for (int j = branchless; j < layers[i] + branchless; j++) {
 			// assigns postsynaptic neuron using a modulo
-			(*neurons)[j].AddPostsynapticNeuron(&(*neurons)[count + j % layers[i + 1]]);
+			AddPostsynapticNeuron(j, count + j % layers[i + 1]);
 		}
 	}
 }
@@ -60,11 +71,79 @@ const void deinitialize()
 {
 	if (VOLTAGES) {
 		delete[] VOLTAGES;
+		VOLTAGES = nullptr;
 	}
 }
 
+const int set_tolerance(const double tol)
+{
+	// set static adaptive integration tolerance [mV], 0 for fixed time step, returns 0 if rejected with multi-rate gates
+	return NeuronalNetwork::SetTolerance(tol);
+}
+
+const void set_delays(const int synaptic, const int neighbor)
+{
+	// set static transmission delays [bins] between layers and between neighbors
+	NeuronalNetwork::SetSynapticDelay(synaptic);
+	NeuronalNetwork::SetNeighborDelay(neighbor);
+}
+
+const void set_recording(const int recording)
+{
+	// set static membrane potential recording, 0 keeps only the streaming accumulators
+	NeuronalNetwork::SetRecording(recording != 0);
+}
+
+const void set_plasticity(const int plasticity, const double a_plus, const double a_minus, const double tau_plus, const double tau_minus, const double max_gain)
+{
+	// set static spike timing dependent plasticity of networks created afterwards
+	NeuronalNetwork::SetPlasticity(plasticity != 0);
+	Neuron::SetPlasticity(a_plus, a_minus, tau_plus, tau_minus, max_gain);
+}
+
+const int set_multirate(const int interval)
+{
+	// set static bins between updates of the slow gates h and n of networks built afterwards, 1 for the single rate update, returns 0 if rejected with adaptive integration
+	return NeuronalNetwork::SetSlowInterval(interval);
+}
+
+const int set_implicit_coupling(const int implicit)
+{
+	// set static implicit coupling of the neighbor currents of networks created afterwards, returns 0 if rejected with adaptive or multi-rate integration
+	return NeuronalNetwork::SetImplicitCoupling(implicit != 0);
+}
+
+const void set_reordering(const int reordering)
+{
+	// set static renumbering of the neurons along their edges, ids and returned arrays stay in id order
+	NeuronalNetwork::SetReordering(reordering != 0);
+}
+
+const void set_spike_density(const double density)
+{
+	// set static firing density above which the spikes delivered through projections are packed into a bitset
+	SpikeVector::SetDensity(density);
+}
+
+const void set_profiling(const int profiling)
+{
+	// set static hardware counters per phase and per worker thread, printed at the end of run
+	NeuronalNetwork::SetProfiling(profiling != 0);
+}
+
+const void set_statistics(const int interval, const double isi_width, const int isi_bins)
+{
+	// set static population reduction interval [bins] and inter spike interval histogram [ms]
+	NeuronalNetwork::SetReduceInterval(interval);
+	Statistics::SetHistogram(isi_width, isi_bins);
+}
+
 const double* run(const double x, const double dt, const int size, int* layers, int n)
 {
+	/*
+		runs a network built for this call and returns the membrane potentials of all its bins,
+		neuron i occupies [i * size, (i + 1) * size), nullptr if the membrane potential is not recorded
+	*/
 	// set static Voltage clamp current [µA]
 	NeuronalNetwork::SetCurrentClamp(x);
 	// set static time step duration in [ms]
@@ -98,15 +177,738 @@ const double* run(const double x, const double dt, const int size, int* layers,
 	printf("Done\n");
 	
 	// retrieves vector reference of all neurons in the network
-	std::vector<Neuron>* neurons = &network.GetNeurons();
+	neurons_t* neurons = &network.GetNeurons();
+	
+	// without recording only the streaming statistics were kept, there are no membrane potentials to return
+	if (std::none_of(neurons->begin(), neurons->end(), [](const Neuron& neuron) { return neuron.IsRecording(); })) {
+		deinitialize();
+		return nullptr;
+	}
 
 	initialize((int)(neurons->size() * size));
 	
 	for (int i = 0; i < neurons->size(); i++) {
-		for (int j = 0; j < size; j++) {
-			VOLTAGES[(i * (*neurons)[i].GetHistorySize()) + j] = (*neurons)[i].GetHistory()[j];
+		// neuron of id i
+		Neuron& neuron = (*neurons)[network.GetPosition(i)];
+		// bins not in the history log are returned as 0
+		const size_t bins = std::min((size_t)size, neuron.GetHistorySize());
+		std::copy(neuron.GetHistory().begin(), neuron.GetHistory().begin() + bins, &VOLTAGES[(size_t)i * size]);
+		std::fill(&VOLTAGES[(size_t)i * size + bins], &VOLTAGES[(size_t)(i + 1) * size], 0.0);
+	}
+
+	return VOLTAGES;
+}
+
+void* run_async(const double x, const double dt, const int size, int* layers, int n)
+{
+	/*
+		starts run in a background thread and returns its handle at once
+		the run keeps its own current clamp, time step and size, concurrent runs share no settings
+		returns nullptr if the thread can not be created
+	*/
+	MyNN* network = new MyNN(std::vector<int>(layers, layers + n));
+	// Voltage clamp current [µA], time step duration [ms] and number of iterations of this run
+	network->Configure(x, dt, size);
+	
+	AsyncRun* run = new AsyncRun(network, size);
+	
+	if (!run->Start()) {
+		delete run;
+		return nullptr;
+	}
+	
+	return run;
+}
+
+const int run_poll(void* run)
+{
+	// returns the number of bins integrated so far
+	return reinterpret_cast<AsyncRun*>(run)->Poll();
+}
+
+const int run_done(void* run)
+{
+	// returns 1 once the run has finished or was cancelled
+	return reinterpret_cast<AsyncRun*>(run)->Done() ? 1 : 0;
+}
+
+const double* run_wait(void* run)
+{
+	/*
+		waits for the run and returns the membrane potentials of the bins integrated
+		neuron i occupies [i * bins, (i + 1) * bins), bins = run_poll(run)
+		the array belongs to the run and stays valid until run_release
+	*/
+	return reinterpret_cast<AsyncRun*>(run)->GetHistory();
+}
+
+const void run_cancel(void* run)
+{
+	// returns without waiting, the run stops at the next bin boundary
+	reinterpret_cast<AsyncRun*>(run)->Cancel();
+}
+
+const void run_release(void* run)
+{
+	// cancels the run if needed, waits for it and frees the network
+	delete reinterpret_cast<AsyncRun*>(run);
+}
+
+const double* ensemble(const double x, const double dt, const int size, int* layers, int n, const int replicas, const unsigned long long seed, const int threads)
+{
+	/*
+		runs independent randomized replicas, every worker thread integrates whole replicas
+		returns the firing rate [Hz] of every layer of every replica, replica r occupies [r * n, (r + 1) * n)
+	*/
+	// set static Voltage clamp current [µA]
+	NeuronalNetwork::SetCurrentClamp(x);
+	// set static time step duration in [ms]
+	NeuronalNetwork::SetTimeStep(dt);
+	// set static number of iterations
+	NeuronalNetwork::SetNumBins(size);
+	
+	Ensemble runner(std::vector<int>(layers, layers + n), replicas, seed, threads);
+	runner.Run(size);
+	
+	const std::vector<double>& rates = runner.GetRates();
+	
+	initialize((int)rates.size());
+	std::copy(rates.begin(), rates.end(), VOLTAGES);
+	
+	return VOLTAGES;
+}
+
+void* create(const double x, const double dt, const int size, int* layers, int n)
+{
+	/*
+		builds a persistent network advanced with step and run_until
+		size = expected number of bins, used to reserve the histories
+		the network keeps its current clamp, time step and size, later calls do not change them
+	*/
+	MyNN* network = new MyNN(std::vector<int>(layers, layers + n));
+	// Voltage clamp current [µA], time step duration [ms] and number of iterations of this network
+	network->Configure(x, dt, size);
+	
+	// connectivity is established by the first step, projections can be added until then
+	return network;
+}
+
+const void destroy(void* network)
+{
+	delete reinterpret_cast<MyNN*>(network);
+}
+
+const int step(void* network, const int bins)
+{
+	// returns the next bin to integrate
+	return reinterpret_cast<MyNN*>(network)->Step(bins);
+}
+
+const int run_until(void* network, const int bin)
+{
+	// returns the next bin to integrate
+	return reinterpret_cast<MyNN*>(network)->RunUntil(bin);
+}
+
+const int fork_branches(void* network, const int branches, const int bins)
+{
+	/*
+		forks branches processes continuing from the current bin, sharing the network copy-on-write
+		returns the branch in the child processes, -1 in the calling process
+	*/
+	return reinterpret_cast<MyNN*>(network)->Fork(branches, bins);
+}
+
+const void branch_join(void* network)
+{
+	// stores the bins of the branch and ends its process
+	reinterpret_cast<MyNN*>(network)->Join();
+}
+
+const double* branch_wait(void* network)
+{
+	/*
+		waits for the branches and returns their membrane potentials since the fork
+		branch b and neuron i occupy [(b * neurons + i) * bins, (b * neurons + i + 1) * bins)
+	*/
+	MyNN* nn = reinterpret_cast<MyNN*>(network);
+	const double* branches = nn->Wait();
+	const size_t size = (size_t)nn->GetBranchCount() * nn->GetNeurons().size() * nn->GetBranchBins();
+	
+	initialize((int)size);
+	
+	if (branches) {
+		memcpy(VOLTAGES, branches, size * sizeof(double));
+	}
+	
+	return VOLTAGES;
+}
+
+const void inject(void* network, const int index, const double current)
+{
+	// stimulus current [µA] added to the next bin of the neuron
+	reinterpret_cast<MyNN*>(network)->InjectCurrent(index, current);
+}
+
+const void stimulate_step(void* network, const int first, const int last, const double amplitude, const int begin, const int end)
+{
+	// current [µA] applied to neurons [first, last) in bins [begin, end)
+	reinterpret_cast<MyNN*>(network)->AddStimulus(Stimulus::Step(first, last, amplitude, begin, end));
+}
+
+const void stimulate_piecewise(void* network, const int first, const int last, const int* bins, const double* amplitudes, const int n)
+{
+	// current [µA] holding from each breakpoint bin until the next
+	std::vector<std::pair<int, double>> breakpoints(n);
+	for (int i = 0; i < n; i++) {
+		breakpoints[i] = {bins[i], amplitudes[i]};
+	}
+	reinterpret_cast<MyNN*>(network)->AddStimulus(Stimulus::Piecewise(first, last, breakpoints));
+}
+
+const void stimulate_pulses(void* network, const int first, const int last, const double amplitude, const int begin, const int period, const int width, const int count)
+{
+	// count pulses of width bins every period bins, -1 repeats forever
+	reinterpret_cast<MyNN*>(network)->AddStimulus(Stimulus::Pulses(first, last, amplitude, begin, period, width, count));
+}
+
+const void stimulate_poisson(void* network, const int first, const int last, const double amplitude, const double rate, const int width, const unsigned long long seed)
+{
+	// pulses of width bins with rate expected onsets per bin, independent per neuron
+	reinterpret_cast<MyNN*>(network)->AddStimulus(Stimulus::Poisson(first, last, amplitude, rate, width, seed));
+}
+
+const void stimulate_waveform(void* network, const int first, const int last, const double* samples, const int n, const int begin, const int repeat)
+{
+	// one current sample [µA] per bin starting at begin
+	reinterpret_cast<MyNN*>(network)->AddStimulus(Stimulus::Waveform(first, last, std::vector<double>(samples, samples + n), begin, repeat != 0));
+}
+
+const void clear_stimuli(void* network)
+{
+	// the current clamp of the first layer applies again
+	reinterpret_cast<MyNN*>(network)->ClearStimuli();
+}
+
+const void connect_dense(void* network, const int source_layer, const int target_layer, const double* weights, const int delay)
+{
+	// row major source layer x target layer weights [µA]
+	MyNN* nn = reinterpret_cast<MyNN*>(network);
+	const std::vector<int>& layers = nn->GetLayers();
+	const int source = std::accumulate(layers.begin(), layers.begin() + source_layer, 0);
+	const int target = std::accumulate(layers.begin(), layers.begin() + target_layer, 0);
+	const size_t n = (size_t)layers[source_layer] * layers[target_layer];
+	
+	nn->AddProjection(Projection::Dense(source, layers[source_layer], target, layers[target_layer], std::vector<double>(weights, weights + n), delay));
+}
+
+const void connect_sparse(void* network, const int source_layer, const int target_layer, const int* rows, const int* columns, const double* values, const int nnz, const int delay)
+{
+	// coordinate list of the non-zero weights [µA], rows and columns relative to the layers
+	MyNN* nn = reinterpret_cast<MyNN*>(network);
+	const std::vector<int>& layers = nn->GetLayers();
+	const int source = std::accumulate(layers.begin(), layers.begin() + source_layer, 0);
+	const int target = std::accumulate(layers.begin(), layers.begin() + target_layer, 0);
+	
+	std::vector<std::tuple<int, int, double>> entries(nnz);
+	for (int i = 0; i < nnz; i++) {
+		entries[i] = {rows[i], columns[i], values[i]};
+	}
+	
+	nn->AddProjection(Projection::Sparse(source, layers[source_layer], target, layers[target_layer], entries, delay));
+}
+
+const void connect_random(void* network, const int source_layer, const int target_layer, const double density, const double weight, const unsigned long long seed, const int delay)
+{
+	// edges with probability density and equal weight [µA], reproducible for a seed
+	MyNN* nn = reinterpret_cast<MyNN*>(network);
+	const std::vector<int>& layers = nn->GetLayers();
+	const int source = std::accumulate(layers.begin(), layers.begin() + source_layer, 0);
+	const int target = std::accumulate(layers.begin(), layers.begin() + target_layer, 0);
+	
+	nn->AddProjection(Projection::Random(source, layers[source_layer], target, layers[target_layer], density, weight, seed, delay));
+}
+
+const void connect_procedural(void* network, const int source_layer, const int target_layer, const double density, const double weight, const unsigned long long seed, const int delay)
+{
+	// edges with probability density and equal weight [µA], regenerated at every spike instead of stored
+	MyNN* nn = reinterpret_cast<MyNN*>(network);
+	const std::vector<int>& layers = nn->GetLayers();
+	const int source = std::accumulate(layers.begin(), layers.begin() + source_layer, 0);
+	const int target = std::accumulate(layers.begin(), layers.begin() + target_layer, 0);
+	
+	nn->AddProjection(Projection::Procedural(source, layers[source_layer], target, layers[target_layer], density, weight, seed, delay));
+}
+
+const double* potentials(void* network)
+{
+	/*
+		returns the current membrane potential of every neuron
+	*/
+	MyNN* nn = reinterpret_cast<MyNN*>(network);
+	const int n = (int)nn->GetNeurons().size();
+	
+	initialize(n);
+	
+	for (int i = 0; i < n; i++) {
+		VOLTAGES[i] = nn->GetMembranePotential(i);
+	}
+	
+	return VOLTAGES;
+}
+
+const double* history(void* network)
+{
+	/*
+		returns the membrane potentials of every neuron for all bins integrated so far
+		neuron i occupies [i * bins, (i + 1) * bins)
+		a network streaming to a writer without an archive only holds the samples not yet handed off,
+		the bins after them are returned as 0, as are all bins without recording
+	*/
+	MyNN* nn = reinterpret_cast<MyNN*>(network);
+	neurons_t* neurons = &nn->GetNeurons();
+	const size_t bins = nn->GetBin();
+	
+	initialize((int)(neurons->size() * bins));
+	
+	for (int i = 0; i < neurons->size(); i++) {
+		// neuron of id i
+		Neuron& neuron = (*neurons)[nn->GetPosition(i)];
+		const size_t recorded = std::min(bins, neuron.GetHistory().size());
+		memcpy(&VOLTAGES[i * bins], neuron.GetHistory().data(), recorded * sizeof(double));
+		std::fill(&VOLTAGES[i * bins + recorded], &VOLTAGES[(i + 1) * bins], 0.0);
+	}
+	
+	return VOLTAGES;
+}
+
+const double* profile(void* network)
+{
+	/*
+		returns time [s], cycles, instructions, last level cache misses and branch misses of every phase
+		drive, integrate, exchange, learn, publish, reduce, archive, all 0 unless profiled
+	*/
+	MyNN* nn = reinterpret_cast<MyNN*>(network);
+	const int phases = (int)NeuronalNetwork::Phase::count;
+	
+	initialize(5 * phases);
+	
+	for (int i = 0; i < phases; i++) {
+		const PerfCounters::Counts counts = nn->GetPhaseCounts((NeuronalNetwork::Phase)i);
+		VOLTAGES[5 * i + 0] = counts.seconds_;
+		VOLTAGES[5 * i + 1] = counts.cycles_;
+		VOLTAGES[5 * i + 2] = counts.instructions_;
+		VOLTAGES[5 * i + 3] = counts.cache_misses_;
+		VOLTAGES[5 * i + 4] = counts.branch_misses_;
+	}
+	
+	return VOLTAGES;
+}
+
+const double* gains(void* network)
+{
+	/*
+		returns the postsynaptic gain and the mean neighbor gain of every neuron
+	*/
+	MyNN* nn = reinterpret_cast<MyNN*>(network);
+	neurons_t* neurons = &nn->GetNeurons();
+	const int n = (int)neurons->size();
+	
+	initialize(2 * n);
+	
+	for (int i = 0; i < n; i++) {
+		// neuron of id i
+		Neuron& neuron = (*neurons)[nn->GetPosition(i)];
+		const int count = (int)neuron.GetNeighborCount();
+		double sum = 0;
+		for (int j = 0; j < count; j++) {
+			sum += neuron.GetNeighborGain(j);
 		}
+		VOLTAGES[2 * i + 0] = neuron.GetGain();
+		VOLTAGES[2 * i + 1] = (count > 0) ? sum / count : 1.0;
+	}
+	
+	return VOLTAGES;
+}
+
+const long long updates(void* network)
+{
+	/*
+		returns the number of Hodgkin-Huxley updates of all neurons, one per attempted adaptive sub-step
+		and one per realignment of its gates
+	*/
+	neurons_t* neurons = &reinterpret_cast<MyNN*>(network)->GetNeurons();
+	long long count = 0;
+	
+	for (int i = 0; i < neurons->size(); i++) {
+		count += (long long)(*neurons)[i].GetUpdateCount();
+	}
+	
+	return count;
+}
+
+const double* neuron_statistics(void* network)
+{
+	/*
+		returns mean [mV], variance [mV^2], spike count and mean inter spike interval [ms] of every neuron
+	*/
+	MyNN* nn = reinterpret_cast<MyNN*>(network);
+	const int n = (int)nn->GetNeurons().size();
+	
+	initialize(4 * n);
+	
+	for (int i = 0; i < n; i++) {
+		Statistics& statistics = nn->GetNeuronStatistics(i);
+		VOLTAGES[4 * i + 0] = statistics.GetMean();
+		VOLTAGES[4 * i + 1] = statistics.GetVariance();
+		VOLTAGES[4 * i + 2] = statistics.GetSpikes();
+		VOLTAGES[4 * i + 3] = statistics.GetMeanInterval();
+	}
+	
+	return VOLTAGES;
+}
+
+const double* layer_statistics(void* network)
+{
+	/*
+		returns mean [mV], variance [mV^2], spike count, mean population rate [Hz]
+		and Fano factor of the spike counts per interval of every layer
+	*/
+	MyNN* nn = reinterpret_cast<MyNN*>(network);
+	const int n = (int)nn->GetLayers().size();
+	
+	initialize(5 * n);
+	
+	for (int i = 0; i < n; i++) {
+		const Statistics statistics = nn->GetLayerStatistics(i);
+		const std::vector<double>& rate = nn->GetPopulationStatistics(i).GetRate();
+		VOLTAGES[5 * i + 0] = statistics.GetMean();
+		VOLTAGES[5 * i + 1] = statistics.GetVariance();
+		VOLTAGES[5 * i + 2] = statistics.GetSpikes();
+		VOLTAGES[5 * i + 3] = rate.empty() ? 0 : std::accumulate(rate.begin(), rate.end(), 0.0) / rate.size();
+		VOLTAGES[5 * i + 4] = nn->GetPopulationStatistics(i).GetFanoFactor();
+	}
+	
+	return VOLTAGES;
+}
+
+const double* isi_histogram(void* network, const int layer)
+{
+	/*
+		returns the inter spike interval histogram of the layer
+	*/
+	MyNN* nn = reinterpret_cast<MyNN*>(network);
+	const Statistics statistics = nn->GetLayerStatistics(layer);
+	const std::vector<size_t>& histogram = statistics.GetHistogram();
+	const int n = Statistics::GetHistogramBins();
+	
+	initialize(n);
+	
+	for (int i = 0; i < n; i++) {
+		VOLTAGES[i] = (i < histogram.size()) ? histogram[i] : 0;
+	}
+	
+	return VOLTAGES;
+}
+
+const double* population_rate(void* network, const int layer, int* length)
+{
+	/*
+		returns the population firing rate [Hz] of the layer for every complete reduction interval
+		length = number of intervals
+	*/
+	MyNN* nn = reinterpret_cast<MyNN*>(network);
+	
+	const std::vector<double>& rate = nn->GetPopulationStatistics(layer).GetRate();
+	*length = (int)rate.size();
+	
+	initialize(std::max(*length, 1));
+	std::copy(rate.begin(), rate.end(), VOLTAGES);
+	
+	return VOLTAGES;
+}
+
+void* telemetry_create(const char* name, const int capacity)
+{
+	/*
+		creates the shared memory ring buffer name, e.g. "/NeuronalNetwork.telemetry"
+		returns nullptr if the segment can not be created
+	*/
+	Telemetry* telemetry = new Telemetry(name, capacity);
+	
+	if (!telemetry->Valid()) {
+		delete telemetry;
+		return nullptr;
+	}
+	
+	return telemetry;
+}
+
+const void telemetry_destroy(void* telemetry)
+{
+	delete reinterpret_cast<Telemetry*>(telemetry);
+}
+
+const void monitor(void* network, void* telemetry, int* neurons, const int n, const int decimation)
+{
+	// publish the spikes and every decimation bins the membrane potential of the neurons
+	reinterpret_cast<MyNN*>(network)->SetTelemetry(reinterpret_cast<Telemetry*>(telemetry), std::vector<int>(neurons, neurons + n), decimation);
+}
+
+void* archive_create(const double min, const double max, const int bits, const int block)
+{
+	/*
+		creates a compressed trace store quantized to bits over [min, max] mV
+	*/
+	return new TraceArchive(min, max, bits, block);
+}
+
+const void archive_destroy(void* archive)
+{
+	delete reinterpret_cast<TraceArchive*>(archive);
+}
+
+const void archive(void* network, void* archive)
+{
+	// move the recorded membrane potentials into the archive block by block, nullptr stops
+	reinterpret_cast<MyNN*>(network)->SetArchive(reinterpret_cast<TraceArchive*>(archive));
+}
+
+const void archive_flush(void* network)
+{
+	// move the bins since the last block and encode the partial blocks
+	reinterpret_cast<MyNN*>(network)->Archive();
+}
+
+const int archive_save(void* archive, const char* path)
+{
+	// returns 1 on success
+	return reinterpret_cast<TraceArchive*>(archive)->Save(path) ? 1 : 0;
+}
+
+void* archive_load(const char* path)
+{
+	/*
+		opens an archive written by archive_save
+		returns nullptr if the file can not be read
+	*/
+	TraceArchive* archive = new TraceArchive();
+	
+	if (!archive->Load(path)) {
+		delete archive;
+		return nullptr;
+	}
+	
+	return archive;
+}
+
+const double* archive_read(void* archive, const int neuron, const int bin, const int count)
+{
+	/*
+		returns count membrane potentials of the neuron starting at bin, decoding only the overlapping blocks
+	*/
+	initialize(count);
+	std::fill_n(VOLTAGES, count, 0.0);
+	
+	reinterpret_cast<TraceArchive*>(archive)->Read(neuron, bin, count, VOLTAGES);
+	
+	return VOLTAGES;
+}
+
+const long long archive_bytes(void* archive)
+{
+	// size of the encoded blocks and the index
+	return (long long)reinterpret_cast<TraceArchive*>(archive)->GetBytes();
+}
+
+void* writer_create(const char* path, const int block, const int blocks)
+{
+	/*
+		creates the file path and its writer thread
+		returns nullptr if the file can not be created
+	*/
+	TraceWriter* writer = new TraceWriter(path, block, blocks);
+	
+	if (!writer->Valid()) {
+		delete writer;
+		return nullptr;
 	}
+	
+	return writer;
+}
+
+const void writer_destroy(void* writer)
+{
+	// writes the staged samples and closes the file
+	delete reinterpret_cast<TraceWriter*>(writer);
+}
+
+const void stream(void* network, void* writer)
+{
+	// stream the recorded membrane potentials to the writer's file, nullptr stops
+	reinterpret_cast<MyNN*>(network)->SetWriter(reinterpret_cast<TraceWriter*>(writer));
+}
 
+const void stream_flush(void* network)
+{
+	// hand off the bins since the last hand-off and wait until they are written
+	reinterpret_cast<MyNN*>(network)->Persist();
+}
+
+const long long writer_bytes(void* writer)
+{
+	// bytes in the file
+	return (long long)reinterpret_cast<TraceWriter*>(writer)->GetBytes();
+}
+
+const long long writer_stalls(void* writer)
+{
+	// hand-offs that waited for the writer thread
+	return (long long)reinterpret_cast<TraceWriter*>(writer)->GetStalls();
+}
+
+void* cable_create(const int cells, const int dendrites, const int segments, const int axon, const double dt)
+{
+	/*
+		creates cells ball and stick cells, a soma with dendrites trees of segments compartments and an axon
+	*/
+	return new Cable(Cable::BallAndStick(cells, dendrites, segments, axon, dt));
+}
+
+const void cable_destroy(void* cable)
+{
+	delete reinterpret_cast<Cable*>(cable);
+}
+
+const void cable_current(void* cable, const int cell, const int compartment, const double current)
+{
+	// constant current [µA] into the compartment of the cell
+	reinterpret_cast<Cable*>(cable)->SetCurrent(cell, compartment, current);
+}
+
+const double* cable_step(void* cable, const int bins)
+{
+	/*
+		integrates bins bins
+		returns bins x cells membrane potentials [mV] of the spike compartment, bin major
+	*/
+	Cable* c = reinterpret_cast<Cable*>(cable);
+	
+	initialize(bins * c->GetCells());
+	c->Step(bins, VOLTAGES);
+	
+	return VOLTAGES;
+}
+
+const long long cable_spikes(void* cable, const int cell)
+{
+	// threshold crossings of the spike compartment of the cell
+	return (long long)reinterpret_cast<Cable*>(cable)->GetSpikes(cell);
+}
+
+void* telemetry_open(const char* name)
+{
+	/*
+		attaches a reader to the ring buffer name from any process
+		returns nullptr if the segment does not exist yet
+	*/
+	TelemetryReader* reader = new TelemetryReader(name);
+	
+	if (!reader->Valid()) {
+		delete reader;
+		return nullptr;
+	}
+	
+	return reader;
+}
+
+const int telemetry_poll(void* reader, double* samples, const int max)
+{
+	/*
+		samples = max records of kind, neuron, bin and value
+		returns the number of records read since the last poll
+	*/
+	std::vector<TelemetrySample> records(max);
+	const int count = (int)reinterpret_cast<TelemetryReader*>(reader)->Poll(records.data(), max);
+	
+	for (int i = 0; i < count; i++) {
+		samples[4 * i + 0] = records[i].kind_;
+		samples[4 * i + 1] = records[i].neuron_;
+		samples[4 * i + 2] = records[i].bin_;
+		samples[4 * i + 3] = records[i].value_;
+	}
+	
+	return count;
+}
+
+const void telemetry_close(void* reader)
+{
+	delete reinterpret_cast<TelemetryReader*>(reader);
+}
+
+const double* run_partitioned(const double x, const double dt, const int size, int* layers, int n, const int processes, int* stored)
+{
+	/*
+		runs the network partitioned across local processes
+		every process integrates a range of neurons, spikes are exchanged over shared memory
+		every process only stores its own neurons and the neurons with edges into them
+		stored = number of neurons stored by every process, processes entries, nullptr to skip
+	*/
+	const int sum_neurons = std::accumulate(layers, layers + n, 0);
+	const size_t bytes = (size_t)sum_neurons * size * sizeof(double) + processes * sizeof(int);
+	
+	// membrane potentials and number of stored neurons written by every process, mapped before forking
+	double* voltages = reinterpret_cast<double*>(mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0));
+	
+	if (voltages == MAP_FAILED) {
+		return nullptr;
+	}
+	
+	int* counts = reinterpret_cast<int*>(voltages + (size_t)sum_neurons * size);
+	
+	// forks the processes of the group
+	SharedMemoryCommunicator* comm = SharedMemoryCommunicator::Spawn(processes);
+	
+	{
+		// every process builds its partition of the same network from the inherited random state
+		MyNN network(std::vector<int>(layers, layers + n), comm);
+		// Voltage clamp current [µA], time step duration [ms] and number of iterations of this run
+		network.Configure(x, dt, size);
+		
+		network.Step(size);
+		
+		neurons_t* neurons = &network.GetNeurons();
+		
+		for (int i = 0; i < sum_neurons; i++) {
+			// neuron of id i
+			const int k = network.GetPosition(i);
+			if (network.Owns(k)) {
+				memcpy(&voltages[(size_t)i * size], (*neurons)[k].GetHistory().data(), std::min((size_t)size, (*neurons)[k].GetHistorySize()) * sizeof(double));
+			}
+		}
+		
+		counts[comm->Rank()] = (int)neurons->size();
+	}
+	
+	// all partitions are written
+	comm->Barrier();
+	
+	if (comm->Rank() != 0) {
+		_exit(0);
+	}
+	
+	// reap children
+	while (wait(nullptr) > 0);
+	
+	delete comm;
+	
+	if (stored) {
+		memcpy(stored, counts, processes * sizeof(int));
+	}
+	
+	initialize(sum_neurons * size);
+	memcpy(VOLTAGES, voltages, (size_t)sum_neurons * size * sizeof(double));
+	munmap(voltages, bytes);
+	
 	return VOLTAGES;
 }
@@ -11,6 +11,9 @@
 
 #pragma GCC visibility push(default)
 
+#include "AsyncRun.h"
+#include "Cable.h"
+#include "Ensemble.h"
 #include "NeuronalNetwork.h"
 
 #include <vector>
@@ -25,10 +28,11 @@ class MyNN: public NeuronalNetwork
 	// layers in the network for linear model (in this case)
 	std::vector<int> layers = {16, 4, 1};
 	// array of entire neurons in the entire network
-	std::vector<Neuron>* neurons = nullptr;
+	neurons_t* neurons = nullptr;
 	
 public:
 	MyNN(std::vector<int> layers);
+	MyNN(std::vector<int> layers, Communicator* communicator);
 	~MyNN();
 	
 	void InitializeNetwork();
@@ -38,7 +42,77 @@ static double* VOLTAGES;
 
 extern "C" const void initialize(int n);
 extern "C" const void deinitialize();
+extern "C" const int set_tolerance(const double tol);
+extern "C" const void set_delays(const int synaptic, const int neighbor);
+extern "C" const void set_recording(const int recording);
+extern "C" const void set_plasticity(const int plasticity, const double a_plus = 0.01, const double a_minus = 0.012, const double tau_plus = 20.0, const double tau_minus = 20.0, const double max_gain = 2.0);
+extern "C" const int set_multirate(const int interval);
+extern "C" const int set_implicit_coupling(const int implicit);
+extern "C" const void set_reordering(const int reordering);
+extern "C" const void set_spike_density(const double density);
+extern "C" const void set_profiling(const int profiling);
+extern "C" const void set_statistics(const int interval, const double isi_width = 1.0, const int isi_bins = 100);
 extern "C" const double* run(const double x = 0.451, const double dt = 0.01, const int size = 10000, int* layers = nullptr, int n = 0);
+extern "C" void* run_async(const double x = 0.451, const double dt = 0.01, const int size = 10000, int* layers = nullptr, int n = 0);
+extern "C" const int run_poll(void* run);
+extern "C" const int run_done(void* run);
+extern "C" const double* run_wait(void* run);
+extern "C" const void run_cancel(void* run);
+extern "C" const void run_release(void* run);
+extern "C" const double* ensemble(const double x = 0.451, const double dt = 0.01, const int size = 10000, int* layers = nullptr, int n = 0, const int replicas = 1000, const unsigned long long seed = 0, const int threads = 0);
+extern "C" void* create(const double x = 0.451, const double dt = 0.01, const int size = 10000, int* layers = nullptr, int n = 0);
+extern "C" const void destroy(void* network);
+extern "C" const int step(void* network, const int bins = 1);
+extern "C" const int run_until(void* network, const int bin);
+extern "C" const int fork_branches(void* network, const int branches, const int bins);
+extern "C" const void branch_join(void* network);
+extern "C" const double* branch_wait(void* network);
+extern "C" const void inject(void* network, const int index, const double current);
+extern "C" const void stimulate_step(void* network, const int first, const int last, const double amplitude, const int begin = 0, const int end = -1);
+extern "C" const void stimulate_piecewise(void* network, const int first, const int last, const int* bins, const double* amplitudes, const int n);
+extern "C" const void stimulate_pulses(void* network, const int first, const int last, const double amplitude, const int begin, const int period, const int width, const int count = -1);
+extern "C" const void stimulate_poisson(void* network, const int first, const int last, const double amplitude, const double rate, const int width = 1, const unsigned long long seed = 0);
+extern "C" const void stimulate_waveform(void* network, const int first, const int last, const double* samples, const int n, const int begin = 0, const int repeat = 0);
+extern "C" const void clear_stimuli(void* network);
+extern "C" const void connect_dense(void* network, const int source_layer, const int target_layer, const double* weights, const int delay = 0);
+extern "C" const void connect_sparse(void* network, const int source_layer, const int target_layer, const int* rows, const int* columns, const double* values, const int nnz, const int delay = 0);
+extern "C" const void connect_random(void* network, const int source_layer, const int target_layer, const double density, const double weight, const unsigned long long seed = 0, const int delay = 0);
+extern "C" const void connect_procedural(void* network, const int source_layer, const int target_layer, const double density, const double weight, const unsigned long long seed = 0, const int delay = 0);
+extern "C" const double* potentials(void* network);
+extern "C" const double* history(void* network);
+extern "C" const double* profile(void* network);
+extern "C" const double* gains(void* network);
+extern "C" const long long updates(void* network);
+extern "C" const double* neuron_statistics(void* network);
+extern "C" const double* layer_statistics(void* network);
+extern "C" const double* isi_histogram(void* network, const int layer);
+extern "C" const double* population_rate(void* network, const int layer, int* length);
+extern "C" void* telemetry_create(const char* name, const int capacity = 1 << 16);
+extern "C" const void telemetry_destroy(void* telemetry);
+extern "C" const void monitor(void* network, void* telemetry, int* neurons, const int n, const int decimation = 1);
+extern "C" void* archive_create(const double min = -90.0, const double max = 60.0, const int bits = 16, const int block = 1024);
+extern "C" const void archive_destroy(void* archive);
+extern "C" const void archive(void* network, void* archive);
+extern "C" const void archive_flush(void* network);
+extern "C" const int archive_save(void* archive, const char* path);
+extern "C" void* archive_load(const char* path);
+extern "C" const double* archive_read(void* archive, const int neuron, const int bin, const int count);
+extern "C" const long long archive_bytes(void* archive);
+extern "C" void* writer_create(const char* path, const int block = 1 << 20, const int blocks = 4);
+extern "C" const void writer_destroy(void* writer);
+extern "C" const void stream(void* network, void* writer);
+extern "C" const void stream_flush(void* network);
+extern "C" const long long writer_bytes(void* writer);
+extern "C" const long long writer_stalls(void* writer);
+extern "C" void* cable_create(const int cells, const int dendrites = 4, const int segments = 10, const int axon = 20, const double dt = 0.01);
+extern "C" const void cable_destroy(void* cable);
+extern "C" const void cable_current(void* cable, const int cell, const int compartment, const double current);
+extern "C" const double* cable_step(void* cable, const int bins);
+extern "C" const long long cable_spikes(void* cable, const int cell);
+extern "C" void* telemetry_open(const char* name);
+extern "C" const int telemetry_poll(void* reader, double* samples, const int max);
+extern "C" const void telemetry_close(void* reader);
+extern "C" const double* run_partitioned(const double x = 0.451, const double dt = 0.01, const int size = 10000, int* layers = nullptr, int n = 0, const int processes = 2, int* stored = nullptr);
 
 #pragma GCC visibility pop
 #endif /* PythonWrapper_ */
@@ -0,0 +1,149 @@
+//
+//  SpikeVector.cpp
+//  NeuronalNetwork
+//
+//  Created by Nicolas Fricker on 04/10/20.
+//  Copyright © 2020 Nicolas Fricker. All rights reserved.
+//
+
+#include "SpikeVector.h"
+
+#include <algorithm>
+
+SpikeVector::SpikeVector() {}
+
+__attribute__((visibility("default"))) const void SpikeVector::Reset(const int size) noexcept
+{
+	/*
+		size = number of neurons in the range
+		empties the vector, the storage of both representations is kept
+	*/
+	size_ = std::max(size, 0);
+	count_ = 0;
+	dense_ = false;
+	rows_.clear();
+}
+
+__attribute__((visibility("default"))) const void SpikeVector::Add(const int row) noexcept
+{
+	/*
+		row = spiking neuron, relative to the first neuron of the range
+	*/
+	rows_.push_back(row);
+	count_++;
+}
+
+__attribute__((visibility("default"))) const void SpikeVector::Pack() noexcept
+{
+	/*
+		packs the rows into the bitset if the observed firing density is above the threshold
+		rows spiking twice are counted once in the bitset
+	*/
+	if (count_ < s_density_ * size_) {
+		return;
+	}
+
+	bits_.assign((size_ + 63) / 64, 0);
+
+	for (int i = 0; i < rows_.size(); i++) {
+		bits_[rows_[i] >> 6] |= 1ULL << (rows_[i] & 63);
+	}
+
+	count_ = 0;
+	for (int w = 0; w < bits_.size(); w++) {
+		count_ += __builtin_popcountll(bits_[w]);
+	}
+
+	dense_ = true;
+}
+
+__attribute__((visibility("default"))) const size_t SpikeVector::Gather(int* rows, const bool silent) const noexcept
+{
+	/*
+		rows = output array of up to GetSize() rows in ascending order
+		silent = false gathers the spiking rows, true the rows without spike
+		returns the number of gathered rows
+	*/
+	if (!dense_) {
+		if (silent) {
+			return 0;
+		}
+		std::copy(rows_.begin(), rows_.end(), rows);
+		return rows_.size();
+	}
+
+	size_t count = 0;
+
+	for (int w = 0; w < bits_.size(); w++) {
+		uint64_t word = silent ? ~bits_[w] : bits_[w];
+
+		// bits past the end of the range
+		if (w == bits_.size() - 1 && (size_ & 63)) {
+			word &= (1ULL << (size_ & 63)) - 1;
+		}
+
+		while (word) {
+			rows[count++] = (w << 6) + __builtin_ctzll(word);
+			// clears the lowest set bit
+			word &= word - 1;
+		}
+	}
+
+	return count;
+}
+
+__attribute__((visibility("default"))) const bool SpikeVector::IsDense() const noexcept
+{
+	/*
+		Getter dense_
+	*/
+	return dense_;
+}
+
+__attribute__((visibility("default"))) const bool SpikeVector::Empty() const noexcept
+{
+	/*
+		returns true if no neuron spiked
+	*/
+	return count_ == 0;
+}
+
+__attribute__((visibility("default"))) const size_t SpikeVector::GetCount() const noexcept
+{
+	/*
+		Getter count_
+	*/
+	return count_;
+}
+
+__attribute__((visibility("default"))) const int SpikeVector::GetSize() const noexcept
+{
+	/*
+		Getter size_
+	*/
+	return size_;
+}
+
+__attribute__((visibility("default"))) const std::vector<int>& SpikeVector::GetRows() const noexcept
+{
+	/*
+		Getter rows_
+	*/
+	return rows_;
+}
+
+__attribute__((visibility("default"))) const std::vector<uint64_t>& SpikeVector::GetBits() const noexcept
+{
+	/*
+		Getter bits_, valid if IsDense
+	*/
+	return bits_;
+}
+
+__attribute__((visibility("default"))) const void SpikeVector::SetDensity(const double density) noexcept
+{
+	/*
+		sets static firing density above which spikes are packed into the bitset, above 1 never packs
+	*/
+	SpikeVector::s_density_ = std::max(density, 0.0);
+}
@@ -0,0 +1,60 @@
+//
+//  SpikeVector.h
+//  NeuronalNetwork
+//
+//  Created by Nicolas Fricker on 04/10/20.
+//  Copyright © 2020 Nicolas Fricker. All rights reserved.
+//
+
+#ifndef SpikeVector_
+#define SpikeVector_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#pragma GCC visibility push(hidden)
+
+class SpikeVector
+{
+	/*
+		Spikes of one bin over a range of neurons
+		collected as a list of rows, packed into a bitset once the firing density makes
+		the list longer than the words of the bitset, the rows are then iterated with count trailing zeros
+	*/
+	// number of neurons in the range
+	int size_ = 0;
+	// number of spikes
+	size_t count_ = 0;
+	// packed representation in use
+	bool dense_ = false;
+
+	// rows of the spikes, sparse representation
+	std::vector<int> rows_;
+	// one bit per row, dense representation
+	std::vector<uint64_t> bits_;
+
+	// firing density above which the rows are packed into the bitset
+	inline static double s_density_ = 1.0 / 16;
+
+public:
+	SpikeVector();
+
+	const void Reset(const int size) noexcept;
+	const void Add(const int row) noexcept;
+	const void Pack() noexcept;
+
+	const size_t Gather(int* rows, const bool silent) const noexcept;
+
+	const bool IsDense() const noexcept;
+	const bool Empty() const noexcept;
+	const size_t GetCount() const noexcept;
+	const int GetSize() const noexcept;
+	const std::vector<int>& GetRows() const noexcept;
+	const std::vector<uint64_t>& GetBits() const noexcept;
+
+	static const void SetDensity(const double density) noexcept;
+};
+
+#pragma GCC visibility pop
+#endif /* SpikeVector_ */
@@ -0,0 +1,351 @@
+//
+//  StaticNetwork.hpp
+//  NeuronalNetwork
+//
+//  Created by Nicolas Fricker on 04/10/20.
+//  Copyright © 2020 Nicolas Fricker. All rights reserved.
+//
+
+#ifndef StaticNetwork_
+#define StaticNetwork_
+
+#include "FastMath.hpp"
+#include "NeuronalNetwork.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdio>
+#include <utility>
+
+#pragma GCC visibility push(hidden)
+
+template <int... Layers>
+class StaticNetwork
+{
+	/*
+		Network of a fixed layer topology known at compile time, e.g. StaticNetwork<16, 4, 1>
+		linear model of MyNN: the neurons of a layer are neighbors of each other,
+		neuron j of a layer is presynaptic to neuron j modulo the size of the next layer
+		the state lives in std::arrays, the layer loops are unrolled and a bin never allocates
+		spikes reach the next layer within the bin and the neighbors in the next bin, without threads, delays or plasticity
+		with implicit coupling the neighbor currents of a layer are solved together with its membrane update,
+		the spikes then reach the neighbors within the bin
+	*/
+	static_assert(sizeof...(Layers) > 0, "StaticNetwork needs at least one layer");
+	static_assert(((Layers > 0) && ...), "StaticNetwork layers must not be empty");
+
+public:
+	// number of layers
+	inline constexpr static const size_t s_layers_ = sizeof...(Layers);
+	// number of neurons
+	inline constexpr static const int s_neurons_ = (Layers + ...);
+	// size of layers
+	inline constexpr static const std::array<int, sizeof...(Layers)> s_sizes_ = {Layers...};
+
+private:
+	// membrane potential [mV]
+	std::array<double, s_neurons_> Vm_;
+	// membrane capacitance density [uF/cm^2]
+	std::array<double, s_neurons_> Cm_;
+	// sodium activation, sodium inactivation and potassium activation
+	std::array<double, s_neurons_> m_;
+	std::array<double, s_neurons_> h_;
+	std::array<double, s_neurons_> n_;
+	// change of h and n per bin between their multi-rate updates
+	std::array<double, s_neurons_> dh_;
+	std::array<double, s_neurons_> dn_;
+	// output current [µA]
+	std::array<double, s_neurons_> oc_;
+	// neighbor current increase [µA]
+	std::array<double, s_neurons_> nc_;
+	// input current [µA] of the next bin
+	std::array<double, s_neurons_> Isum_;
+	// input current [µA] of the bin being integrated
+	std::array<double, s_neurons_> input_;
+	// number of threshold crossings
+	std::array<size_t, s_neurons_> spikes_;
+	// scratch of the implicit coupling solver
+	std::array<double, 4 * s_neurons_> work_;
+
+	// current clamp of the first layer [µA]
+	double Iclamp_ = 0.451;
+	// time step [ms]
+	double dt_ = 0.01;
+	// bins between updates of the slow gates h and n, 1 updates every gate every bin
+	int slow_interval_ = 1;
+	// next bin to integrate
+	int bin_ = 0;
+	// neighbor currents of the spikes of a bin are solved within the bin instead of sent to the next bin
+	bool implicit_ = false;
+
+public:
+	StaticNetwork(const double Iclamp = 0.451, const double dt = 0.01, const int slow_interval = 1);
+
+	const void Load(NeuronalNetwork& network) noexcept;
+	const int Step(const int bins = 1, double* history = nullptr) noexcept;
+	const void InjectCurrent(const int index, const double current) noexcept;
+
+	const double GetMembranePotential(const int index) const noexcept;
+	const size_t GetSpikes(const int index) const noexcept;
+	const int GetBin() const noexcept;
+
+	const void SetOutputCurrent(const int index, const double oc) noexcept;
+	const void SetNeighboringInfluence(const int index, const double nc) noexcept;
+	const void SetImplicitCoupling(const bool implicit) noexcept;
+	const void SetSlowInterval(const int bins) noexcept;
+
+	constexpr static int GetLayerOffset(const size_t layer) noexcept;
+
+private:
+	template <size_t... L>
+	const void Advance(std::index_sequence<L...>) noexcept;
+	template <size_t L>
+	const void Layer() noexcept;
+};
+
+#pragma GCC visibility pop
+
+template <int... Layers>
+StaticNetwork<Layers...>::StaticNetwork(const double Iclamp, const double dt, const int slow_interval)
+{
+	/*
+		Iclamp = current clamp of the first layer [µA]
+		dt = time step [ms]
+		slow_interval = bins between updates of the slow gates h and n
+		neurons start at rest with the currents of the middle of the Neuron ranges
+	*/
+	Iclamp_ = Iclamp;
+	dt_ = dt;
+	slow_interval_ = std::max(slow_interval, 1);
+
+	Vm_.fill(-64.9964);
+	Cm_.fill(0.01);
+	m_.fill(0.0530);
+	h_.fill(0.5960);
+	n_.fill(0.3177);
+	dh_.fill(0);
+	dn_.fill(0);
+	oc_.fill(0.03);
+	nc_.fill(0.003);
+	Isum_.fill(0);
+	input_.fill(0);
+	spikes_.fill(0);
+}
+
+template <int... Layers>
+const void StaticNetwork<Layers...>::Load(NeuronalNetwork& network) noexcept
+{
+	/*
+		network = network of the same layer sizes
+		copies the complete state of its neurons, gates and the input pending for the next bin included,
+		its current clamp, time step, slow gate interval and bin, e.g. to embed a trained network or to continue a run
+		stepping the copy then reproduces the network as long as it runs without delays, stimuli or plasticity
+	*/
+	neurons_t& neurons = network.GetNeurons();
+
+	for (int i = 0; i < s_neurons_ && i < neurons.size(); i++) {
+		// neuron of id i
+		const Neuron& neuron = neurons[network.GetPosition(i)];
+		Vm_[i] = neuron.Vm_;
+		Cm_[i] = neuron.Cm_;
+		m_[i] = neuron.m_;
+		h_[i] = neuron.h_;
+		n_[i] = neuron.n_;
+		dh_[i] = neuron.dh_;
+		dn_[i] = neuron.dn_;
+		oc_[i] = neuron.oc_;
+		nc_[i] = neuron.nc_;
+		// currents already sent to the next bin, from the neighbors and the stimuli
+		Isum_[i] = neuron.a_Isum_.load() + (neuron.a_delayed_.empty() ? 0 : neuron.a_delayed_[neuron.bin_ % neuron.a_delayed_.size()].load());
+		spikes_[i] = neuron.stats_.GetSpikes();
+	}
+
+	Iclamp_ = network.GetCurrentClamp();
+	dt_ = network.GetTimeStep();
+	slow_interval_ = network.GetSlowInterval();
+	bin_ = network.GetBin();
+}
+
+template <int... Layers>
+const int StaticNetwork<Layers...>::Step(const int bins, double* history) noexcept
+{
+	/*
+		bins = number of bins to integrate
+		history = nullptr or bins x s_neurons_ membrane potentials [mV], bin major
+		returns the next bin to integrate, -1 if the layers are coupled implicitly with the slow gates at multiple rates,
+		the coupled kernel updates every gate every bin
+	*/
+	if (implicit_ && slow_interval_ > 1) {
+		printf("static network error: the implicitly coupled layers do not integrate the slow gates every %d bins\n", slow_interval_);
+		return -1;
+	}
+
+	for (int b = 0; b < bins; b++) {
+		Advance(std::make_index_sequence<s_layers_>());
+
+		if (history) {
+			std::copy(Vm_.begin(), Vm_.end(), history + (size_t)b * s_neurons_);
+		}
+
+		bin_++;
+	}
+
+	return bin_;
+}
+
+template <int... Layers>
+const void StaticNetwork<Layers...>::InjectCurrent(const int index, const double current) noexcept
+{
+	/*
+		index = neuron index
+		current = stimulus current added to the next bin of the neuron (µA)
+	*/
+	Isum_[index] += current;
+}
+
+template <int... Layers>
+const double StaticNetwork<Layers...>::GetMembranePotential(const int index) const noexcept
+{
+	/*
+		returns the membrane potential after the last integrated bin (mV)
+	*/
+	return Vm_[index];
+}
+
+template <int... Layers>
+const size_t StaticNetwork<Layers...>::GetSpikes(const int index) const noexcept
+{
+	/*
+		returns the number of threshold crossings of the neuron
+	*/
+	return spikes_[index];
+}
+
+template <int... Layers>
+const int StaticNetwork<Layers...>::GetBin() const noexcept
+{
+	/*
+		returns the next bin to integrate
+	*/
+	return bin_;
+}
+
+template <int... Layers>
+const void StaticNetwork<Layers...>::SetOutputCurrent(const int index, const double oc) noexcept
+{
+	/*
+		sets output current [µA] to the postsynaptic neuron
+	*/
+	oc_[index] = oc;
+}
+
+template <int... Layers>
+const void StaticNetwork<Layers...>::SetNeighboringInfluence(const int index, const double nc) noexcept
+{
+	/*
+		sets neighbor current increase [µA]
+	*/
+	nc_[index] = nc;
+}
+
+template <int... Layers>
+const void StaticNetwork<Layers...>::SetImplicitCoupling(const bool implicit) noexcept
+{
+	/*
+		implicit = solves the neighbor currents of every layer together with its membrane update,
+		stable at time steps several times larger than the explicit current of the next bin
+	*/
+	implicit_ = implicit;
+}
+
+template <int... Layers>
+const void StaticNetwork<Layers...>::SetSlowInterval(const int bins) noexcept
+{
+	/*
+		bins = bins between updates of the slow gates h and n, they advance over the whole interval on its first bin
+		and are interpolated on the others, 1 updates every gate every bin
+	*/
+	slow_interval_ = std::max(bins, 1);
+}
+
+template <int... Layers>
+constexpr int StaticNetwork<Layers...>::GetLayerOffset(const size_t layer) noexcept
+{
+	/*
+		returns the index of the first neuron of the layer
+	*/
+	int offset = 0;
+	for (size_t i = 0; i < layer; i++) {
+		offset += s_sizes_[i];
+	}
+	return offset;
+}
+
+template <int... Layers>
+template <size_t... L>
+const void StaticNetwork<Layers...>::Advance(std::index_sequence<L...>) noexcept
+{
+	/*
+		integrates one bin, the layers in order
+	*/
+	(Layer<L>(), ...);
+}
+
+template <int... Layers>
+template <size_t L>
+const void StaticNetwork<Layers...>::Layer() noexcept
+{
+	/*
+		integrates one layer with the batched Hodgkin-Huxley kernel
+		and sends the currents of its spiking neurons to the next layer and to the neighbors
+	*/
+	constexpr int offset = GetLayerOffset(L);
+	constexpr int size = s_sizes_[L];
+
+	// state at the start of the bin
+	std::array<double, size> V0;
+
+	for (int k = 0; k < size; k++) {
+		V0[k] = Vm_[offset + k];
+		input_[offset + k] = Isum_[offset + k] + ((L == 0) ? Iclamp_ : 0);
+		Isum_[offset + k] = 0;
+	}
+
+	if (implicit_) {
+		// membrane update and neighbor currents of the bin solved together
+		Neuron::IntegrateCoupled(&Vm_[offset], &m_[offset], &h_[offset], &n_[offset], &Cm_[offset], &nc_[offset], &input_[offset], size, dt_, work_.data());
+	} else {
+		// slow gates advance over the whole interval on its first bin and are interpolated on the others
+		const double slow_dt = (bin_ % slow_interval_ == 0) ? dt_ * slow_interval_ : 0;
+		Neuron::IntegrateBatch(&Vm_[offset], &m_[offset], &h_[offset], &n_[offset], &dh_[offset], &dn_[offset], &Cm_[offset], &input_[offset], size, dt_, slow_dt);
+	}
+
+	for (int k = 0; k < size; k++) {
+		if (Vm_[offset + k] < Neuron::s_Vthreashold_) {
+			continue;
+		}
+
+		// threshold crossing on an upstroke
+		spikes_[offset + k] += (V0[k] < Neuron::s_Vthreashold_);
+
+		if constexpr (L + 1 < s_layers_) {
+			// postsynaptic neuron by modulo
+			Isum_[GetLayerOffset(L + 1) + k % s_sizes_[L + 1]] += oc_[offset + k];
+		}
+
+		if (implicit_) {
+			// neighbors received the current within the bin
+			continue;
+		}
+
+		// same current for all neighbors
+		const double current = nc_[offset + k] * FastMath::Exp(- Vm_[offset + k] / Neuron::s_Vrest_);
+
+		for (int j = 0; j < size; j++) {
+			Isum_[offset + j] += (j != k) ? current : 0;
+		}
+	}
+}
+
+#endif /* StaticNetwork_ */
@@ -0,0 +1,209 @@
+//
+//  Statistics.cpp
+//  NeuronalNetwork
+//
+//  Created by Nicolas Fricker on 04/10/20.
+//  Copyright © 2020 Nicolas Fricker. All rights reserved.
+//
+
+#include "Statistics.h"
+
+#include <algorithm>
+
+Statistics::Statistics() {}
+
+const void Statistics::Add(const double x, const size_t k) noexcept
+{
+	/*
+		x = membrane potential sample [mV]
+		k = number of identical samples, e.g. bins skipped by a resting cell
+		merges the k samples into the running moments at once
+	*/
+	if (k == 0) {
+		return;
+	}
+
+	const size_t n = count_ + k;
+	const double delta = x - mean_;
+
+	mean_ += delta * k / n;
+	m2_ += delta * delta * ((double)count_ * k / n);
+	count_ = n;
+}
+
+const void Statistics::Spike(const double t) noexcept
+{
+	/*
+		t = interpolated spike time [ms]
+		counts the spike and bins the interval to the previous spike
+	*/
+	spikes_++;
+	interval_spikes_++;
+
+	if (last_spike_ >= 0) {
+		const double isi = t - last_spike_;
+
+		if (isi_.empty()) {
+			isi_.resize(s_isi_bins_);
+		}
+
+		// intervals beyond the histogram are collected in the last bin
+		const int i = std::min((int)(isi / s_isi_width_), (int)isi_.size() - 1);
+		isi_[std::max(i, 0)]++;
+
+		isi_sum_ += isi;
+		isi_count_++;
+	}
+
+	last_spike_ = t;
+}
+
+const void Statistics::Merge(const Statistics& other) noexcept
+{
+	/*
+		other = accumulators of another neuron
+		parallel combination of the moments (Chan et al.), counts and histograms add up
+	*/
+	if (other.count_ > 0) {
+		const size_t n = count_ + other.count_;
+		const double delta = other.mean_ - mean_;
+
+		mean_ += delta * other.count_ / n;
+		m2_ += other.m2_ + delta * delta * ((double)count_ * other.count_ / n);
+		count_ = n;
+	}
+
+	spikes_ += other.spikes_;
+	isi_sum_ += other.isi_sum_;
+	isi_count_ += other.isi_count_;
+
+	if (!other.isi_.empty()) {
+		if (isi_.size() < other.isi_.size()) {
+			isi_.resize(other.isi_.size());
+		}
+		for (int i = 0; i < other.isi_.size(); i++) {
+			isi_[i] += other.isi_[i];
+		}
+	}
+}
+
+const void Statistics::Clear() noexcept
+{
+	/*
+		resets all accumulators
+	*/
+	*this = Statistics();
+}
+
+const size_t Statistics::TakeIntervalSpikes() noexcept
+{
+	/*
+		returns the spikes since the last call and restarts the interval count
+	*/
+	const size_t spikes = interval_spikes_;
+	interval_spikes_ = 0;
+	return spikes;
+}
+
+const size_t Statistics::GetCount() const noexcept
+{
+	/*
+		Getter count_
+	*/
+	return count_;
+}
+
+const double Statistics::GetMean() const noexcept
+{
+	/*
+		Getter mean_
+	*/
+	return mean_;
+}
+
+const double Statistics::GetVariance() const noexcept
+{
+	/*
+		returns the sample variance [mV^2]
+	*/
+	return (count_ > 1) ? m2_ / (count_ - 1) : 0;
+}
+
+__attribute__((visibility("default"))) const size_t Statistics::GetSpikes() const noexcept
+{
+	/*
+		Getter spikes_
+	*/
+	return spikes_;
+}
+
+const double Statistics::GetMeanInterval() const noexcept
+{
+	/*
+		returns the mean inter spike interval [ms], 0 with less than two spikes
+	*/
+	return (isi_count_ > 0) ? isi_sum_ / isi_count_ : 0;
+}
+
+const std::vector<size_t>& Statistics::GetHistogram() const noexcept
+{
+	/*
+		returns the inter spike interval histogram, empty with less than two spikes
+	*/
+	return isi_;
+}
+
+const void Statistics::SetHistogram(const double width, const int bins) noexcept
+{
+	/*
+		width = bin width [ms]
+		bins = number of bins
+		applies to histograms allocated afterwards
+	*/
+	Statistics::s_isi_width_ = width;
+	Statistics::s_isi_bins_ = std::max(bins, 1);
+}
+
+const int Statistics::GetHistogramBins() noexcept
+{
+	/*
+		Getter s_isi_bins_
+	*/
+	return Statistics::s_isi_bins_;
+}
+
+PopulationStatistics::PopulationStatistics() {}
+
+const void PopulationStatistics::Add(const size_t spikes, const int neurons, const int bins, const double dt) noexcept
+{
+	/*
+		spikes = spikes of the population in the interval
+		neurons = population size
+		bins = interval length [bins]
+		dt = bin duration [ms]
+	*/
+	// spikes per neuron per second
+	rate_.push_back((neurons > 0 && bins > 0) ? 1000.0 * spikes / (neurons * bins * dt) : 0);
+
+	count_++;
+	const double delta = spikes - mean_;
+	mean_ += delta / count_;
+	m2_ += delta * (spikes - mean_);
+}
+
+const std::vector<double>& PopulationStatistics::GetRate() const noexcept
+{
+	/*
+		returns the population firing rate time series [Hz]
+	*/
+	return rate_;
+}
+
+const double PopulationStatistics::GetFanoFactor() const noexcept
+{
+	/*
+		returns variance over mean of the spike counts per interval
+		about 1 for independent Poisson firing, larger for synchronous firing
+	*/
+	return (count_ > 1 && mean_ > 0) ? (m2_ / (count_ - 1)) / mean_ : 0;
+}
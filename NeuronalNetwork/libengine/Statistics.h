@@ -0,0 +1,113 @@
+//
+//  Statistics.h
+//  NeuronalNetwork
+//
+//  Created by Nicolas Fricker on 04/10/20.
+//  Copyright © 2020 Nicolas Fricker. All rights reserved.
+//
+
+#ifndef Statistics_
+#define Statistics_
+
+#include <cstddef>
+#include <vector>
+
+#pragma GCC visibility push(hidden)
+
+class Statistics
+{
+	/*
+		Streaming accumulators of a neuron or a population
+		Welford moments of the membrane potential, spike count and inter spike interval histogram
+		updated every bin instead of retaining the membrane potential trace
+	*/
+
+	// number of membrane potential samples
+	size_t count_ = 0;
+	// running mean [mV]
+	double mean_ = 0;
+	// running sum of squared deviations [mV^2]
+	double m2_ = 0;
+
+	// number of spikes
+	size_t spikes_ = 0;
+	// number of spikes since the last population reduction
+	size_t interval_spikes_ = 0;
+	// time [ms] of the last spike, -1 before the first one
+	double last_spike_ = -1;
+	// sum of inter spike intervals [ms]
+	double isi_sum_ = 0;
+	// number of inter spike intervals
+	size_t isi_count_ = 0;
+
+	// inter spike interval histogram, allocated with the first interval
+	std::vector<size_t> isi_;
+
+	// width [ms] of an inter spike interval histogram bin
+	inline static double s_isi_width_ = 1.0;
+	// number of inter spike interval histogram bins, the last bin collects longer intervals
+	inline static int s_isi_bins_ = 100;
+
+public:
+	Statistics();
+
+	inline const void Add(const double x) noexcept;
+	const void Add(const double x, const size_t k) noexcept;
+	const void Spike(const double t) noexcept;
+	const void Merge(const Statistics& other) noexcept;
+	const void Clear() noexcept;
+
+	const size_t TakeIntervalSpikes() noexcept;
+
+	const size_t GetCount() const noexcept;
+	const double GetMean() const noexcept;
+	const double GetVariance() const noexcept;
+	__attribute__((visibility("default"))) const size_t GetSpikes() const noexcept;
+	const double GetMeanInterval() const noexcept;
+	const std::vector<size_t>& GetHistogram() const noexcept;
+
+	static const void SetHistogram(const double width, const int bins) noexcept;
+	static const int GetHistogramBins() noexcept;
+};
+
+class PopulationStatistics
+{
+	/*
+		Accumulators of a layer reduced from its neurons at a fixed interval of bins
+		keeps the population firing rate time series and the moments of the spike counts per interval
+		the Fano factor of the counts measures synchrony, it grows when neurons fire together
+	*/
+
+	// population firing rate [Hz] of every interval
+	std::vector<double> rate_;
+
+	// number of intervals
+	size_t count_ = 0;
+	// running mean of the spike counts per interval
+	double mean_ = 0;
+	// running sum of squared deviations of the spike counts per interval
+	double m2_ = 0;
+
+public:
+	PopulationStatistics();
+
+	const void Add(const size_t spikes, const int neurons, const int bins, const double dt) noexcept;
+
+	const std::vector<double>& GetRate() const noexcept;
+	const double GetFanoFactor() const noexcept;
+};
+
+inline const void Statistics::Add(const double x) noexcept
+{
+	/*
+		x = membrane potential sample [mV]
+		Welford update of the running moments
+	*/
+	count_++;
+	const double delta = x - mean_;
+	mean_ += delta / count_;
+	m2_ += delta * (x - mean_);
+}
+
+#pragma GCC visibility pop
+#endif /* Statistics_ */
@@ -0,0 +1,241 @@
+//
+//  Stimulus.cpp
+//  NeuronalNetwork
+//
+//  Created by Nicolas Fricker on 04/10/20.
+//  Copyright © 2020 Nicolas Fricker. All rights reserved.
+//
+
+#include "Stimulus.h"
+
+#include <algorithm>
+
+Stimulus::Stimulus() {}
+
+__attribute__((visibility("default"))) Stimulus Stimulus::Step(const int first, const int last, const double amplitude, const int begin, const int end)
+{
+	/*
+		first, last = range of targeted neurons [first, last)
+		amplitude = current (µA) applied in [begin, end), end = -1 never ends
+	*/
+	Stimulus stimulus;
+	stimulus.kind_ = Kind::step;
+	stimulus.first_ = first;
+	stimulus.last_ = last;
+	stimulus.amplitude_ = amplitude;
+	stimulus.begin_ = begin;
+	stimulus.end_ = end;
+	return stimulus;
+}
+
+__attribute__((visibility("default"))) Stimulus Stimulus::Piecewise(const int first, const int last, const std::vector<std::pair<int, double>>& breakpoints)
+{
+	/*
+		first, last = range of targeted neurons [first, last)
+		breakpoints = (bin, current) pairs, every current holds until the next breakpoint
+		no current is applied before the first breakpoint
+	*/
+	Stimulus stimulus;
+	stimulus.kind_ = Kind::piecewise;
+	stimulus.first_ = first;
+	stimulus.last_ = last;
+
+	std::vector<std::pair<int, double>> sorted = breakpoints;
+	std::stable_sort(sorted.begin(), sorted.end(), [](const std::pair<int, double>& a, const std::pair<int, double>& b) { return a.first < b.first; });
+
+	for (int i = 0; i < sorted.size(); i++) {
+		stimulus.bins_.push_back(sorted[i].first);
+		stimulus.samples_.push_back(sorted[i].second);
+	}
+
+	return stimulus;
+}
+
+__attribute__((visibility("default"))) Stimulus Stimulus::Pulses(const int first, const int last, const double amplitude, const int begin, const int period, const int width, const int count)
+{
+	/*
+		first, last = range of targeted neurons [first, last)
+		amplitude = pulse current (µA)
+		begin = onset bin of the first pulse
+		period, width = pulse period and duration [bins]
+		count = number of pulses, -1 repeats forever
+	*/
+	Stimulus stimulus;
+	stimulus.kind_ = Kind::pulses;
+	stimulus.first_ = first;
+	stimulus.last_ = last;
+	stimulus.amplitude_ = amplitude;
+	stimulus.begin_ = begin;
+	stimulus.period_ = std::max(period, 1);
+	stimulus.width_ = std::max(width, 0);
+	stimulus.end_ = (count < 0) ? -1 : begin + count * stimulus.period_;
+	return stimulus;
+}
+
+__attribute__((visibility("default"))) Stimulus Stimulus::Poisson(const int first, const int last, const double amplitude, const double rate, const int width, const uint64_t seed)
+{
+	/*
+		first, last = range of targeted neurons [first, last)
+		amplitude = current (µA) of every pulse, overlapping pulses add up
+		rate = expected number of pulse onsets per bin
+		width = pulse duration [bins]
+		seed = random stream, the same seed reproduces the same onsets
+	*/
+	Stimulus stimulus;
+	stimulus.kind_ = Kind::poisson;
+	stimulus.first_ = first;
+	stimulus.last_ = last;
+	stimulus.amplitude_ = amplitude;
+	stimulus.rate_ = rate;
+	stimulus.width_ = std::max(width, 1);
+	stimulus.seed_ = seed;
+	return stimulus;
+}
+
+__attribute__((visibility("default"))) Stimulus Stimulus::Waveform(const int first, const int last, const std::vector<double>& samples, const int begin, const bool repeat)
+{
+	/*
+		first, last = range of targeted neurons [first, last)
+		samples = current (µA) of consecutive bins starting at begin
+		repeat = restarts the waveform after the last sample
+	*/
+	Stimulus stimulus;
+	stimulus.kind_ = Kind::waveform;
+	stimulus.first_ = first;
+	stimulus.last_ = last;
+	stimulus.begin_ = begin;
+	stimulus.samples_ = samples;
+	stimulus.repeat_ = repeat;
+	return stimulus;
+}
+
+__attribute__((visibility("default"))) const Stimulus::Kind Stimulus::GetKind() const noexcept
+{
+	/*
+		Getter kind_
+	*/
+	return kind_;
+}
+
+__attribute__((visibility("default"))) const bool Stimulus::Targets(const int neuron) const noexcept
+{
+	/*
+		returns true if the neuron receives the stimulus
+	*/
+	return neuron >= first_ && neuron < last_;
+}
+
+__attribute__((visibility("default"))) const int Stimulus::GetFirst() const noexcept
+{
+	/*
+		Getter first_
+	*/
+	return first_;
+}
+
+__attribute__((visibility("default"))) const int Stimulus::GetLast() const noexcept
+{
+	/*
+		Getter last_
+	*/
+	return last_;
+}
+
+__attribute__((visibility("default"))) const double Stimulus::Current(const int neuron, const int bin) const noexcept
+{
+	/*
+		neuron = neuron index
+		bin = bin index
+		returns the stimulus current (µA) of the neuron in the bin
+	*/
+	if (!Targets(neuron) || bin < begin_ || (end_ >= 0 && bin >= end_)) {
+		return 0;
+	}
+
+	switch (kind_) {
+		case Kind::step:
+			return amplitude_;
+		case Kind::piecewise: {
+			// last breakpoint at or before the bin
+			const long i = std::upper_bound(bins_.begin(), bins_.end(), bin) - bins_.begin() - 1;
+			return (i < 0) ? 0 : samples_[i];
+		}
+		case Kind::pulses:
+			return ((bin - begin_) % period_ < width_) ? amplitude_ : 0;
+		case Kind::poisson: {
+			// pulses started within the last width bins
+			int count = 0;
+			for (int k = std::max(bin - width_ + 1, begin_); k <= bin; k++) {
+				count += Onset(neuron, k);
+			}
+			return count * amplitude_;
+		}
+		case Kind::waveform: {
+			size_t i = bin - begin_;
+			if (repeat_ && !samples_.empty()) {
+				i %= samples_.size();
+			}
+			return (i < samples_.size()) ? samples_[i] : 0;
+		}
+	}
+
+	return 0;
+}
+
+__attribute__((visibility("default"))) const void Stimulus::Compile(const int neuron, const int bin, const int bins, double* current) const noexcept
+{
+	/*
+		neuron = neuron index
+		bin = first bin of the window
+		bins = window length
+		current = dense per bin array of the window, the stimulus is added to it
+	*/
+	if (!Targets(neuron)) {
+		return;
+	}
+
+	if (kind_ != Kind::poisson) {
+		for (int k = 0; k < bins; k++) {
+			current[k] += Current(neuron, bin + k);
+		}
+		return;
+	}
+
+	// sliding count of the pulses started within the last width bins
+	int count = 0;
+
+	for (int k = bin - width_ + 1; k < bin + bins; k++) {
+		if (k >= begin_ && k >= 0) {
+			count += Onset(neuron, k);
+		}
+		// drop the pulse started width bins ago, once it was counted in this window
+		if (k > bin && k - width_ >= begin_ && k - width_ >= 0) {
+			count -= Onset(neuron, k - width_);
+		}
+		if (k >= bin) {
+			current[k - bin] += count * amplitude_;
+		}
+	}
+}
+
+const bool Stimulus::Onset(const int neuron, const int bin) const noexcept
+{
+	/*
+		returns true if a pulse starts in the bin
+		counter based random numbers, independent of the evaluation order
+	*/
+	const uint64_t x = Hash(seed_ ^ Hash(((uint64_t)(uint32_t)neuron << 32) | (uint32_t)bin));
+	// uniform in [0, 1) from the upper 53 bits
+	return (double)(x >> 11) * (1.0 / 9007199254740992.0) < rate_;
+}
+
+inline uint64_t Stimulus::Hash(uint64_t x) noexcept
+{
+	/*
+		splitmix64 finalizer
+	*/
+	x += 0x9e3779b97f4a7c15ULL;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
@@ -0,0 +1,93 @@
+//
+//  Stimulus.h
+//  NeuronalNetwork
+//
+//  Created by Nicolas Fricker on 04/10/20.
+//  Copyright © 2020 Nicolas Fricker. All rights reserved.
+//
+
+#ifndef Stimulus_
+#define Stimulus_
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#pragma GCC visibility push(hidden)
+
+class Stimulus
+{
+	/*
+		Time varying current protocol applied to a range of neurons
+		evaluated per bin without state, so it can be generated on the fly
+		or compiled into dense per bin arrays for a window of bins
+	*/
+public:
+	enum class Kind
+	{
+		// amplitude between two bins
+		step,
+		// piecewise constant amplitude at breakpoints
+		piecewise,
+		// periodic rectangular pulses
+		pulses,
+		// rectangular pulses at Poisson distributed onsets, independent per neuron
+		poisson,
+		// arbitrary sampled waveform, one sample per bin
+		waveform
+	};
+
+private:
+	Kind kind_ = Kind::step;
+
+	// range of targeted neurons [first_, last_)
+	int first_ = 0;
+	int last_ = 0;
+
+	// current amplitude (µA)
+	double amplitude_ = 0;
+	// first bin of the protocol
+	int begin_ = 0;
+	// bin the protocol ends before, -1 never ends
+	int end_ = -1;
+
+	// pulse period and width [bins]
+	int period_ = 1;
+	int width_ = 1;
+
+	// expected number of pulse onsets per bin
+	double rate_ = 0;
+	// random stream of the Poisson onsets
+	uint64_t seed_ = 0;
+
+	// breakpoint bins and amplitudes of piecewise protocols, waveform samples
+	std::vector<int> bins_;
+	std::vector<double> samples_;
+	// waveform repeats after its last sample
+	bool repeat_ = false;
+
+public:
+	Stimulus();
+
+	static Stimulus Step(const int first, const int last, const double amplitude, const int begin = 0, const int end = -1);
+	static Stimulus Piecewise(const int first, const int last, const std::vector<std::pair<int, double>>& breakpoints);
+	static Stimulus Pulses(const int first, const int last, const double amplitude, const int begin, const int period, const int width, const int count = -1);
+	static Stimulus Poisson(const int first, const int last, const double amplitude, const double rate, const int width = 1, const uint64_t seed = 0);
+	static Stimulus Waveform(const int first, const int last, const std::vector<double>& samples, const int begin = 0, const bool repeat = false);
+
+	const Kind GetKind() const noexcept;
+	const bool Targets(const int neuron) const noexcept;
+	const int GetFirst() const noexcept;
+	const int GetLast() const noexcept;
+
+	const double Current(const int neuron, const int bin) const noexcept;
+	const void Compile(const int neuron, const int bin, const int bins, double* current) const noexcept;
+
+private:
+	const bool Onset(const int neuron, const int bin) const noexcept;
+	static inline uint64_t Hash(uint64_t x) noexcept;
+};
+
+#pragma GCC visibility pop
+#endif /* Stimulus_ */
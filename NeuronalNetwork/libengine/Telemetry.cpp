@@ -0,0 +1,237 @@
+//
+//  Telemetry.cpp
+//  NeuronalNetwork
+//
+//  Created by Nicolas Fricker on 04/10/20.
+//  Copyright © 2020 Nicolas Fricker. All rights reserved.
+//
+
+#include "Telemetry.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+Telemetry::Telemetry(const std::string name, const size_t capacity)
+{
+	/*
+		name = POSIX shared memory segment name
+		capacity = number of records, rounded up to a power of two
+	*/
+	name_ = name;
+
+	uint64_t records = 1;
+	while (records < capacity) {
+		records <<= 1;
+	}
+
+	bytes_ = sizeof(Header) + records * sizeof(Record);
+
+	const int fd = shm_open(name_.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+	if (fd < 0 || ftruncate(fd, bytes_) != 0) {
+		printf("%s: telemetry creation error\n", name_.c_str());
+		if (fd >= 0) {
+			close(fd);
+		}
+		return;
+	}
+
+	void* segment = mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (segment == MAP_FAILED) {
+		printf("%s: telemetry mapping error\n", name_.c_str());
+		return;
+	}
+
+	segment_ = reinterpret_cast<char*>(segment);
+
+	// segment is zero filled by ftruncate, readers check the magic last
+	GetHeader()->capacity_ = records;
+	std::atomic_thread_fence(std::memory_order_release);
+	GetHeader()->magic_ = s_magic_;
+}
+
+Telemetry::~Telemetry()
+{
+	/*
+		Deconstructor
+		attached readers keep their mapping, the name is removed
+	*/
+	if (segment_) {
+		munmap(segment_, bytes_);
+		shm_unlink(name_.c_str());
+	}
+}
+
+const bool Telemetry::Valid() const noexcept
+{
+	/*
+		returns true if the segment is mapped
+	*/
+	return segment_ != nullptr;
+}
+
+const void Telemetry::Publish(const int kind, const int neuron, const int bin, const double value) noexcept
+{
+	/*
+		kind = 0 membrane potential sample, 1 spike
+		neuron = neuron index
+		bin = bin of the sample
+		value = membrane potential [mV] or spike time [ms]
+		overwrites the oldest record, never waits
+	*/
+	if (!segment_) {
+		return;
+	}
+
+	Record& record = GetRecords()[head_ & (GetHeader()->capacity_ - 1)];
+
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	// odd sequence marks the slot as being written
+	record.a_sequence_.store(2 * head_ + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	record.a_key_.store(((uint64_t)(kind != 0) << 63) | ((uint64_t)(uint32_t)neuron << 32) | (uint32_t)bin, std::memory_order_relaxed);
+	record.a_value_.store(bits, std::memory_order_relaxed);
+
+	record.a_sequence_.store(2 * head_ + 2, std::memory_order_release);
+
+	head_++;
+	GetHeader()->a_head_.store(head_, std::memory_order_release);
+}
+
+Telemetry::Header* Telemetry::GetHeader() const noexcept
+{
+	/*
+		returns segment header
+	*/
+	return reinterpret_cast<Header*>(segment_);
+}
+
+Telemetry::Record* Telemetry::GetRecords() const noexcept
+{
+	/*
+		returns ring of records
+	*/
+	return reinterpret_cast<Record*>(segment_ + sizeof(Header));
+}
+
+TelemetryReader::TelemetryReader(const std::string name)
+{
+	/*
+		name = POSIX shared memory segment name of the producer
+		starts with the oldest record still held by the ring
+	*/
+	const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+	struct stat st;
+
+	if (fd < 0 || fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(Telemetry::Header)) {
+		if (fd >= 0) {
+			close(fd);
+		}
+		return;
+	}
+
+	void* segment = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (segment == MAP_FAILED) {
+		return;
+	}
+
+	segment_ = reinterpret_cast<const char*>(segment);
+	bytes_ = st.st_size;
+
+	const Telemetry::Header* header = reinterpret_cast<const Telemetry::Header*>(segment_);
+
+	if (header->magic_ != Telemetry::s_magic_ || sizeof(Telemetry::Header) + header->capacity_ * sizeof(Telemetry::Record) > bytes_) {
+		munmap(const_cast<char*>(segment_), bytes_);
+		segment_ = nullptr;
+		return;
+	}
+	std::atomic_thread_fence(std::memory_order_acquire);
+
+	const uint64_t head = header->a_head_.load(std::memory_order_acquire);
+	cursor_ = (head > header->capacity_) ? head - header->capacity_ : 0;
+}
+
+TelemetryReader::~TelemetryReader()
+{
+	/*
+		Deconstructor
+	*/
+	if (segment_) {
+		munmap(const_cast<char*>(segment_), bytes_);
+	}
+}
+
+const bool TelemetryReader::Valid() const noexcept
+{
+	/*
+		returns true if attached to an initialized segment
+	*/
+	return segment_ != nullptr;
+}
+
+const size_t TelemetryReader::Poll(TelemetrySample* samples, const size_t max) noexcept
+{
+	/*
+		samples = output array
+		max = size of the output array
+		copies the records published since the last poll, returns their number
+	*/
+	if (!segment_) {
+		return 0;
+	}
+
+	const Telemetry::Header* header = reinterpret_cast<const Telemetry::Header*>(segment_);
+	const Telemetry::Record* records = reinterpret_cast<const Telemetry::Record*>(segment_ + sizeof(Telemetry::Header));
+	const uint64_t capacity = header->capacity_;
+	const uint64_t head = header->a_head_.load(std::memory_order_acquire);
+
+	if (head - cursor_ > capacity) {
+		// records overwritten while this reader was behind
+		dropped_ += head - capacity - cursor_;
+		cursor_ = head - capacity;
+	}
+
+	size_t count = 0;
+
+	for (; cursor_ < head && count < max; cursor_++) {
+		const Telemetry::Record& record = records[cursor_ & (capacity - 1)];
+
+		const uint64_t sequence = record.a_sequence_.load(std::memory_order_acquire);
+		const uint64_t key = record.a_key_.load(std::memory_order_relaxed);
+		const uint64_t bits = record.a_value_.load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+
+		// slot rewritten by the producer while it was copied
+		if (sequence != 2 * cursor_ + 2 || record.a_sequence_.load(std::memory_order_relaxed) != sequence) {
+			dropped_++;
+			continue;
+		}
+
+		samples[count].kind_ = (int)(key >> 63);
+		samples[count].neuron_ = (int)((key >> 32) & 0x7fffffff);
+		samples[count].bin_ = (int)(uint32_t)key;
+		memcpy(&samples[count].value_, &bits, sizeof(bits));
+		count++;
+	}
+
+	return count;
+}
+
+const uint64_t TelemetryReader::GetDropped() const noexcept
+{
+	/*
+		returns number of records overwritten before they were read
+	*/
+	return dropped_;
+}
@@ -0,0 +1,114 @@
+//
+//  Telemetry.h
+//  NeuronalNetwork
+//
+//  Created by Nicolas Fricker on 04/10/20.
+//  Copyright © 2020 Nicolas Fricker. All rights reserved.
+//
+
+#ifndef Telemetry_
+#define Telemetry_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#pragma GCC visibility push(hidden)
+
+struct TelemetrySample
+{
+	// 0 membrane potential sample, 1 spike
+	int kind_;
+	// neuron index
+	int neuron_;
+	// bin of the sample
+	int bin_;
+	// membrane potential [mV] or spike time [ms]
+	double value_;
+};
+
+class Telemetry
+{
+	/*
+		Single producer, multiple consumer ring buffer in a POSIX shared memory segment
+		the simulation publishes without waiting for readers, every slot is guarded by a sequence number
+		readers that fall behind by more than the capacity lose the oldest records
+	*/
+public:
+	struct Record
+	{
+		// 2 * index + 1 while the slot is written, 2 * index + 2 once published
+		std::atomic<uint64_t> a_sequence_;
+		// kind << 63 | neuron << 32 | bin
+		std::atomic<uint64_t> a_key_;
+		// bit pattern of the value
+		std::atomic<uint64_t> a_value_;
+	};
+
+	struct Header
+	{
+		// identifies an initialized segment
+		uint64_t magic_;
+		// number of records, a power of two
+		uint64_t capacity_;
+		// number of records published
+		std::atomic<uint64_t> a_head_;
+	};
+
+	inline constexpr static const uint64_t s_magic_ = 0x4e4e54454c454d31ULL;
+
+private:
+	// segment name
+	std::string name_;
+	// mapped segment
+	char* segment_ = nullptr;
+	// mapped segment size [bytes]
+	size_t bytes_ = 0;
+	// records published, only the producer writes it
+	uint64_t head_ = 0;
+
+public:
+	Telemetry(const std::string name, const size_t capacity = 1 << 16);
+	~Telemetry();
+
+	Telemetry(const Telemetry& other) = delete;
+	Telemetry& operator=(const Telemetry& other) = delete;
+
+	const bool Valid() const noexcept;
+	const void Publish(const int kind, const int neuron, const int bin, const double value) noexcept;
+
+private:
+	Header* GetHeader() const noexcept;
+	Record* GetRecords() const noexcept;
+};
+
+class TelemetryReader
+{
+	/*
+		Consumer of a telemetry segment, attaches read only
+		every reader keeps its own cursor, readers never block the producer
+	*/
+	// mapped segment
+	const char* segment_ = nullptr;
+	// mapped segment size [bytes]
+	size_t bytes_ = 0;
+	// index of the next record to read
+	uint64_t cursor_ = 0;
+	// records overwritten before they were read
+	uint64_t dropped_ = 0;
+
+public:
+	TelemetryReader(const std::string name);
+	~TelemetryReader();
+
+	TelemetryReader(const TelemetryReader& other) = delete;
+	TelemetryReader& operator=(const TelemetryReader& other) = delete;
+
+	const bool Valid() const noexcept;
+	const size_t Poll(TelemetrySample* samples, const size_t max) noexcept;
+	const uint64_t GetDropped() const noexcept;
+};
+
+#pragma GCC visibility pop
+#endif /* Telemetry_ */
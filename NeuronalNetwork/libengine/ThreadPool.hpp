@@ -9,8 +9,6 @@
 #ifndef ThreadPool_
 #define ThreadPool_
 
-#pragma GCC visibility push(hidden)
-
 #ifdef _WIN32
 #include <windows.h>
 
@@ -29,6 +27,9 @@
 #include <vector>
 
 #include <pthread.h>
+#include <signal.h>
+
+#pragma GCC visibility push(hidden)
 
 template <class thread, class queue, class result>
 class ThreadPool {
@@ -66,6 +67,7 @@ class ThreadPool {
 	const int progress() noexcept;
 	
 	std::vector<result>* results() noexcept;
+	std::vector<thread>* threads() noexcept;
 	
 	const bool started() noexcept;
 	const bool stopped() noexcept;
@@ -120,7 +122,6 @@ class ThreadPool {
 };
 
 #pragma GCC visibility pop
-#endif /* ThreadPool_ */
 
 template <class thread, class queue, class result>
 ThreadPool<thread, queue, result>::ThreadPool(int n_items, int n_threads) {
@@ -276,6 +277,14 @@ inline std::vector<result>* ThreadPool<thread, queue, result>::results() noexcep
 	return &results_;
 }
 
+template <class thread, class queue, class result>
+inline std::vector<thread>* ThreadPool<thread, queue, result>::threads() noexcept {
+	/*
+		returns thread objects, only read them while no thread is running
+	*/
+	return &threads_;
+}
+
 template <class thread, class queue, class result>
 const bool ThreadPool<thread, queue, result>::started() noexcept {
 	/*
@@ -425,7 +434,10 @@ void* ThreadPool<thread, queue, result>::Thread_::launch(void* pVoid) noexcept {
 	if (pthread) {
 		pthread->result_ = pthread->run();
 		pthread->finished();
-		pthread_exit(pthread->result_);
+		// returning is equivalent to pthread_exit, without forced unwinding through noexcept frames
+		return pthread->result_;
 	}
-	pthread_exit(nullptr);
+	return nullptr;
 }
+
+#endif /* ThreadPool_ */
@@ -0,0 +1,365 @@
+//
+//  TraceArchive.cpp
+//  NeuronalNetwork
+//
+//  Created by Nicolas Fricker on 04/10/20.
+//  Copyright © 2020 Nicolas Fricker. All rights reserved.
+//
+
+#include "TraceArchive.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+__attribute__((visibility("default"))) TraceArchive::TraceArchive(const double min, const double max, const int bits, const int block)
+{
+	/*
+		min, max = quantization range [mV], samples outside are clamped
+		bits = quantization resolution, 16 bits over [-90, 60] mV resolve 2.3 µV
+		block = samples per block, the unit of random access
+	*/
+	min_ = min;
+	max_ = (max > min) ? max : min + 1;
+	bits_ = std::clamp(bits, 2, 30);
+	block_ = std::max(block, 2);
+}
+
+__attribute__((visibility("default"))) const void TraceArchive::Append(const int neuron, const double* samples, const size_t count) noexcept
+{
+	/*
+		neuron = neuron index
+		samples = consecutive membrane potentials [mV] following the ones already appended
+		count = number of samples
+		every full block is encoded right away
+	*/
+	Reserve(neuron);
+
+	std::vector<int32_t>& open = open_[neuron];
+
+	for (size_t i = 0; i < count; i++) {
+		open.push_back(Quantize(samples[i]));
+		samples_[neuron]++;
+
+		if (open.size() == block_) {
+			Encode(neuron);
+		}
+	}
+}
+
+__attribute__((visibility("default"))) const void TraceArchive::Flush() noexcept
+{
+	/*
+		encodes the partial blocks of all neurons, e.g. at the end of a run
+		appending afterwards starts new blocks
+	*/
+	for (int neuron = 0; neuron < open_.size(); neuron++) {
+		if (!open_[neuron].empty()) {
+			Encode(neuron);
+		}
+	}
+}
+
+__attribute__((visibility("default"))) const size_t TraceArchive::Read(const int neuron, const int bin, const int count, double* samples) const noexcept
+{
+	/*
+		neuron = neuron index
+		bin = first bin to read
+		count = number of bins to read
+		samples = output array of count membrane potentials [mV]
+		decodes only the blocks overlapping [bin, bin + count), returns the number of samples read
+	*/
+	if (neuron < 0 || neuron >= blocks_.size() || count <= 0) {
+		return 0;
+	}
+
+	const std::vector<int>& blocks = blocks_[neuron];
+
+	// last block starting at or before bin
+	int k = (int)(std::upper_bound(blocks.begin(), blocks.end(), bin, [this](const int b, const int position) {
+		return b < index_[position].first_;
+	}) - blocks.begin()) - 1;
+	k = std::max(k, 0);
+
+	std::vector<int32_t> decoded(block_);
+	size_t read = 0;
+
+	for (; k < blocks.size(); k++) {
+		const Block& block = index_[blocks[k]];
+
+		if (block.first_ >= bin + count) {
+			break;
+		}
+		if (block.first_ + block.count_ <= bin) {
+			continue;
+		}
+
+		if (decoded.size() < block.count_) {
+			decoded.resize(block.count_);
+		}
+		Decode(block, decoded.data());
+
+		const int begin = std::max(bin, block.first_);
+		const int end = std::min(bin + count, block.first_ + block.count_);
+
+		for (int t = begin; t < end; t++) {
+			samples[t - bin] = Dequantize(decoded[t - block.first_]);
+			read++;
+		}
+	}
+
+	return read;
+}
+
+__attribute__((visibility("default"))) const bool TraceArchive::Save(const std::string path) const noexcept
+{
+	/*
+		path = archive file
+		writes the parameters, the index and the encoded blocks, open blocks are not written
+	*/
+	FILE* file = fopen(path.c_str(), "wb");
+
+	if (!file) {
+		printf("%s: archive creation error\n", path.c_str());
+		return false;
+	}
+
+	const int32_t parameters[2] = {bits_, block_};
+	const double range[2] = {min_, max_};
+	const uint64_t sizes[2] = {index_.size(), data_.size()};
+
+	bool ok = fwrite(&s_magic_, sizeof(s_magic_), 1, file) == 1;
+	ok = ok && fwrite(range, sizeof(range), 1, file) == 1;
+	ok = ok && fwrite(parameters, sizeof(parameters), 1, file) == 1;
+	ok = ok && fwrite(sizes, sizeof(sizes), 1, file) == 1;
+	ok = ok && fwrite(index_.data(), sizeof(Block), index_.size(), file) == index_.size();
+	ok = ok && fwrite(data_.data(), 1, data_.size(), file) == data_.size();
+
+	fclose(file);
+
+	if (!ok) {
+		printf("%s: archive write error\n", path.c_str());
+	}
+
+	return ok;
+}
+
+__attribute__((visibility("default"))) const bool TraceArchive::Load(const std::string path) noexcept
+{
+	/*
+		path = archive file written by Save
+		replaces the contents of this archive, the traces can be read and extended afterwards
+	*/
+	FILE* file = fopen(path.c_str(), "rb");
+
+	if (!file) {
+		printf("%s: archive open error\n", path.c_str());
+		return false;
+	}
+
+	uint64_t magic = 0;
+	int32_t parameters[2];
+	double range[2];
+	uint64_t sizes[2];
+
+	bool ok = fread(&magic, sizeof(magic), 1, file) == 1 && magic == s_magic_;
+	ok = ok && fread(range, sizeof(range), 1, file) == 1;
+	ok = ok && fread(parameters, sizeof(parameters), 1, file) == 1;
+	ok = ok && fread(sizes, sizeof(sizes), 1, file) == 1;
+
+	std::vector<Block> index;
+	std::vector<uint8_t> data;
+
+	if (ok) {
+		index.resize(sizes[0]);
+		data.resize(sizes[1]);
+		ok = fread(index.data(), sizeof(Block), index.size(), file) == index.size();
+		ok = ok && fread(data.data(), 1, data.size(), file) == data.size();
+	}
+
+	fclose(file);
+
+	if (!ok) {
+		printf("%s: archive read error\n", path.c_str());
+		return false;
+	}
+
+	*this = TraceArchive(range[0], range[1], parameters[0], parameters[1]);
+	index_ = std::move(index);
+	data_ = std::move(data);
+
+	for (int i = 0; i < index_.size(); i++) {
+		const Block& block = index_[i];
+		Reserve(block.neuron_);
+		blocks_[block.neuron_].push_back(i);
+		samples_[block.neuron_] = std::max(samples_[block.neuron_], block.first_ + block.count_);
+	}
+
+	return true;
+}
+
+__attribute__((visibility("default"))) const int TraceArchive::GetNeurons() const noexcept
+{
+	/*
+		returns number of neurons with samples
+	*/
+	return (int)samples_.size();
+}
+
+__attribute__((visibility("default"))) const int TraceArchive::GetSamples(const int neuron) const noexcept
+{
+	/*
+		returns number of samples appended to the neuron
+	*/
+	return (neuron >= 0 && neuron < samples_.size()) ? samples_[neuron] : 0;
+}
+
+__attribute__((visibility("default"))) const int TraceArchive::GetBlock() const noexcept
+{
+	/*
+		Getter block_
+	*/
+	return block_;
+}
+
+__attribute__((visibility("default"))) const double TraceArchive::GetResolution() const noexcept
+{
+	/*
+		returns the quantization step [mV]
+	*/
+	return (max_ - min_) / ((1 << bits_) - 1);
+}
+
+__attribute__((visibility("default"))) const size_t TraceArchive::GetBytes() const noexcept
+{
+	/*
+		returns size of the encoded blocks and the index [bytes]
+	*/
+	return data_.size() + index_.size() * sizeof(Block);
+}
+
+__attribute__((visibility("default"))) const std::vector<TraceArchive::Block>& TraceArchive::GetIndex() const noexcept
+{
+	/*
+		Getter index_
+	*/
+	return index_;
+}
+
+const void TraceArchive::Reserve(const int neuron) noexcept
+{
+	/*
+		grows the per neuron state to hold the neuron
+	*/
+	if (neuron >= samples_.size()) {
+		blocks_.resize(neuron + 1);
+		open_.resize(neuron + 1);
+		samples_.resize(neuron + 1, 0);
+	}
+}
+
+const void TraceArchive::Encode(const int neuron) noexcept
+{
+	/*
+		encodes the open block of the neuron and adds it to the index
+		first sample as varint, then zigzag residuals of the linear prediction,
+		a zero residual is followed by the number of further zero residuals
+	*/
+	std::vector<int32_t>& open = open_[neuron];
+	const uint64_t offset = data_.size();
+
+	auto varint = [this](uint32_t x) {
+		while (x >= 0x80) {
+			data_.push_back((uint8_t)(x | 0x80));
+			x >>= 7;
+		}
+		data_.push_back((uint8_t)x);
+	};
+
+	varint((uint32_t)open[0]);
+
+	for (size_t i = 1; i < open.size(); i++) {
+		// previous sample, then linear extrapolation of the two previous samples
+		const int32_t prediction = (i == 1) ? open[0] : 2 * open[i - 1] - open[i - 2];
+		const int32_t residual = open[i] - prediction;
+
+		if (residual != 0) {
+			varint(((uint32_t)residual << 1) ^ (uint32_t)(residual >> 31));
+			continue;
+		}
+
+		// run of exact predictions
+		size_t run = 0;
+		while (i + run + 1 < open.size() && open[i + run + 1] == 2 * open[i + run] - open[i + run - 1]) {
+			run++;
+		}
+
+		varint(0);
+		varint((uint32_t)run);
+		i += run;
+	}
+
+	index_.push_back({neuron, samples_[neuron] - (int)open.size(), (int)open.size(), (uint32_t)(data_.size() - offset), offset});
+	blocks_[neuron].push_back((int)index_.size() - 1);
+
+	open.clear();
+}
+
+const void TraceArchive::Decode(const Block& block, int32_t* samples) const noexcept
+{
+	/*
+		block = index entry
+		samples = output array of block.count_ quantized samples
+	*/
+	const uint8_t* data = data_.data() + block.offset_;
+	size_t position = 0;
+
+	auto varint = [&]() {
+		uint32_t x = 0;
+		for (int shift = 0; position < block.bytes_; shift += 7) {
+			const uint8_t byte = data[position++];
+			x |= (uint32_t)(byte & 0x7f) << shift;
+			if (!(byte & 0x80)) {
+				break;
+			}
+		}
+		return x;
+	};
+
+	samples[0] = (int32_t)varint();
+
+	for (int i = 1; i < block.count_; i++) {
+		const int32_t prediction = (i == 1) ? samples[0] : 2 * samples[i - 1] - samples[i - 2];
+		const uint32_t zigzag = varint();
+
+		samples[i] = prediction + (int32_t)((zigzag >> 1) ^ -(zigzag & 1));
+
+		if (zigzag != 0) {
+			continue;
+		}
+
+		// run of exact predictions
+		const uint32_t run = varint();
+		for (uint32_t k = 0; k < run && i + 1 < block.count_; k++) {
+			i++;
+			samples[i] = 2 * samples[i - 1] - samples[i - 2];
+		}
+	}
+}
+
+inline const int32_t TraceArchive::Quantize(const double sample) const noexcept
+{
+	/*
+		returns the nearest level of the sample, clamped to the range
+	*/
+	const double level = std::nearbyint((sample - min_) / (max_ - min_) * ((1 << bits_) - 1));
+	return (int32_t)std::clamp(level, 0.0, (double)((1 << bits_) - 1));
+}
+
+inline const double TraceArchive::Dequantize(const int32_t sample) const noexcept
+{
+	/*
+		returns the membrane potential of a level [mV]
+	*/
+	return min_ + sample * (max_ - min_) / ((1 << bits_) - 1);
+}
@@ -0,0 +1,89 @@
+//
+//  TraceArchive.h
+//  NeuronalNetwork
+//
+//  Created by Nicolas Fricker on 04/10/20.
+//  Copyright © 2020 Nicolas Fricker. All rights reserved.
+//
+
+#ifndef TraceArchive_
+#define TraceArchive_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#pragma GCC visibility push(hidden)
+
+class TraceArchive
+{
+	/*
+		Compressed store of membrane potential traces
+		samples are quantized to bits over [min, max], predicted linearly from the two previous samples
+		and the zigzag residuals written as varints, runs of exact predictions collapse to a count
+		every neuron is cut into blocks of block samples, an index of (neuron, first bin) gives random access
+	*/
+public:
+	struct Block
+	{
+		// neuron index
+		int neuron_;
+		// bin of the first sample
+		int first_;
+		// number of samples
+		int count_;
+		// size of the encoded block [bytes]
+		uint32_t bytes_;
+		// position of the encoded block in the data
+		uint64_t offset_;
+	};
+
+private:
+	// quantization range [mV] and resolution
+	double min_ = -90.0;
+	double max_ = 60.0;
+	int bits_ = 16;
+	// samples per block
+	int block_ = 1024;
+
+	// encoded blocks
+	std::vector<uint8_t> data_;
+	// blocks in the order they were encoded
+	std::vector<Block> index_;
+	// positions in index_ of the blocks of every neuron, in time order
+	std::vector<std::vector<int>> blocks_;
+	// quantized samples of the open block of every neuron
+	std::vector<std::vector<int32_t>> open_;
+	// samples appended to every neuron
+	std::vector<int> samples_;
+
+	inline constexpr static const uint64_t s_magic_ = 0x4e4e545241434531ULL;
+
+public:
+	TraceArchive(const double min = -90.0, const double max = 60.0, const int bits = 16, const int block = 1024);
+
+	const void Append(const int neuron, const double* samples, const size_t count) noexcept;
+	const void Flush() noexcept;
+	const size_t Read(const int neuron, const int bin, const int count, double* samples) const noexcept;
+
+	const bool Save(const std::string path) const noexcept;
+	const bool Load(const std::string path) noexcept;
+
+	const int GetNeurons() const noexcept;
+	const int GetSamples(const int neuron) const noexcept;
+	const int GetBlock() const noexcept;
+	const double GetResolution() const noexcept;
+	const size_t GetBytes() const noexcept;
+	const std::vector<Block>& GetIndex() const noexcept;
+
+private:
+	const void Reserve(const int neuron) noexcept;
+	const void Encode(const int neuron) noexcept;
+	const void Decode(const Block& block, int32_t* samples) const noexcept;
+	const int32_t Quantize(const double sample) const noexcept;
+	const double Dequantize(const int32_t sample) const noexcept;
+};
+
+#pragma GCC visibility pop
+#endif /* TraceArchive_ */
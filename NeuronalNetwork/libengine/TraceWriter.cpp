@@ -0,0 +1,403 @@
+//
+//  TraceWriter.cpp
+//  NeuronalNetwork
+//
+//  Created by Nicolas Fricker on 04/10/20.
+//  Copyright © 2020 Nicolas Fricker. All rights reserved.
+//
+
+#include "TraceWriter.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+__attribute__((visibility("default"))) TraceWriter::TraceWriter(const std::string path, const size_t block, const int blocks): full_(std::max(blocks, 2)), free_(std::max(blocks, 2))
+{
+	/*
+		path = output file, truncated
+		block = size of a staging block [bytes], the size of every write
+		blocks = number of staging blocks, at least 2 so that one is filled while another is written
+	*/
+	block_ = std::max(block, sizeof(Record) + 64 * sizeof(double));
+
+	fd_ = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+	if (fd_ < 0) {
+		printf("%s: trace file creation error\n", path.c_str());
+		return;
+	}
+
+	for (int i = 0; i < std::max(blocks, 2); i++) {
+		blocks_.push_back(new Block());
+		blocks_.back()->data_.resize(block_);
+		free_.Push(blocks_.back());
+	}
+
+	if (pthread_create(&thread_, NULL, &TraceWriter::Launch, this) != 0) {
+		printf("%s: writer thread creation error\n", path.c_str());
+		close(fd_);
+		fd_ = -1;
+		return;
+	}
+
+	started_ = true;
+}
+
+__attribute__((visibility("default"))) TraceWriter::~TraceWriter()
+{
+	/*
+		Deconstructor
+		writes the staged samples and joins the writer thread
+	*/
+	Close();
+
+	for (int i = 0; i < blocks_.size(); i++) {
+		delete blocks_[i];
+	}
+
+	pthread_cond_destroy(&full_c_);
+	pthread_cond_destroy(&free_c_);
+	pthread_mutex_destroy(&wait_m_);
+}
+
+__attribute__((visibility("default"))) const bool TraceWriter::Valid() const noexcept
+{
+	/*
+		returns true if the file is open and the writer thread runs
+	*/
+	return fd_ >= 0 && started_;
+}
+
+__attribute__((visibility("default"))) const void TraceWriter::Write(const int neuron, const int first, const double* samples, const size_t count) noexcept
+{
+	/*
+		neuron = neuron id
+		first = bin of the first sample
+		samples = membrane potentials [mV]
+		count = number of samples
+		copies the samples into the staging block, full blocks are handed to the writer, never writes itself
+		not called while records opened by Reserve are waiting for Commit
+	*/
+	if (!Valid() || a_closed_.load(std::memory_order_acquire)) {
+		return;
+	}
+
+	size_t written = 0;
+
+	while (written < count) {
+		if (!staging_) {
+			staging_ = Acquire();
+		}
+
+		// samples fitting behind one more record
+		const size_t room = (block_ - staging_->size_ > sizeof(Record)) ? (block_ - staging_->size_ - sizeof(Record)) / sizeof(double) : 0;
+
+		if (room == 0) {
+			Submit();
+			continue;
+		}
+
+		const size_t n = std::min(room, count - written);
+		const Record record = {neuron, (int32_t)(first + written), (int32_t)n};
+
+		memcpy(&staging_->data_[staging_->size_], &record, sizeof(Record));
+		memcpy(&staging_->data_[staging_->size_ + sizeof(Record)], samples + written, n * sizeof(double));
+
+		staging_->size_ += sizeof(Record) + n * sizeof(double);
+		written += n;
+	}
+}
+
+__attribute__((visibility("default"))) char* TraceWriter::Reserve(const int neuron, const int first, const size_t count) noexcept
+{
+	/*
+		neuron = neuron id
+		first = bin of the first sample
+		count = maximum number of samples
+		opens a record of count samples in the staging block, the caller stores the samples in place
+		until Commit, the samples follow a 12 byte record and are not aligned
+		returns nullptr if the records already open leave no room in the block, the block holding open
+		records is not handed off, the samples are then given to Write after the commit
+	*/
+	const size_t bytes = sizeof(Record) + count * sizeof(double);
+
+	if (!Valid() || a_closed_.load(std::memory_order_acquire) || count == 0 || bytes > block_) {
+		return nullptr;
+	}
+
+	if (!staging_) {
+		staging_ = Acquire();
+	}
+
+	if (block_ - staging_->size_ < bytes) {
+		if (open_ >= 0) {
+			return nullptr;
+		}
+		Submit();
+		staging_ = Acquire();
+	}
+
+	if (open_ < 0) {
+		open_ = (long)staging_->size_;
+	}
+
+	const Record record = {neuron, first, (int32_t)count};
+	memcpy(&staging_->data_[staging_->size_], &record, sizeof(Record));
+
+	char* samples = &staging_->data_[staging_->size_ + sizeof(Record)];
+	staging_->size_ += bytes;
+
+	return samples;
+}
+
+__attribute__((visibility("default"))) const void TraceWriter::Commit(const size_t count) noexcept
+{
+	/*
+		count = number of samples stored into every open record
+		closes the records opened since the last commit, records shorter than reserved are moved together
+		and empty records are dropped, so that the file stays a sequence of records
+	*/
+	if (open_ < 0 || !staging_) {
+		open_ = -1;
+		return;
+	}
+
+	char* data = staging_->data_.data();
+	size_t source = open_;
+	size_t target = open_;
+
+	while (source < staging_->size_) {
+		Record record;
+		memcpy(&record, data + source, sizeof(Record));
+
+		const size_t reserved = record.count_;
+		const size_t n = std::min(count, reserved);
+
+		if (n > 0) {
+			record.count_ = (int32_t)n;
+			memcpy(data + target, &record, sizeof(Record));
+			memmove(data + target + sizeof(Record), data + source + sizeof(Record), n * sizeof(double));
+			target += sizeof(Record) + n * sizeof(double);
+		}
+
+		source += sizeof(Record) + reserved * sizeof(double);
+	}
+
+	staging_->size_ = target;
+	open_ = -1;
+}
+
+__attribute__((visibility("default"))) const void TraceWriter::Flush() noexcept
+{
+	/*
+		hands off the partial staging block and waits until every handed off block is written
+	*/
+	if (!Valid()) {
+		return;
+	}
+
+	Submit();
+
+	pthread_mutex_lock(&wait_m_);
+	while (a_written_.load(std::memory_order_acquire) < submitted_) {
+		pthread_cond_wait(&free_c_, &wait_m_);
+	}
+	pthread_mutex_unlock(&wait_m_);
+}
+
+__attribute__((visibility("default"))) const void TraceWriter::Close() noexcept
+{
+	/*
+		writes the staged samples, stops the writer thread and closes the file
+	*/
+	if (!Valid()) {
+		return;
+	}
+
+	Flush();
+
+	pthread_mutex_lock(&wait_m_);
+	a_closed_.store(true, std::memory_order_release);
+	pthread_cond_signal(&full_c_);
+	pthread_mutex_unlock(&wait_m_);
+
+	pthread_join(thread_, NULL);
+	started_ = false;
+
+	close(fd_);
+	fd_ = -1;
+}
+
+__attribute__((visibility("default"))) const size_t TraceWriter::GetBytes() const noexcept
+{
+	/*
+		returns number of bytes written to the file
+	*/
+	return a_bytes_.load(std::memory_order_acquire);
+}
+
+__attribute__((visibility("default"))) const size_t TraceWriter::GetStalls() const noexcept
+{
+	/*
+		returns number of hand-offs that waited for a free block, the writer is then slower than the simulation
+	*/
+	return stalls_;
+}
+
+__attribute__((visibility("default"))) const bool TraceWriter::Failed() const noexcept
+{
+	/*
+		returns true if a write of the writer thread failed
+	*/
+	return a_failed_.load(std::memory_order_acquire);
+}
+
+TraceWriter::Block* TraceWriter::Acquire() noexcept
+{
+	/*
+		returns an empty block, waits for the writer if all blocks are in flight
+	*/
+	Block* block = free_.Pop();
+
+	if (!block) {
+		stalls_++;
+
+		pthread_mutex_lock(&wait_m_);
+		while (!(block = free_.Pop())) {
+			pthread_cond_wait(&free_c_, &wait_m_);
+		}
+		pthread_mutex_unlock(&wait_m_);
+	}
+
+	block->size_ = 0;
+	return block;
+}
+
+const void TraceWriter::Submit() noexcept
+{
+	/*
+		hands the staging block to the writer
+	*/
+	if (!staging_) {
+		return;
+	}
+
+	if (staging_->size_ == 0) {
+		free_.Push(staging_);
+		staging_ = nullptr;
+		return;
+	}
+
+	// the ring holds every block, a push can not fail
+	full_.Push(staging_);
+	submitted_++;
+	staging_ = nullptr;
+
+	pthread_mutex_lock(&wait_m_);
+	pthread_cond_signal(&full_c_);
+	pthread_mutex_unlock(&wait_m_);
+}
+
+void* TraceWriter::Launch(void* writer) noexcept
+{
+	/*
+		writer thread, writes the full blocks in order and returns them for reuse
+	*/
+	TraceWriter* self = reinterpret_cast<TraceWriter*>(writer);
+
+	while (true) {
+		Block* block = self->full_.Pop();
+
+		if (!block) {
+			// sleeps until a block is handed off or the writer is closed
+			pthread_mutex_lock(&self->wait_m_);
+			while (self->full_.Empty() && !self->a_closed_.load(std::memory_order_acquire)) {
+				pthread_cond_wait(&self->full_c_, &self->wait_m_);
+			}
+			const bool done = self->full_.Empty();
+			pthread_mutex_unlock(&self->wait_m_);
+
+			if (done) {
+				break;
+			}
+			continue;
+		}
+
+		size_t offset = 0;
+
+		while (offset < block->size_) {
+			const ssize_t bytes = write(self->fd_, block->data_.data() + offset, block->size_ - offset);
+			if (bytes <= 0) {
+				self->a_failed_.store(true, std::memory_order_release);
+				break;
+			}
+			offset += bytes;
+		}
+
+		self->a_bytes_.fetch_add(offset, std::memory_order_acq_rel);
+		self->free_.Push(block);
+
+		pthread_mutex_lock(&self->wait_m_);
+		self->a_written_.fetch_add(1, std::memory_order_acq_rel);
+		pthread_cond_broadcast(&self->free_c_);
+		pthread_mutex_unlock(&self->wait_m_);
+	}
+
+	return NULL;
+}
+
+TraceWriter::Ring::Ring(const size_t capacity)
+{
+	/*
+		capacity = number of blocks held, rounded up to a power of two
+	*/
+	size_t size = 1;
+	while (size < capacity) {
+		size <<= 1;
+	}
+	slots_.assign(size, nullptr);
+}
+
+const bool TraceWriter::Ring::Push(Block* block) noexcept
+{
+	/*
+		producer side, returns false if the ring is full
+	*/
+	const size_t head = a_head_.load(std::memory_order_relaxed);
+
+	if (head - a_tail_.load(std::memory_order_acquire) == slots_.size()) {
+		return false;
+	}
+
+	slots_[head & (slots_.size() - 1)] = block;
+	a_head_.store(head + 1, std::memory_order_release);
+	return true;
+}
+
+TraceWriter::Block* TraceWriter::Ring::Pop() noexcept
+{
+	/*
+		consumer side, returns nullptr if the ring is empty
+	*/
+	const size_t tail = a_tail_.load(std::memory_order_relaxed);
+
+	if (tail == a_head_.load(std::memory_order_acquire)) {
+		return nullptr;
+	}
+
+	Block* block = slots_[tail & (slots_.size() - 1)];
+	a_tail_.store(tail + 1, std::memory_order_release);
+	return block;
+}
+
+const bool TraceWriter::Ring::Empty() const noexcept
+{
+	/*
+		consumer side, returns true if no block is waiting
+	*/
+	return a_tail_.load(std::memory_order_relaxed) == a_head_.load(std::memory_order_acquire);
+}
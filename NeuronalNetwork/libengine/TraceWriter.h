@@ -0,0 +1,130 @@
+//
+//  TraceWriter.h
+//  NeuronalNetwork
+//
+//  Created by Nicolas Fricker on 04/10/20.
+//  Copyright © 2020 Nicolas Fricker. All rights reserved.
+//
+
+#ifndef TraceWriter_
+#define TraceWriter_
+
+#include <pthread.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#pragma GCC visibility push(hidden)
+
+class TraceWriter
+{
+	/*
+		Writes recorded membrane potentials to a file from a dedicated thread
+		the simulation records runs of samples into fixed size staging blocks, either copied by Write
+		or in place into records opened by Reserve and closed by Commit, and hands full blocks
+		to the writer through a lock-free single producer, single consumer ring, the writer returns them
+		through a second ring once written, every block is one large sequential write
+		both threads sleep on condition variables while they wait for each other
+		file: records of (neuron id, first bin, count) as int32 followed by count samples [mV]
+	*/
+public:
+	struct Record
+	{
+		// neuron id
+		int32_t neuron_;
+		// bin of the first sample
+		int32_t first_;
+		// number of samples
+		int32_t count_;
+	};
+
+private:
+	struct Block
+	{
+		// records and samples
+		std::vector<char> data_;
+		// bytes in use
+		size_t size_ = 0;
+	};
+
+	class Ring
+	{
+		/*
+			lock-free ring of block pointers, one thread pushes and one thread pops
+		*/
+		std::vector<Block*> slots_;
+		std::atomic<size_t> a_head_{0};
+		std::atomic<size_t> a_tail_{0};
+
+	public:
+		Ring(const size_t capacity = 0);
+
+		const bool Push(Block* block) noexcept;
+		Block* Pop() noexcept;
+		const bool Empty() const noexcept;
+	};
+
+	// output file descriptor, -1 if the file could not be created
+	int fd_ = -1;
+	// size of a staging block [bytes]
+	size_t block_ = 1 << 20;
+
+	// staging blocks, owned
+	std::vector<Block*> blocks_;
+	// block being filled by the simulation, nullptr until the first sample
+	Block* staging_ = nullptr;
+	// offset of the first record opened by Reserve and not yet committed, -1 without
+	long open_ = -1;
+	// full blocks waiting for the writer and written blocks waiting for reuse
+	Ring full_;
+	Ring free_;
+
+	// writer thread
+	pthread_t thread_;
+	bool started_ = false;
+	// no more blocks are handed off
+	std::atomic<bool> a_closed_{false};
+	// the writer sleeps on full_c_ until a block is handed off, the simulation on free_c_ until one is written
+	pthread_mutex_t wait_m_ = PTHREAD_MUTEX_INITIALIZER;
+	pthread_cond_t full_c_ = PTHREAD_COND_INITIALIZER;
+	pthread_cond_t free_c_ = PTHREAD_COND_INITIALIZER;
+
+	// blocks handed to the writer and blocks written
+	size_t submitted_ = 0;
+	std::atomic<size_t> a_written_{0};
+	// bytes written to the file
+	std::atomic<size_t> a_bytes_{0};
+	// hand-offs that found no free block and waited for the writer
+	size_t stalls_ = 0;
+	// write error of the writer thread
+	std::atomic<bool> a_failed_{false};
+
+public:
+	TraceWriter(const std::string path, const size_t block = 1 << 20, const int blocks = 4);
+	~TraceWriter();
+
+	TraceWriter(const TraceWriter& other) = delete;
+	TraceWriter& operator=(const TraceWriter& other) = delete;
+
+	const bool Valid() const noexcept;
+	const void Write(const int neuron, const int first, const double* samples, const size_t count) noexcept;
+	char* Reserve(const int neuron, const int first, const size_t count) noexcept;
+	const void Commit(const size_t count) noexcept;
+	const void Flush() noexcept;
+	const void Close() noexcept;
+
+	const size_t GetBytes() const noexcept;
+	const size_t GetStalls() const noexcept;
+	const bool Failed() const noexcept;
+
+private:
+	Block* Acquire() noexcept;
+	const void Submit() noexcept;
+	static void* Launch(void* writer) noexcept;
+};
+
+#pragma GCC visibility pop
+#endif /* TraceWriter_ */